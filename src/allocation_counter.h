@@ -0,0 +1,41 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ALLOCATION_COUNTER_H_
+#define _ALLOCATION_COUNTER_H_
+
+// Headers
+#include <cstdint>
+
+/**
+ * Counts heap allocations done through operator new.
+ * Only compiled in with ENABLE_ALLOCATION_COUNTER, the counter is shown
+ * next to the FPS to measure the heap traffic per frame.
+ */
+namespace AllocationCounter {
+	/**
+	 * @return whether allocations are counted.
+	 */
+	bool IsEnabled();
+
+	/**
+	 * @return number of allocations since program start, 0 when disabled.
+	 */
+	uint64_t GetCount();
+}
+
+#endif
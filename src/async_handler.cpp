@@ -24,6 +24,7 @@
 #endif
 
 #include "async_handler.h"
+#include "cache.h"
 #include "filefinder.h"
 #include "memory_management.h"
 #include "output.h"
@@ -31,6 +32,7 @@
 #include "main_data.h"
 #include "picojson.h"
 #include <fstream>
+#include "thread_pool.h"
 #include "utils.h"
 
 namespace {
@@ -101,6 +103,10 @@ FileRequestAsync* AsyncHandler::RequestFile(const std::string& file_name) {
 	return RequestFile(".", file_name);
 }
 
+void AsyncHandler::Update() {
+	ThreadPool::Update();
+}
+
 bool AsyncHandler::IsImportantFilePending() {
 	std::map<std::string, FileRequestAsync>::iterator it;
 
@@ -193,6 +199,35 @@ void FileRequestAsync::Start() {
 #  ifdef EM_GAME_URL
 #    warning EM_GAME_URL set and not an Emscripten build!
 #  endif
+#  ifdef SUPPORT_THREADS
+	// Decode images on a worker, the listeners run when it finished
+	std::function<BitmapRef()> decode = Cache::PrepareDecode(directory, file);
+	if (decode) {
+		std::shared_ptr<BitmapRef> bitmap = std::make_shared<BitmapRef>();
+		std::string request_directory = directory;
+		std::string request_file = file;
+		std::string request_path = path;
+
+		ThreadPool::Submit(
+			[decode, bitmap]() {
+				*bitmap = decode();
+			},
+			[request_directory, request_file, request_path, bitmap]() {
+				// Unsupported images are reported when Cache loads them
+				Cache::AddDecoded(request_directory, request_file, *bitmap);
+
+				FileRequestAsync* request = GetRequest(request_path);
+				if (request) {
+					request->DownloadDone(true);
+				}
+
+				// Not loaded by the listeners, keep it within the budget
+				Cache::ReleaseDecoded(request_directory, request_file);
+			});
+		return;
+	}
+#  endif
+
 	// add comment for fake download testing
 	DownloadDone(true);
 #endif
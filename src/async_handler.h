@@ -29,6 +29,7 @@ struct FileRequestResult;
 /**
  * AsyncHandler supports asynchronous file requests for platforms that don't
  * support synchronous IO (e.g. Emscripten).
+ * On platforms with threads images are decoded on worker threads.
  */
 namespace AsyncHandler {
 	/**
@@ -62,6 +63,12 @@ namespace AsyncHandler {
 	 */
 	FileRequestAsync* RequestFile(const std::string& file_name);
 
+	/**
+	 * Finishes requests whose images were decoded in the background.
+	 * Called once per frame.
+	 */
+	void Update();
+
 	/**
 	 * Checks if any file with important-flag hasn't finished downloading yet.
 	 *
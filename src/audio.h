@@ -102,6 +102,14 @@ struct AudioInterface {
 	 * Stops the currently playing sound effect.
 	 */
 	virtual void SE_Stop() = 0;
+
+	/**
+	 * Decodes a sound effect ahead of time, so the first SE_Play of it
+	 * does not stall. Backends without a sound effect cache ignore it.
+	 *
+	 * @param file file to decode.
+	 */
+	virtual void SE_Preload(std::string const& /* file */) {}
 };
 
 struct EmptyAudio : public AudioInterface {
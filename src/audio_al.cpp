@@ -19,6 +19,7 @@
 
 #ifdef HAVE_OPENAL
 
+#include <algorithm>
 #include <array>
 #include <deque>
 #include <cassert>
@@ -446,6 +447,65 @@ private:
 	std::vector<int16_t> data_;
 };
 
+struct ALAudio::sound_data {
+	static std::shared_ptr<sound_data> create(std::string const &filename) {
+		SF_INFO info;
+		std::shared_ptr<SNDFILE> f(sf_open(filename.c_str(), SFM_READ, &info), sf_close);
+		if (!f || info.frames <= 0 || (info.channels != 1 && info.channels != 2)) {
+			return std::shared_ptr<sound_data>();
+		}
+
+		std::shared_ptr<sound_data> ret = std::make_shared<sound_data>();
+		ret->format_ = info.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+		ret->channels_ = info.channels;
+		ret->samplerate_ = info.samplerate;
+		ret->data_.resize(info.channels * info.frames);
+		sf_count_t const read_size = sf_readf_short(f.get(), &ret->data_.front(), info.frames);
+		if (read_size <= 0) {
+			return std::shared_ptr<sound_data>();
+		}
+		ret->data_.resize(info.channels * read_size);
+		return ret;
+	}
+
+	size_t size() const {
+		return sizeof(int16_t) * data_.size();
+	}
+
+	ALenum format_;
+	int channels_;
+	int samplerate_;
+	std::vector<int16_t> data_;
+};
+
+struct ALAudio::pcm_loader : public ALAudio::buffer_loader {
+	pcm_loader(std::shared_ptr<sound_data> const &data) : data_(data), pos_(0) {
+		assert(data);
+	}
+
+	size_t load_buffer(ALuint buf) {
+		if (is_end()) {
+			loop_count_++;
+			pos_ = 0;
+		}
+
+		size_t const count = std::min<size_t>(
+			data_->channels_ * data_->samplerate_ * SECOND_PER_BUFFER, data_->data_.size() - pos_);
+		alBufferData(buf, data_->format_, &data_->data_[pos_], sizeof(int16_t) * count,
+		             data_->samplerate_);
+		pos_ += count;
+		return count / data_->channels_;
+	}
+
+	bool is_end() const {
+		return pos_ >= data_->data_.size();
+	}
+
+private:
+	std::shared_ptr<sound_data> const data_;
+	size_t pos_;
+};
+
 std::shared_ptr<ALAudio::buffer_loader>
 ALAudio::create_loader(source &src, std::string const &filename) const {
 	SET_CONTEXT(ctx_);
@@ -464,8 +524,27 @@ ALAudio::getMusic(source &src, std::string const &file) const {
 }
 
 std::shared_ptr<ALAudio::buffer_loader>
-ALAudio::getSound(source &src, std::string const &file) const {
-	return create_loader(src, FileFinder::FindSound(file));
+ALAudio::getSound(source &src, std::string const &file) {
+	std::string const path = FileFinder::FindSound(file);
+
+	// Sound effects are played from memory, MIDI is synthesized
+	std::shared_ptr<sound_data> const snd = loadSound(path);
+	return snd ? std::make_shared<pcm_loader>(snd) : create_loader(src, path);
+}
+
+std::shared_ptr<ALAudio::sound_data> ALAudio::loadSound(std::string const &path) {
+	if (path.empty()) {
+		return std::shared_ptr<sound_data>();
+	}
+
+	std::shared_ptr<sound_data> snd = se_cache_.Get(path);
+	if (!snd) {
+		snd = sound_data::create(path);
+		if (snd) {
+			se_cache_.Add(path, snd, snd->size());
+		}
+	}
+	return snd;
 }
 
 void ALAudio::Update() {
@@ -580,4 +659,8 @@ void ALAudio::SE_Stop() {
 	se_src_.clear();
 }
 
+void ALAudio::SE_Preload(std::string const &file) {
+	loadSound(FileFinder::FindSound(file));
+}
+
 #endif
@@ -29,6 +29,7 @@
 
 #include "system.h"
 #include "audio.h"
+#include "audio_se_cache.h"
 
 #include <map>
 #include <vector>
@@ -47,6 +48,7 @@ struct ALAudio : public AudioInterface {
 	void BGM_Pitch(int) override;
 	void SE_Play(std::string const &, int, int) override;
 	void SE_Stop() override;
+	void SE_Preload(std::string const &) override;
 	void Update() override;
 
 	static char const WAVE_OUTPUT_DEVICE[];
@@ -57,12 +59,15 @@ private:
 	struct buffer_loader;
 	struct sndfile_loader;
 	struct midi_loader;
+	struct sound_data;
+	struct pcm_loader;
 
 	std::shared_ptr<source> create_source(bool loop) const;
 	std::shared_ptr<buffer_loader> create_loader(source &src, std::string const &file) const;
 
 	std::shared_ptr<buffer_loader> getMusic(source &src, std::string const &file) const;
-	std::shared_ptr<buffer_loader> getSound(source &src, std::string const &file) const;
+	std::shared_ptr<buffer_loader> getSound(source &src, std::string const &file);
+	std::shared_ptr<sound_data> loadSound(std::string const &path);
 
 	std::shared_ptr<ALCdevice> dev_;
 	std::shared_ptr<ALCcontext> ctx_;
@@ -71,6 +76,9 @@ private:
 
 	typedef std::vector<std::shared_ptr<source> > source_list;
 	source_list se_src_;
+
+	/** Decoded sound effects by resolved path. */
+	AudioSeCache<sound_data> se_cache_;
 };  // struct ALAudio
 
 #endif  // _AUDIO_AL_H_
@@ -15,9 +15,11 @@
  * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstring>
+#include <functional>
 
 #include "system.h"
 
@@ -55,50 +57,22 @@ namespace {
 		static std::vector<uint8_t> buffer;
 
 		SdlAudio* audio = static_cast<SdlAudio*>(udata);
+		AudioStream& bgm_stream = audio->GetStream();
 
-		SDL_AudioCVT& cvt = audio->GetAudioCVT();
-		int out_len = stream_size;
-		if (cvt.needed) {
-			// Calculate how many data is needed to fill the buffer after converting it
-			double d = out_len / cvt.rate_incr;
-			out_len = (int)std::ceil(d);
-			out_len += out_len & 1;
-		}
-
-		buffer.resize(out_len);
+		// Decoding happens ahead on the decoder thread, only mix here
+		buffer.resize(stream_size);
+		int len = bgm_stream.Read(buffer.data(), stream_size);
 
-		out_len = audio->GetDecoder()->Decode(buffer.data(), out_len);
-		if (out_len == -1) {
-			Output::Warning("Couldn't decode BGM.\n%s", audio->GetDecoder()->GetError().c_str());
+		if (bgm_stream.IsFinished()) {
 			Mix_HookMusic(nullptr, nullptr);
 			return;
 		}
 
-		if (audio->GetDecoder()->IsFinished()) {
-			Mix_HookMusic(nullptr, nullptr);
-		} else {
-			if (cvt.needed) {
-				static std::vector<uint8_t> cvt_buffer;
-				cvt_buffer.resize(out_len * cvt.len_mult);
-				cvt.buf = cvt_buffer.data();
-				cvt.len = out_len;
-				memcpy(cvt.buf, buffer.data(), out_len);
-				SDL_ConvertAudio(&cvt);
-			} else {
-				cvt.len_cvt = out_len;
-				cvt.buf = buffer.data();
-			}
-
-			if (cvt.len_cvt > stream_size) {
-				cvt.len_cvt = stream_size;
-			}
-
 #if SDL_MIXER_MAJOR_VERSION>1
-			SDL_MixAudioFormat(stream, reinterpret_cast<const Uint8*>(cvt.buf), MIX_DEFAULT_FORMAT, cvt.len_cvt, audio->GetDecoder()->GetVolume());
+		SDL_MixAudioFormat(stream, buffer.data(), MIX_DEFAULT_FORMAT, len, audio->GetMixVolume());
 #else
-			SDL_MixAudio(stream, reinterpret_cast<const Uint8*>(cvt.buf), cvt.len_cvt, audio->GetDecoder()->GetVolume());
+		SDL_MixAudio(stream, buffer.data(), len, audio->GetMixVolume());
 #endif
-		}
 	}
 
 	int format_to_sdl_format(AudioDecoder::Format format) {
@@ -150,7 +124,8 @@ namespace {
 
 SdlAudio::SdlAudio() :
 	bgm_volume(0),
-	bgs_playing(false)
+	bgs_playing(false),
+	bgm_mix_volume(0)
 {
 	if (!(SDL_WasInit(SDL_INIT_AUDIO) & SDL_INIT_AUDIO)) {
 		if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
@@ -219,6 +194,8 @@ SdlAudio::SdlAudio() :
 }
 
 SdlAudio::~SdlAudio() {
+	StopStream();
+	se_cache.Clear();
 	Mix_CloseAudio();
 }
 
@@ -260,6 +237,9 @@ void SdlAudio::BGM_Play(std::string const& file, int volume, int pitch, int fade
 		return;
 	}
 
+	// The decoder thread must not touch the decoder being replaced
+	StopStream();
+
 	audio_decoder = AudioDecoder::Create(filehandle, path);
 	if (audio_decoder) {
 		SetupAudioDecoder(filehandle, path, volume, pitch, fadein);
@@ -405,13 +385,103 @@ void SdlAudio::SetupAudioDecoder(FILE* handle, const std::string& file, int volu
 	
 	audio_decoder->SetFade(0, volume, fadein);
 	audio_decoder->SetPitch(pitch);
+	bgm_mix_volume = audio_decoder->GetVolume();
+
+	decoder_frame_size = AudioDecoder::GetSamplesizeForFormat(device_format) * device_channels;
+	// The low byte of SDL audio formats is the sample size in bits
+	int const frame_size = ((sdl_format & 0xFF) / 8) * audio_channels;
+	// The stream is stopped, the decoder thread does not touch the marks
+	bgm_marks.clear();
+	bgm_produced = 0;
+	bgm_stream.Start(std::bind(&SdlAudio::DecodeBGM, this, std::placeholders::_1, std::placeholders::_2),
+		audio_rate * frame_size, frame_size);
 
 	Mix_HookMusic(callback, this);
 }
 
+void SdlAudio::StopStream() {
+	Mix_HookMusic(nullptr, nullptr);
+
+	AudioStream::Stats stats = bgm_stream.GetStats();
+	if (stats.underruns > 0) {
+		Output::Debug("BGM stream: %d underruns, lowest fill %d of %d bytes",
+			stats.underruns, stats.min_fill, stats.target);
+	}
+
+	bgm_stream.Stop();
+}
+
+int SdlAudio::DecodeBGM(uint8_t* buffer, int size) {
+	// Amount of decoder output that converts to at most size bytes
+	int in_len = size;
+	if (cvt.needed) {
+		in_len = (int)(size / cvt.len_ratio);
+		in_len -= in_len % decoder_frame_size;
+		if (in_len <= 0) {
+			in_len = decoder_frame_size;
+		}
+	}
+
+	uint8_t* out = buffer;
+	if (cvt.needed) {
+		decode_buffer.resize(in_len * std::max(cvt.len_mult, 1));
+		out = decode_buffer.data();
+	}
+
+	int len = audio_decoder->Decode(out, in_len);
+	if (len == -1) {
+		Output::Warning("Couldn't decode BGM.\n%s", audio_decoder->GetError().c_str());
+		return -1;
+	}
+
+	if (audio_decoder->IsFinished()) {
+		return 0;
+	}
+
+	if (len == 0) {
+		// Nothing decoded this time, keep the stream going with silence
+		len = std::min(size, in_len);
+		memset(buffer, '\0', len);
+		bgm_produced += len;
+		return len;
+	}
+
+	if (cvt.needed) {
+		cvt.buf = decode_buffer.data();
+		cvt.len = len;
+		SDL_ConvertAudio(&cvt);
+		len = std::min(cvt.len_cvt, size);
+		memcpy(buffer, cvt.buf, len);
+	}
+
+	// Drop marks of played chunks, nobody may ask for the ticks
+	GetPlayedMark();
+
+	bgm_produced += len;
+	bgm_marks.push_back(StreamMark{bgm_produced, audio_decoder->GetTicks(), audio_decoder->GetLoopCount()});
+
+	return len;
+}
+
+SdlAudio::StreamMark SdlAudio::GetPlayedMark() {
+	size_t const played = bgm_stream.GetReadPosition();
+
+	while (bgm_marks.size() > 1 && bgm_marks[1].end <= played) {
+		bgm_marks.pop_front();
+	}
+
+	if (bgm_marks.empty() || bgm_marks.front().end > played) {
+		// Nothing played yet
+		return StreamMark{0, 0, 0};
+	}
+	return bgm_marks.front();
+}
+
 void SdlAudio::BGM_Pause() {
 	if (audio_decoder) {
+		AudioStream::Guard guard(bgm_stream);
 		audio_decoder->Pause();
+		bgm_stream.SetPaused(true);
 		return;
 	}
 
@@ -428,8 +498,10 @@ void SdlAudio::BGM_Pause() {
 
 void SdlAudio::BGM_Resume() {
 	if (audio_decoder) {
+		AudioStream::Guard guard(bgm_stream);
 		bgm_starttick = SDL_GetTicks();
 		audio_decoder->Resume();
+		bgm_stream.SetPaused(false);
 		return;
 	}
 
@@ -444,7 +516,7 @@ void SdlAudio::BGM_Resume() {
 }
 
 void SdlAudio::BGM_Stop() {
-	Mix_HookMusic(nullptr, nullptr);
+	StopStream();
 	audio_decoder.reset();
 
 #if SDL_MAJOR_VERSION>1
@@ -460,7 +532,8 @@ void SdlAudio::BGM_Stop() {
 
 bool SdlAudio::BGM_PlayedOnce() {
 	if (audio_decoder) {
-		return audio_decoder->GetLoopCount() > 0;
+		AudioStream::Guard guard(bgm_stream);
+		return GetPlayedMark().loop_count > 0;
 	}
 
 	return played_once;
@@ -468,7 +541,8 @@ bool SdlAudio::BGM_PlayedOnce() {
 
 unsigned SdlAudio::BGM_GetTicks() {
 	if (audio_decoder) {
-		return audio_decoder->GetTicks();
+		AudioStream::Guard guard(bgm_stream);
+		return GetPlayedMark().ticks;
 	}
 
 	// TODO: Implement properly. This is an approximation.
@@ -477,7 +551,9 @@ unsigned SdlAudio::BGM_GetTicks() {
 
 void SdlAudio::BGM_Volume(int volume) {
 	if (audio_decoder) {
+		AudioStream::Guard guard(bgm_stream);
 		audio_decoder->SetVolume(volume);
+		bgm_mix_volume = audio_decoder->GetVolume();
 		return;
 	}
 
@@ -495,6 +571,7 @@ void SdlAudio::BGM_Volume(int volume) {
 
 void SdlAudio::BGM_Pitch(int pitch) {
 	if (audio_decoder) {
+		AudioStream::Guard guard(bgm_stream);
 		audio_decoder->SetPitch(pitch);
 	}
 
@@ -503,6 +580,7 @@ void SdlAudio::BGM_Pitch(int pitch) {
 
 void SdlAudio::BGM_Fade(int fade) {
 	if (audio_decoder) {
+		AudioStream::Guard guard(bgm_stream);
 		bgm_starttick = DisplayUi->GetTicks();
 		audio_decoder->SetFade(audio_decoder->GetVolume(), 0, fade);
 		return;
@@ -587,15 +665,31 @@ void SdlAudio::BGS_Volume(int volume) {
 	Mix_Volume(BGS_CHANNEL_NUM, volume * MIX_MAX_VOLUME / 100);
 }
 
-void SdlAudio::SE_Play(std::string const& file, int volume, int /* pitch */) {
+std::shared_ptr<Mix_Chunk> SdlAudio::LoadSE(std::string const& file) {
 	std::string const path = FileFinder::FindSound(file);
 	if (path.empty()) {
 		Output::Debug("Sound not found: %s", file.c_str());
-		return;
+		return std::shared_ptr<Mix_Chunk>();
+	}
+
+	std::shared_ptr<Mix_Chunk> sound = se_cache.Get(path);
+	if (sound) {
+		return sound;
 	}
-	std::shared_ptr<Mix_Chunk> sound(Mix_LoadWAV(path.c_str()), &Mix_FreeChunk);
+
+	sound.reset(Mix_LoadWAV(path.c_str()), &Mix_FreeChunk);
 	if (!sound) {
 		Output::Warning("Couldn't load %s SE.\n%s", file.c_str(), Mix_GetError());
+		return sound;
+	}
+	se_cache.Add(path, sound, sound->alen);
+
+	return sound;
+}
+
+void SdlAudio::SE_Play(std::string const& file, int volume, int /* pitch */) {
+	std::shared_ptr<Mix_Chunk> sound = LoadSE(file);
+	if (!sound) {
 		return;
 	}
 	int channel = Mix_PlayChannel(-1, sound.get(), 0);
@@ -614,20 +708,26 @@ void SdlAudio::SE_Stop() {
 	sounds.clear();
 }
 
+void SdlAudio::SE_Preload(std::string const& file) {
+	LoadSE(file);
+}
+
 void SdlAudio::Update() {
 	if (audio_decoder && bgm_starttick > 0) {
+		AudioStream::Guard guard(bgm_stream);
 		int t = DisplayUi->GetTicks();
 		audio_decoder->Update(t - bgm_starttick);
+		bgm_mix_volume = audio_decoder->GetVolume();
 		bgm_starttick = t;
 	}
 }
 
-AudioDecoder* SdlAudio::GetDecoder() {
-	return audio_decoder.get();
+AudioStream& SdlAudio::GetStream() {
+	return bgm_stream;
 }
 
-SDL_AudioCVT& SdlAudio::GetAudioCVT() {
-	return cvt;
+int SdlAudio::GetMixVolume() const {
+	return bgm_mix_volume;
 }
 
 #endif
@@ -20,7 +20,11 @@
 
 #include "audio.h"
 #include "audio_decoder.h"
+#include "audio_se_cache.h"
+#include "audio_stream.h"
 
+#include <atomic>
+#include <deque>
 #include <map>
 
 #include <SDL.h>
@@ -47,14 +51,34 @@ struct SdlAudio : public AudioInterface {
 	void BGS_Volume(int);
 	void SE_Play(std::string const&, int, int) override;
 	void SE_Stop() override;
+	void SE_Preload(std::string const&) override;
 	void Update() override;
 
 	void BGM_OnPlayedOnce();
 
-	AudioDecoder* GetDecoder();
-	SDL_AudioCVT& GetAudioCVT();
+	AudioStream& GetStream();
+	int GetMixVolume() const;
 private:
 	void SetupAudioDecoder(FILE* handle, const std::string& filename, int volume, int pitch, int fadein);
+	void StopStream();
+	int DecodeBGM(uint8_t* buffer, int size);
+
+	/** Decoder state after a produced chunk. */
+	struct StreamMark {
+		/** Stream bytes produced up to the end of the chunk. */
+		size_t end;
+		int ticks;
+		int loop_count;
+	};
+
+	/**
+	 * The decoder runs ahead of the playback, this returns its state at
+	 * the end of the last chunk that was played. Needs a Guard.
+	 *
+	 * @return decoder state matching what is heard.
+	 */
+	StreamMark GetPlayedMark();
+	std::shared_ptr<Mix_Chunk> LoadSE(std::string const& file);
 
 	std::shared_ptr<Mix_Music> bgm;
 	int bgm_volume;
@@ -68,8 +92,21 @@ private:
 	typedef std::map<int, std::shared_ptr<Mix_Chunk> > sounds_type;
 	sounds_type sounds;
 
+	/** Decoded sound effects by resolved path. */
+	AudioSeCache<Mix_Chunk> se_cache;
+
 	std::unique_ptr<AudioDecoder> audio_decoder;
 	SDL_AudioCVT cvt;
+	std::vector<uint8_t> decode_buffer;
+	int decoder_frame_size = 1;
+
+	/** Decoded BGM, filled ahead by a decoder thread, read by the music hook. */
+	AudioStream bgm_stream;
+	/** Marks of the buffered chunks, the first one was played already. Guarded by bgm_stream. */
+	std::deque<StreamMark> bgm_marks;
+	size_t bgm_produced = 0;
+	/** Decoder volume for the music hook, updated on the main thread. */
+	std::atomic<int> bgm_mix_volume;
 }; // class SdlAudio
 
 #endif // _AUDIO_SDL_H_
@@ -0,0 +1,131 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_AUDIO_SE_CACHE_H_
+#define _EASYRPG_AUDIO_SE_CACHE_H_
+
+// Headers
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Keeps recently played sound effects decoded, so repeated effects
+ * (cursor moves, battle hits) are not read and decoded again.
+ * Least recently used entries are dropped when the byte budget is
+ * exceeded. Entries still in use by a channel stay alive through their
+ * shared_ptr until the channel releases them.
+ *
+ * @tparam T decoded sound type of the audio backend.
+ */
+template <typename T>
+class AudioSeCache {
+public:
+	/** Default byte budget: about 45 s of 16 bit 44.1 kHz stereo. */
+	static const size_t default_budget = 8 * 1024 * 1024;
+
+	/**
+	 * @param budget maximum amount of bytes kept.
+	 */
+	explicit AudioSeCache(size_t budget = default_budget) : budget(budget) {}
+
+	/**
+	 * Looks up a sound and marks it as recently used.
+	 *
+	 * @param path resolved sound file path.
+	 * @return the sound or nullptr when not cached.
+	 */
+	std::shared_ptr<T> Get(const std::string& path) {
+		auto it = index.find(path);
+		if (it == index.end()) {
+			return std::shared_ptr<T>();
+		}
+
+		lru.splice(lru.begin(), lru, it->second);
+		return it->second->sound;
+	}
+
+	/**
+	 * Adds a sound, evicting older ones when over budget.
+	 * Sounds larger than the whole budget are not kept.
+	 *
+	 * @param path resolved sound file path.
+	 * @param sound decoded sound.
+	 * @param size size of the sound in bytes.
+	 */
+	void Add(const std::string& path, std::shared_ptr<T> sound, size_t size) {
+		Remove(path);
+
+		if (!sound || size > budget) {
+			return;
+		}
+
+		lru.push_front(Entry { path, std::move(sound), size });
+		index[path] = lru.begin();
+		bytes += size;
+
+		while (bytes > budget) {
+			std::string oldest = lru.back().path;
+			Remove(oldest);
+		}
+	}
+
+	/**
+	 * Drops all sounds.
+	 */
+	void Clear() {
+		lru.clear();
+		index.clear();
+		bytes = 0;
+	}
+
+	/**
+	 * @return amount of bytes kept.
+	 */
+	size_t GetBytes() const {
+		return bytes;
+	}
+
+private:
+	struct Entry {
+		std::string path;
+		std::shared_ptr<T> sound;
+		size_t size;
+	};
+
+	void Remove(const std::string& path) {
+		auto it = index.find(path);
+		if (it == index.end()) {
+			return;
+		}
+
+		bytes -= it->second->size;
+		lru.erase(it->second);
+		index.erase(it);
+	}
+
+	/** Most recently used first. */
+	std::list<Entry> lru;
+	std::unordered_map<std::string, typename std::list<Entry>::iterator> index;
+	size_t budget;
+	size_t bytes = 0;
+};
+
+#endif
@@ -0,0 +1,237 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cstring>
+#include "audio_stream.h"
+
+namespace {
+	int buffer_ahead_ms = 200;
+
+	/** Amount of audio produced per call of the source. */
+	constexpr int chunk_ms = 20;
+}
+
+AudioStream::AudioStream() :
+	write_pos(0),
+	read_pos(0),
+	active(false),
+	paused(false),
+	primed(false),
+	ended(false),
+	error(false),
+	underruns(0),
+	min_fill(0) {
+}
+
+AudioStream::~AudioStream() {
+	Stop();
+
+#ifdef SUPPORT_THREADS
+	if (thread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wakeup.notify_one();
+		thread.join();
+	}
+#endif
+}
+
+void AudioStream::SetBufferAhead(int ms) {
+	buffer_ahead_ms = std::max(ms, chunk_ms);
+}
+
+void AudioStream::Start(Source new_source, int bytes_per_second, int new_frame_size) {
+	Stop();
+
+	int const chunk_size = std::max(bytes_per_second * chunk_ms / 1000 / new_frame_size, 1) * new_frame_size;
+	int const new_target = std::max(
+		static_cast<int>(static_cast<int64_t>(bytes_per_second) * buffer_ahead_ms / 1000 / new_frame_size) * new_frame_size,
+		chunk_size);
+
+	// Room for a full buffer plus the chunk being written
+	size_t ring_size = 1;
+	while (ring_size < static_cast<size_t>(new_target + chunk_size)) {
+		ring_size <<= 1;
+	}
+
+	{
+#ifdef SUPPORT_THREADS
+		std::lock_guard<std::mutex> lock(mutex);
+#endif
+		source = std::move(new_source);
+		frame_size = new_frame_size;
+		target = new_target;
+		chunk.resize(chunk_size);
+		ring.assign(ring_size, 0);
+		write_pos = 0;
+		read_pos = 0;
+		paused = false;
+		primed = false;
+		ended = false;
+		error = false;
+		underruns = 0;
+		min_fill = target;
+		active = true;
+	}
+
+#ifdef SUPPORT_THREADS
+	if (!thread.joinable()) {
+		thread = std::thread(&AudioStream::Run, this);
+	}
+	wakeup.notify_one();
+#endif
+}
+
+void AudioStream::Stop() {
+#ifdef SUPPORT_THREADS
+	std::lock_guard<std::mutex> lock(mutex);
+#endif
+	active = false;
+	source = nullptr;
+	write_pos = 0;
+	read_pos = 0;
+	primed = false;
+}
+
+void AudioStream::SetPaused(bool pause) {
+	paused = pause;
+
+#ifdef SUPPORT_THREADS
+	if (!pause) {
+		wakeup.notify_one();
+	}
+#endif
+}
+
+int AudioStream::GetFill() const {
+	return static_cast<int>(write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire));
+}
+
+bool AudioStream::Produce() {
+	if (!active || paused || ended) {
+		return false;
+	}
+
+	if (GetFill() >= target) {
+		primed = true;
+		return false;
+	}
+
+	int const size = source(chunk.data(), static_cast<int>(chunk.size()));
+	if (size <= 0) {
+		error = size < 0;
+		ended = true;
+		primed = true;
+		return false;
+	}
+
+	size_t const count = std::min(static_cast<size_t>(size), chunk.size());
+	size_t const mask = ring.size() - 1;
+	size_t const w = write_pos.load(std::memory_order_relaxed);
+	size_t const first = std::min(count, ring.size() - (w & mask));
+	memcpy(&ring[w & mask], chunk.data(), first);
+	memcpy(&ring[0], chunk.data() + first, count - first);
+	write_pos.store(w + count, std::memory_order_release);
+
+	return true;
+}
+
+int AudioStream::Read(uint8_t* buffer, int size) {
+#ifndef SUPPORT_THREADS
+	while (Produce()) {}
+#endif
+
+	if (!active || paused || !primed) {
+		return 0;
+	}
+
+	size_t const r = read_pos.load(std::memory_order_relaxed);
+	int const fill = static_cast<int>(write_pos.load(std::memory_order_acquire) - r);
+	if (fill < min_fill.load(std::memory_order_relaxed)) {
+		min_fill.store(fill, std::memory_order_relaxed);
+	}
+
+	int count = std::min(size, fill);
+	count -= count % frame_size;
+	if (count < size && !ended) {
+		underruns.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	size_t const mask = ring.size() - 1;
+	size_t const first = std::min(static_cast<size_t>(count), ring.size() - (r & mask));
+	memcpy(buffer, &ring[r & mask], first);
+	memcpy(buffer + first, &ring[0], count - first);
+	read_pos.store(r + count, std::memory_order_release);
+
+	return count;
+}
+
+bool AudioStream::IsFinished() const {
+	return ended && GetFill() == 0;
+}
+
+bool AudioStream::HasError() const {
+	return error;
+}
+
+AudioStream::Stats AudioStream::GetStats() const {
+	Stats stats;
+	stats.underruns = underruns;
+	stats.fill = GetFill();
+	stats.min_fill = min_fill;
+	stats.target = target;
+	return stats;
+}
+
+size_t AudioStream::GetReadPosition() const {
+	return read_pos.load(std::memory_order_acquire);
+}
+
+AudioStream::Guard::Guard(AudioStream& stream)
+#ifdef SUPPORT_THREADS
+	: lock(stream.mutex)
+#endif
+{
+#ifndef SUPPORT_THREADS
+	(void)stream;
+#endif
+}
+
+AudioStream::Guard::~Guard() {
+}
+
+#ifdef SUPPORT_THREADS
+void AudioStream::Run() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (!quit) {
+		if (Produce()) {
+			// Let the main thread change the source between chunks
+			lock.unlock();
+			std::this_thread::yield();
+			lock.lock();
+		} else {
+			// Full, paused or idle: a chunk plays meanwhile
+			wakeup.wait_for(lock, std::chrono::milliseconds(chunk_ms));
+		}
+	}
+}
+#endif
@@ -0,0 +1,189 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _AUDIO_STREAM_H_
+#define _AUDIO_STREAM_H_
+
+// Headers
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "system.h"
+
+#ifdef SUPPORT_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+/**
+ * Streams decoded audio from a producer to the audio callback.
+ * A decoder thread fills a single-producer/single-consumer ring buffer
+ * a configurable time ahead, so the audio callback only copies data
+ * and a slow decode does not become an audible underrun.
+ * Without thread support the data is produced inside Read.
+ */
+class AudioStream {
+public:
+	/**
+	 * Produces audio data.
+	 * Called on the decoder thread.
+	 *
+	 * @param buffer output buffer.
+	 * @param size maximum amount of bytes to produce, a multiple of
+	 *             the frame size.
+	 * @return bytes produced, 0 at the end of the stream, -1 on error.
+	 */
+	typedef std::function<int(uint8_t* buffer, int size)> Source;
+
+	struct Stats {
+		/** Reads that could not be served completely. */
+		int underruns;
+		/** Bytes currently buffered. */
+		int fill;
+		/** Lowest amount of bytes buffered before a read since Start. */
+		int min_fill;
+		/** Bytes buffered ahead when full. */
+		int target;
+	};
+
+	AudioStream();
+	~AudioStream();
+
+	/**
+	 * Sets how far ahead streams decode. Affects streams started later.
+	 *
+	 * @param ms buffered time in milliseconds.
+	 */
+	static void SetBufferAhead(int ms);
+
+	/**
+	 * Starts streaming from a new source.
+	 * The consumer must not Read until Start returned.
+	 *
+	 * @param source producer of the data.
+	 * @param bytes_per_second data rate of the produced data.
+	 * @param frame_size bytes per sample frame.
+	 */
+	void Start(Source source, int bytes_per_second, int frame_size);
+
+	/**
+	 * Stops streaming and drops the buffered data. When this returns
+	 * the source is not called anymore.
+	 * The consumer must not Read concurrently.
+	 */
+	void Stop();
+
+	/**
+	 * Pauses or resumes the stream. While paused nothing is read and
+	 * nothing is produced, buffered data is kept.
+	 *
+	 * @param paused whether to pause.
+	 */
+	void SetPaused(bool paused);
+
+	/**
+	 * Takes buffered data. Lock-free, safe to call from the audio
+	 * callback.
+	 *
+	 * @param buffer output buffer.
+	 * @param size bytes wanted.
+	 * @return bytes read, a multiple of the frame size.
+	 */
+	int Read(uint8_t* buffer, int size);
+
+	/**
+	 * @return whether the source ended (or failed) and all data was read.
+	 */
+	bool IsFinished() const;
+
+	/**
+	 * @return whether the source failed.
+	 */
+	bool HasError() const;
+
+	/**
+	 * @return underrun and fill level counters.
+	 */
+	Stats GetStats() const;
+
+	/**
+	 * @return bytes read since Start, the position being heard.
+	 */
+	size_t GetReadPosition() const;
+
+	/**
+	 * Keeps the source from being called while it is alive, e.g. while
+	 * the decoder behind the source is modified on the main thread.
+	 */
+	class Guard {
+	public:
+		explicit Guard(AudioStream& stream);
+		~Guard();
+	private:
+#ifdef SUPPORT_THREADS
+		std::unique_lock<std::mutex> lock;
+#endif
+	};
+
+private:
+	AudioStream(const AudioStream&) = delete;
+	AudioStream& operator=(const AudioStream&) = delete;
+
+	/**
+	 * Calls the source once when there is room in the buffer.
+	 *
+	 * @return whether data was produced.
+	 */
+	bool Produce();
+
+	int GetFill() const;
+
+	/** Ring buffer, size is a power of two. */
+	std::vector<uint8_t> ring;
+	/** Total bytes written and read, positions are taken modulo size. */
+	std::atomic<size_t> write_pos;
+	std::atomic<size_t> read_pos;
+
+	Source source;
+	std::vector<uint8_t> chunk;
+	int frame_size = 1;
+	int target = 0;
+
+	std::atomic<bool> active;
+	std::atomic<bool> paused;
+	/** Reads wait until the buffer was filled once. */
+	std::atomic<bool> primed;
+	std::atomic<bool> ended;
+	std::atomic<bool> error;
+
+	std::atomic<int> underruns;
+	std::atomic<int> min_fill;
+
+#ifdef SUPPORT_THREADS
+	void Run();
+
+	/** Guards source and chunk. */
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::thread thread;
+	bool quit = false;
+#endif
+};
+
+#endif
@@ -121,6 +121,8 @@ int Background::Scale(int x) {
 }
 
 void Background::Draw() {
+	drawn_state = GetDamageState();
+
 	if (!visible)
 		return;
 
@@ -132,3 +134,47 @@ void Background::Draw() {
 	if (fg_bitmap)
 		dst->TiledBlit(-Scale(fg_x), -Scale(fg_y), fg_bitmap->GetRect(), *fg_bitmap, dst->GetRect(), 255);
 }
+
+bool Background::GetDamage(Rect& damage) {
+	damage = Rect();
+
+	if (!(GetDamageState() == drawn_state)) {
+		damage = DisplayUi->GetDisplaySurface()->GetRect();
+	}
+
+	return true;
+}
+
+Background::DamageState Background::GetDamageState() const {
+	DamageState state = DamageState();
+
+	state.shown = visible;
+
+	if (!state.shown) {
+		return state;
+	}
+
+	if (bg_bitmap) {
+		state.bg_revision = bg_bitmap->GetRevision();
+		state.bg_x = Scale(bg_x);
+		state.bg_y = Scale(bg_y);
+	}
+
+	if (fg_bitmap) {
+		state.fg_revision = fg_bitmap->GetRevision();
+		state.fg_x = Scale(fg_x);
+		state.fg_y = Scale(fg_y);
+	}
+
+	return state;
+}
+
+bool Background::DamageState::operator==(const DamageState& other) const {
+	return shown == other.shown &&
+		bg_revision == other.bg_revision &&
+		bg_x == other.bg_x &&
+		bg_y == other.bg_y &&
+		fg_revision == other.fg_revision &&
+		fg_x == other.fg_x &&
+		fg_y == other.fg_y;
+}
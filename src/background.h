@@ -33,6 +33,8 @@ public:
 	void Draw() override;
 	void Update();
 
+	bool GetDamage(Rect& damage) override;
+
 	int GetZ() const override;
 	DrawableType GetType() const override;
 
@@ -60,6 +62,24 @@ private:
 	int fg_y;
 
 	FileRequestBinding request_id;
+
+	/** Everything that decides which pixels Draw produces. */
+	struct DamageState {
+		bool shown;
+		uint32_t bg_revision;
+		int bg_x;
+		int bg_y;
+		uint32_t fg_revision;
+		int fg_x;
+		int fg_y;
+
+		bool operator==(const DamageState& other) const;
+	};
+
+	/** State of the last Draw call. */
+	DamageState drawn_state = DamageState();
+
+	DamageState GetDamageState() const;
 };
 
 #endif
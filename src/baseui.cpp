@@ -18,6 +18,8 @@
 // Headers
 #include "baseui.h"
 #include "bitmap.h"
+#include "headless_ui.h"
+#include "player.h"
 
 #ifdef USE_SDL
 #include "sdl_ui.h"
@@ -30,6 +32,15 @@
 std::shared_ptr<BaseUi> DisplayUi;
 
 std::shared_ptr<BaseUi> BaseUi::CreateUi(long width, long height, bool fs_flag, bool /* zoom */) {
+	if (Player::headless_flag) {
+		std::shared_ptr<HeadlessUi> ui = std::make_shared<HeadlessUi>(width, height);
+		ui->SetFrameLimit(Player::headless_frames);
+		if (!Player::headless_input.empty()) {
+			ui->LoadInputScript(Player::headless_input);
+		}
+		return ui;
+	}
+
 #ifdef USE_SDL
 	return std::make_shared<SdlUi>(width, height, fs_flag);
 #elif _3DS
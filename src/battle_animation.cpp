@@ -68,6 +68,7 @@ int BattleAnimation::GetZ() const {
 }
 
 void BattleAnimation::SetZ(int nz) {
+	if (z != nz) Graphics::UpdateZCallback(this);
 	z = nz;
 }
 
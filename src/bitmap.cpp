@@ -20,11 +20,13 @@
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 
 #include "utils.h"
 #include "cache.h"
 #include "bitmap.h"
+#include "decoded_image_cache.h"
 #include "filefinder.h"
 #include "options.h"
 #include "data.h"
@@ -32,13 +34,18 @@
 #include "image_xyz.h"
 #include "image_bmp.h"
 #include "image_png.h"
+#include "image_target.h"
 #include "font.h"
 #include "output.h"
 #include "util_macro.h"
-#include "bitmap_hslrgb.h"
+#include "bitmap_kernels.h"
 
 const Opacity Opacity::opaque;
 
+namespace {
+	std::atomic<uint32_t> next_revision(0);
+}
+
 BitmapRef Bitmap::Create(int width, int height, const Color& color) {
     BitmapRef surface = Bitmap::Create(width, height, false);
 	surface->Fill(color);
@@ -59,6 +66,7 @@ BitmapRef Bitmap::Create(Bitmap const& source, Rect const& src_rect, bool transp
 
 void Bitmap::InitBitmap() {
 	editing = false;
+	revision = ++next_revision;
 	font = Font::Default();
 }
 
@@ -221,16 +229,7 @@ void Bitmap::HueChangeBlit(int x, int y, Bitmap const& src, Rect const& src_rect
 	Bitmap bmp(reinterpret_cast<void*>(&pixels.front()), src_rect.width, src_rect.height, src_rect.width * 4, format);
 	bmp.Blit(0, 0, src, src_rect, Opacity::opaque);
 
-	for (std::vector<uint32_t>::iterator p = pixels.begin(); p != pixels.end(); ++p) {
-		uint32_t pixel = *p;
-		uint8_t r = (pixel>>24) & 0xFF;
-		uint8_t g = (pixel>>16) & 0xFF;
-		uint8_t b = (pixel>> 8) & 0xFF;
-		uint8_t a = pixel & 0xFF;
-		if (a > 0)
-			RGB_adjust_HSL(r, g, b, hue);
-		*p = ((uint32_t) r << 24) | ((uint32_t) g << 16) | ((uint32_t) b << 8) | (uint32_t) a;
-	}
+	BitmapKernels::HueChange(&pixels.front(), pixels.size(), hue);
 
 	Blit(dst_rect.x, dst_rect.y, bmp, bmp.GetRect(), Opacity::opaque);
 
@@ -238,6 +237,11 @@ void Bitmap::HueChangeBlit(int x, int y, Bitmap const& src, Rect const& src_rect
 }
 
 void Bitmap::RefreshCallback() {
+	revision = ++next_revision;
+}
+
+uint32_t Bitmap::GetRevision() const {
+	return revision;
 }
 
 FontRef const& Bitmap::GetFont() const {
@@ -444,6 +448,21 @@ static void destroy_func(pixman_image_t * /* image */, void *data) {
 	free(data);
 }
 
+/**
+ * Whether the image decoders can write pixels of this format directly:
+ * 32 bit pixels with 8 bit channels.
+ */
+static bool is_image_target(const DynamicFormat& format) {
+	return format.bits == 32 &&
+		format.r.bits == 8 && format.g.bits == 8 && format.b.bits == 8 &&
+		(format.alpha_type == PF::NoAlpha || format.a.bits == 8);
+}
+
+static ImageTarget to_image_target(const DynamicFormat& format) {
+	return ImageTarget(format.r.shift, format.g.shift, format.b.shift,
+		format.alpha_type == PF::NoAlpha ? -1 : format.a.shift);
+}
+
 static pixman_indexed_t palette;
 static bool palette_initialized = false;
 
@@ -519,7 +538,16 @@ Bitmap::Bitmap(const std::string& filename, bool transparent, uint32_t flags) {
 	format = (transparent ? pixel_format : opaque_pixel_format);
 	pixman_format = find_format(format);
 
-	FILE* stream = FileFinder::fopenUTF8(filename, "rb");
+	// Transparency is not part of the flags
+	uint32_t const variant = flags | (transparent ? 1 : 0);
+
+	if (DecodedImageCache::IsEnabled() && LoadDecoded(filename, variant, flags)) {
+		return;
+	}
+
+	// Closed on every path, decoding on a worker can end in JobFailed
+	std::unique_ptr<FILE, int(*)(FILE*)> file(FileFinder::fopenUTF8(filename, "rb"), fclose);
+	FILE* stream = file.get();
 	if (!stream) {
 		Output::Error("Couldn't open image file %s", filename.c_str());
 		return;
@@ -527,27 +555,115 @@ Bitmap::Bitmap(const std::string& filename, bool transparent, uint32_t flags) {
 
 	int w = 0;
 	int h = 0;
-	void* pixels;
+	void* pixels = NULL;
+
+	// Decode straight into the surface format when possible
+	const ImageTarget target = to_image_target(format);
+	const ImageTarget* image_target = is_image_target(format) ? &target : nullptr;
 
 	char data[4];
 	size_t bytes = fread(&data, 1, 4, stream);
 	fseek(stream, 0, SEEK_SET);
 
 	if (bytes >= 4 && strncmp((char*)data, "XYZ1", 4) == 0)
-		ImageXYZ::ReadXYZ(stream, transparent, w, h, pixels);
+		ImageXYZ::ReadXYZ(stream, transparent, w, h, pixels, image_target);
 	else if (bytes > 2 && strncmp((char*)data, "BM", 2) == 0)
-		ImageBMP::ReadBMP(stream, transparent, w, h, pixels);
+		ImageBMP::ReadBMP(stream, transparent, w, h, pixels, image_target);
 	else if (bytes >= 4 && strncmp((char*)(data + 1), "PNG", 3) == 0)
-		ImagePNG::ReadPNG(stream, (void*)NULL, transparent, w, h, pixels);
+		ImagePNG::ReadPNG(stream, (void*)NULL, transparent, w, h, pixels, image_target);
 	else
 		Output::Error("Unsupported image file %s", filename.c_str());
 
-	fclose(stream);
+	file.reset();
 
-	Init(w, h, (void *) NULL);
-	ConvertImage(w, h, pixels, transparent);
+	if (image_target) {
+		// The surface takes ownership of the decoded pixels
+		Init(w, h, pixels);
+	} else {
+		Init(w, h, (void *) NULL);
+		ConvertImage(w, h, pixels, transparent);
+	}
 
 	CheckPixels(flags);
+
+	if (DecodedImageCache::IsEnabled()) {
+		StoreDecoded(filename, variant);
+	}
+}
+
+static void release_decoded(pixman_image_t * /* image */, void *mapping) {
+	DecodedImageCache::Release(mapping);
+}
+
+bool Bitmap::LoadDecoded(const std::string& filename, uint32_t variant, uint32_t flags) {
+	DecodedImageCache::Entry entry;
+	void* mapping;
+
+	if (!DecodedImageCache::Load(filename, variant, entry, mapping)) {
+		return false;
+	}
+
+	// Entries from a run with another display format are useless
+	if (entry.pixman_format != static_cast<uint32_t>(pixman_format)) {
+		DecodedImageCache::Release(mapping);
+		return false;
+	}
+
+	Init(entry.width, entry.height, entry.pixels, entry.pitch, false);
+	pixman_image_set_destroy_function(bitmap, release_decoded, mapping);
+
+	if (flags & Flag_System) {
+		bg_color = Color(entry.bg_color[0], entry.bg_color[1], entry.bg_color[2], entry.bg_color[3]);
+		sh_color = Color(entry.sh_color[0], entry.sh_color[1], entry.sh_color[2], entry.sh_color[3]);
+	}
+
+	if (flags & Flag_Chipset) {
+		tile_opacity.clear();
+		tile_opacity.resize(entry.tile_rows);
+		for (int row = 0; row < entry.tile_rows; row++) {
+			tile_opacity[row].resize(entry.tile_cols);
+			for (int col = 0; col < entry.tile_cols; col++) {
+				tile_opacity[row][col] = static_cast<TileOpacity>(entry.tile_opacity[row * entry.tile_cols + col]);
+			}
+		}
+	}
+
+	if (flags & Flag_ReadOnly) {
+		read_only = true;
+		opacity = static_cast<TileOpacity>(entry.opacity);
+	}
+
+	return true;
+}
+
+void Bitmap::StoreDecoded(const std::string& filename, uint32_t variant) {
+	DecodedImageCache::Entry entry;
+
+	entry.width = width();
+	entry.height = height();
+	entry.pitch = pitch();
+	entry.pixman_format = static_cast<uint32_t>(pixman_format);
+	entry.opacity = static_cast<uint8_t>(opacity);
+	entry.pixels = pixels();
+
+	entry.tile_rows = static_cast<int>(tile_opacity.size());
+	entry.tile_cols = tile_opacity.empty() ? 0 : static_cast<int>(tile_opacity[0].size());
+	for (const auto& row : tile_opacity) {
+		for (TileOpacity tile : row) {
+			entry.tile_opacity.push_back(static_cast<uint8_t>(tile));
+		}
+	}
+
+	const Color* colors[] = { &bg_color, &sh_color };
+	uint8_t* targets[] = { entry.bg_color, entry.sh_color };
+	for (int i = 0; i < 2; ++i) {
+		targets[i][0] = colors[i]->red;
+		targets[i][1] = colors[i]->green;
+		targets[i][2] = colors[i]->blue;
+		targets[i][3] = colors[i]->alpha;
+	}
+
+	DecodedImageCache::Store(filename, variant, entry);
 }
 
 Bitmap::Bitmap(const uint8_t* data, unsigned bytes, bool transparent, uint32_t flags) {
@@ -557,19 +673,28 @@ Bitmap::Bitmap(const uint8_t* data, unsigned bytes, bool transparent, uint32_t f
 	pixman_format = find_format(format);
 
 	int w = 0, h = 0;
-	void* pixels;
+	void* pixels = NULL;
+
+	// Decode straight into the surface format when possible
+	const ImageTarget target = to_image_target(format);
+	const ImageTarget* image_target = is_image_target(format) ? &target : nullptr;
 
 	if (bytes > 4 && strncmp((char*) data, "XYZ1", 4) == 0)
-		ImageXYZ::ReadXYZ(data, bytes, transparent, w, h, pixels);
+		ImageXYZ::ReadXYZ(data, bytes, transparent, w, h, pixels, image_target);
 	else if (bytes > 2 && strncmp((char*) data, "BM", 2) == 0)
-		ImageBMP::ReadBMP(data, bytes, transparent, w, h, pixels);
+		ImageBMP::ReadBMP(data, bytes, transparent, w, h, pixels, image_target);
 	else if (bytes > 4 && strncmp((char*)(data + 1), "PNG", 3) == 0)
-		ImagePNG::ReadPNG((FILE*) NULL, (const void*) data, transparent, w, h, pixels);
+		ImagePNG::ReadPNG((FILE*) NULL, (const void*) data, transparent, w, h, pixels, image_target);
 	else
 		Output::Error("Unsupported image");
 
-	Init(w, h, (void *) NULL);
-	ConvertImage(w, h, pixels, transparent);
+	if (image_target) {
+		// The surface takes ownership of the decoded pixels
+		Init(w, h, pixels);
+	} else {
+		Init(w, h, (void *) NULL);
+		ConvertImage(w, h, pixels, transparent);
+	}
 
 	CheckPixels(flags);
 }
@@ -805,6 +930,8 @@ void Bitmap::TransformBlit(Rect const& dst_rect, Bitmap const& src, Rect const&
 
 	if (mask != NULL)
 		pixman_image_unref(mask);
+
+	RefreshCallback();
 }
 
 void Bitmap::WaverBlit(int x, int y, double zoom_x, double zoom_y, Bitmap const& src, Rect const& src_rect, int depth, double phase, Opacity const& opacity) {
@@ -920,20 +1047,48 @@ void Bitmap::ClearRect(Rect const& dst_rect) {
 	RefreshCallback();
 }
 
-// Hard light lookup table mapping source color to destination color
-static uint8_t hard_light_lookup[256][256];
+void Bitmap::SetClipRects(std::vector<Rect> const& rects) {
+	std::vector<pixman_box32_t> boxes;
+	boxes.reserve(rects.size());
 
-static void make_hard_light_lookup() {
-	for (int i = 0; i < 256; ++i) {
-		for (int j = 0; j < 256; ++j) {
-			int res = 0;
-			if (i <= 128)
-				res = (2 * i * j) / 255;
-			else
-				res = 255 - 2 * (255 - i) * (255 - j) / 255;
-			hard_light_lookup[i][j] = res > 255 ? 255 : res < 0 ? 0 : res;
+	for (const Rect& rect : rects) {
+		if (rect.IsEmpty()) {
+			continue;
 		}
+		pixman_box32_t box = { rect.x, rect.y, rect.x + rect.width, rect.y + rect.height };
+		boxes.push_back(box);
+	}
+
+	pixman_region32_t region;
+	pixman_region32_init_rects(&region, boxes.empty() ? nullptr : &boxes.front(), static_cast<int>(boxes.size()));
+	pixman_image_set_clip_region32(bitmap, &region);
+	pixman_region32_fini(&region);
+}
+
+void Bitmap::ClearClipRects() {
+	pixman_image_set_clip_region32(bitmap, nullptr);
+}
+
+void Bitmap::GetToneParams(const Tone& tone, bool skip_transparent, BitmapKernels::ToneParams& params) {
+	params.r_shift = pixel_format.r.shift;
+	params.g_shift = pixel_format.g.shift;
+	params.b_shift = pixel_format.b.shift;
+	params.a_shift = pixel_format.a.shift;
+
+	params.gray = tone.gray != 128;
+	if (tone.gray > 128) {
+		params.sat = 1024 + (tone.gray - 128) * 16;
 	}
+	else {
+		params.sat = tone.gray * 8;
+	}
+
+	params.color = tone.red != 128 || tone.green != 128 || tone.blue != 128;
+	params.red = tone.red;
+	params.green = tone.green;
+	params.blue = tone.blue;
+
+	params.skip_transparent = skip_transparent;
 }
 
 void Bitmap::ToneBlit(int x, int y, Bitmap const& src, Rect const& src_rect, const Tone &tone, Opacity const& opacity) {
@@ -952,77 +1107,20 @@ void Bitmap::ToneBlit(int x, int y, Bitmap const& src, Rect const& src_rect, con
 		x, y,
 		src_rect.width, src_rect.height);
 
-	if (tone.gray != 128) {
-		uint32_t* pixels = (uint32_t*)this->pixels();
-
-		int sat;
-		if (tone.gray > 128) {
-			sat = 1024 + (tone.gray - 128) * 16;
-		}
-		else {
-			sat = tone.gray * 8;
-		}
-
-		int as = pixel_format.a.shift;
-		int rs = pixel_format.r.shift;
-		int gs = pixel_format.g.shift;
-		int bs = pixel_format.b.shift;
-
-		// Algorithm from OpenPDN (MIT license)
-		// Transformation in Y'CbCr color space
-		for (int i = 0; i < src_rect.width * src_rect.height; ++i) {
-			uint32_t pixel = pixels[i];
-			uint8_t a = (pixel >> as) & 0xFF;
-			// &src != this works around a corner case with opacity split (character in a bush)
-			// in that case a == 0 and the effect is not applied
-			if (a == 0 && &src != this) {
-				continue;
-			}
-			uint8_t r = (pixel >> rs) & 0xFF;
-			uint8_t g = (pixel >> gs) & 0xFF;
-			uint8_t b = (pixel >> bs) & 0xFF;
-			// Y' = 0.299 R' + 0.587 G' + 0.114 B'
-			uint8_t lum = (7471 * b + 38470 * g + 19595 * r) >> 16;
-			// Scale Cb/Cr by scale factor "sat"
-			int red = ((lum * 1024 + (r - lum) * sat) >> 10);
-			red = red > 255 ? 255 : red < 0 ? 0 : red;
-			int green = ((lum * 1024 + (g - lum) * sat) >> 10);
-			green = green > 255 ? 255 : green < 0 ? 0 : green;
-			int blue = ((lum * 1024 + (b - lum) * sat) >> 10);
-			blue = blue > 255 ? 255 : blue < 0 ? 0 : blue;
-			pixels[i] = ((uint32_t)red << rs) | ((uint32_t)green << gs) | ((uint32_t)blue << bs) | ((uint32_t)a << as);
-		}
+	Rect dst_rect(x, y, src_rect.width, src_rect.height);
+	dst_rect.Adjust(width(), height());
+	if (dst_rect.IsEmpty()) {
+		return;
 	}
 
-	if (tone.red != 128 || tone.green != 128 || tone.blue != 128) {
-		static bool index_made = false;
-		if (!index_made) {
-			make_hard_light_lookup();
-			index_made = true;
-		}
-
-		int as = pixel_format.a.shift;
-		int rs = pixel_format.r.shift;
-		int gs = pixel_format.g.shift;
-		int bs = pixel_format.b.shift;
+	// &src != this works around a corner case with opacity split (character in a bush)
+	BitmapKernels::ToneParams params;
+	GetToneParams(tone, &src != this, params);
 
-		uint32_t* pixels = (uint32_t*)this->pixels();
+	BitmapKernels::ToneFunc const tone_row = BitmapKernels::GetToneKernel();
 
-		for (int i = 0; i < src_rect.width * src_rect.height; ++i) {
-			uint32_t pixel = pixels[i];
-			uint8_t a = (pixel >> as) & 0xFF;
-			if (a == 0 && &src != this) {
-				continue;
-			}
-			uint8_t r = (pixel >> rs) & 0xFF;
-			uint8_t g = (pixel >> gs) & 0xFF;
-			uint8_t b = (pixel >> bs) & 0xFF;
-
-			int red = hard_light_lookup[tone.red][r];
-			int green = hard_light_lookup[tone.green][g];
-			int blue = hard_light_lookup[tone.blue][b];
-			pixels[i] = ((uint32_t)red << rs) | ((uint32_t)green << gs) | ((uint32_t)blue << bs) | ((uint32_t)a << as);
-		}
+	for (int row = dst_rect.y; row < dst_rect.y + dst_rect.height; ++row) {
+		tone_row(reinterpret_cast<uint32_t*>(pointer(dst_rect.x, row)), dst_rect.width, params);
 	}
 
 	RefreshCallback();
@@ -33,6 +33,10 @@
 #include "matrix.h"
 #include "text.h"
 
+namespace BitmapKernels {
+	struct ToneParams;
+}
+
 /**
  * Opacity class.
  */
@@ -245,6 +249,16 @@ public:
 
 	void CheckPixels(uint32_t flags);
 
+	/**
+	 * Gets the revision of the pixel data.
+	 * Every drawing operation on the bitmap assigns a new revision.
+	 * Revisions are unique across all bitmaps, so comparing them
+	 * detects both a replaced bitmap and changed content.
+	 *
+	 * @return revision number.
+	 */
+	uint32_t GetRevision() const;
+
 protected:
 	Bitmap();
 
@@ -263,6 +277,25 @@ protected:
 
 	TileOpacity CheckOpacity(Rect const& rect);
 
+	/**
+	 * Creates the surface from the decoded image cache.
+	 *
+	 * @param filename image file.
+	 * @param variant cache variant (flags and transparency).
+	 * @param flags bitmap flags.
+	 * @return whether a valid entry was found.
+	 */
+	bool LoadDecoded(const std::string& filename, uint32_t variant, uint32_t flags);
+
+	/**
+	 * Writes the surface and its opacity information to the decoded
+	 * image cache.
+	 *
+	 * @param filename image file.
+	 * @param variant cache variant (flags and transparency).
+	 */
+	void StoreDecoded(const std::string& filename, uint32_t variant);
+
 	DynamicFormat format;
 
 	std::vector<std::vector<TileOpacity>> tile_opacity;
@@ -406,6 +439,19 @@ public:
 	 */
 	void Clear();
 
+	/**
+	 * Restricts drawing onto this bitmap to the area covered by the
+	 * given rects. ToneBlit writes the pixels directly and ignores it.
+	 *
+	 * @param rects clip rects.
+	 */
+	void SetClipRects(std::vector<Rect> const& rects);
+
+	/**
+	 * Removes the clip set by SetClipRects.
+	 */
+	void ClearClipRects();
+
 	/**
 	 * Clears the bitmap rect with transparent pixels.
 	 *
@@ -548,7 +594,38 @@ public:
 						   Opacity const& opacity, const Tone& tone,
 						   double zoom_x, double zoom_y);
 
+	/**
+	 * Blits source bitmap with flash, tone, flip and opacity.
+	 * The effects are applied row by row while compositing, no
+	 * intermediate bitmap of the source size is created.
+	 *
+	 * @param x x position.
+	 * @param y y position.
+	 * @param ox source origin x.
+	 * @param oy source origin y.
+	 * @param src source bitmap.
+	 * @param src_rect source bitmap rectangle.
+	 * @param opacity opacity.
+	 * @param tone tone, applied after the flash.
+	 * @param flash flash color.
+	 * @param flip_x flip horizontally.
+	 * @param flip_y flip vertically.
+	 */
+	void EffectsBlit(int x, int y, int ox, int oy,
+						   Bitmap const& src, Rect const& src_rect,
+						   Opacity const& opacity, const Tone& tone, const Color& flash,
+						   bool flip_x, bool flip_y);
+
 private:
+	/**
+	 * Fills the tone kernel parameters for the pixel format.
+	 *
+	 * @param tone tone to apply.
+	 * @param skip_transparent leave pixels with an alpha of 0 untouched.
+	 * @param params filled parameters.
+	 */
+	static void GetToneParams(const Tone& tone, bool skip_transparent, BitmapKernels::ToneParams& params);
+
 	/**
 	 * Blits source bitmap with transformation and opacity scaling.
 	 *
@@ -708,6 +785,7 @@ protected:
 
 	void RefreshCallback();
 	bool editing;
+	uint32_t revision;
 public:
 	Bitmap(int width, int height, bool transparent);
 	Bitmap(const std::string& filename, bool transparent, uint32_t flags);
@@ -0,0 +1,443 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "bitmap_kernels.h"
+#include "bitmap_hslrgb.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define BITMAP_KERNELS_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(BITMAP_KERNELS_SSE2) && defined(__GNUC__) && !defined(__EMSCRIPTEN__) && \
+	(defined(__x86_64__) || defined(__i386__)) && \
+	(defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  define BITMAP_KERNELS_AVX2
+#  include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define BITMAP_KERNELS_NEON
+#  include <arm_neon.h>
+#endif
+
+namespace {
+	// Hard light lookup table mapping source color to destination color
+	struct HardLightTable {
+		uint8_t lookup[256][256];
+
+		HardLightTable() {
+			for (int i = 0; i < 256; ++i) {
+				for (int j = 0; j < 256; ++j) {
+					int res = 0;
+					if (i <= 128)
+						res = (2 * i * j) / 255;
+					else
+						res = 255 - 2 * (255 - i) * (255 - j) / 255;
+					lookup[i][j] = res > 255 ? 255 : res < 0 ? 0 : res;
+				}
+			}
+		}
+	};
+
+	HardLightTable const& GetHardLightTable() {
+		static HardLightTable const table;
+		return table;
+	}
+
+	/**
+	 * The SIMD kernels compute the hard light table entry instead of
+	 * looking it up:
+	 *   tone <= 128: (k * c) / 255 with k = 2 * tone
+	 *   tone > 128: 255 - (k * (255 - c)) / 255 with k = 2 * (255 - tone)
+	 * 255 - c equals c ^ 0xFF, so both cases are
+	 *   ((k * (c ^ m)) / 255) ^ m
+	 * with m = 0 or 0xFF. k * c fits into 16 bit and x / 255 equals
+	 * (x * 0x8081) >> 23 for every 16 bit x.
+	 */
+	int HardLightFactor(uint8_t tone) {
+		return tone <= 128 ? 2 * tone : 2 * (255 - tone);
+	}
+
+	int HardLightMask(uint8_t tone) {
+		return tone <= 128 ? 0 : 0xFF;
+	}
+
+	// Multiplication of two 8 bit values with rounding, same as pixman
+	inline int MulUn8(int a, int b) {
+		int t = a * b + 0x80;
+		return ((t >> 8) + t) >> 8;
+	}
+
+	void ToneScalar(uint32_t* pixels, int width, BitmapKernels::ToneParams const& p) {
+		HardLightTable const& table = GetHardLightTable();
+
+		for (int i = 0; i < width; ++i) {
+			uint32_t pixel = pixels[i];
+			uint8_t a = (pixel >> p.a_shift) & 0xFF;
+			// skip_transparent works around a corner case with opacity split (character in a bush)
+			// in that case a == 0 and the effect is not applied
+			if (a == 0 && p.skip_transparent) {
+				continue;
+			}
+			int r = (pixel >> p.r_shift) & 0xFF;
+			int g = (pixel >> p.g_shift) & 0xFF;
+			int b = (pixel >> p.b_shift) & 0xFF;
+
+			if (p.gray) {
+				// Algorithm from OpenPDN (MIT license)
+				// Transformation in Y'CbCr color space
+				// Y' = 0.299 R' + 0.587 G' + 0.114 B'
+				uint8_t lum = (7471 * b + 38470 * g + 19595 * r) >> 16;
+				// Scale Cb/Cr by scale factor "sat"
+				int red = ((lum * 1024 + (r - lum) * p.sat) >> 10);
+				r = red > 255 ? 255 : red < 0 ? 0 : red;
+				int green = ((lum * 1024 + (g - lum) * p.sat) >> 10);
+				g = green > 255 ? 255 : green < 0 ? 0 : green;
+				int blue = ((lum * 1024 + (b - lum) * p.sat) >> 10);
+				b = blue > 255 ? 255 : blue < 0 ? 0 : blue;
+			}
+
+			if (p.color) {
+				r = table.lookup[p.red][r];
+				g = table.lookup[p.green][g];
+				b = table.lookup[p.blue][b];
+			}
+
+			pixels[i] = ((uint32_t)r << p.r_shift) | ((uint32_t)g << p.g_shift) | ((uint32_t)b << p.b_shift) | ((uint32_t)a << p.a_shift);
+		}
+	}
+
+#ifdef BITMAP_KERNELS_SSE2
+	/*
+	 * The channels are kept in 32 bit lanes with the upper 16 bits zero,
+	 * which allows the use of the 16 bit multiplications of SSE2.
+	 */
+
+	inline __m128i SaturateSSE2(__m128i c, __m128i lum, __m128i sat) {
+		// lum * 1024 + (c - lum) * sat
+		__m128i v = _mm_or_si128(lum, _mm_slli_epi32(_mm_sub_epi32(c, lum), 16));
+		v = _mm_srai_epi32(_mm_madd_epi16(v, sat), 10);
+		// The result fits into 16 bit, clamp the low halves
+		v = _mm_max_epi16(v, _mm_setzero_si128());
+		return _mm_min_epi16(v, _mm_set1_epi32(0xFF));
+	}
+
+	inline __m128i HardLightSSE2(__m128i c, __m128i k, __m128i m) {
+		__m128i v = _mm_mullo_epi16(_mm_xor_si128(c, m), k);
+		v = _mm_srli_epi16(_mm_mulhi_epu16(v, _mm_set1_epi16((short)0x8081)), 7);
+		return _mm_min_epi16(_mm_xor_si128(v, m), _mm_set1_epi32(0xFF));
+	}
+
+	void ToneSSE2(uint32_t* pixels, int width, BitmapKernels::ToneParams const& p) {
+		__m128i const byte = _mm_set1_epi32(0xFF);
+		__m128i const rs = _mm_cvtsi32_si128(p.r_shift);
+		__m128i const gs = _mm_cvtsi32_si128(p.g_shift);
+		__m128i const bs = _mm_cvtsi32_si128(p.b_shift);
+		__m128i const as = _mm_cvtsi32_si128(p.a_shift);
+
+		// 38470 does not fit into a signed 16 bit factor: 38470 = 65536 - 27066
+		__m128i const lum_bg = _mm_set1_epi32((int)((uint32_t)(-27066 & 0xFFFF) << 16 | 7471));
+		__m128i const lum_r = _mm_set1_epi32(19595);
+		__m128i const sat = _mm_set1_epi32(p.sat << 16 | 1024);
+
+		__m128i const kr = _mm_set1_epi32(HardLightFactor(p.red));
+		__m128i const kg = _mm_set1_epi32(HardLightFactor(p.green));
+		__m128i const kb = _mm_set1_epi32(HardLightFactor(p.blue));
+		__m128i const mr = _mm_set1_epi32(HardLightMask(p.red));
+		__m128i const mg = _mm_set1_epi32(HardLightMask(p.green));
+		__m128i const mb = _mm_set1_epi32(HardLightMask(p.blue));
+
+		int i = 0;
+		for (; i + 4 <= width; i += 4) {
+			__m128i const px = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + i));
+			__m128i r = _mm_and_si128(_mm_srl_epi32(px, rs), byte);
+			__m128i g = _mm_and_si128(_mm_srl_epi32(px, gs), byte);
+			__m128i b = _mm_and_si128(_mm_srl_epi32(px, bs), byte);
+			__m128i const a = _mm_and_si128(_mm_srl_epi32(px, as), byte);
+
+			if (p.gray) {
+				__m128i lum = _mm_madd_epi16(_mm_or_si128(b, _mm_slli_epi32(g, 16)), lum_bg);
+				lum = _mm_add_epi32(lum, _mm_madd_epi16(r, lum_r));
+				lum = _mm_srli_epi32(_mm_add_epi32(lum, _mm_slli_epi32(g, 16)), 16);
+
+				r = SaturateSSE2(r, lum, sat);
+				g = SaturateSSE2(g, lum, sat);
+				b = SaturateSSE2(b, lum, sat);
+			}
+
+			if (p.color) {
+				r = HardLightSSE2(r, kr, mr);
+				g = HardLightSSE2(g, kg, mg);
+				b = HardLightSSE2(b, kb, mb);
+			}
+
+			__m128i out = _mm_or_si128(
+				_mm_or_si128(_mm_sll_epi32(r, rs), _mm_sll_epi32(g, gs)),
+				_mm_or_si128(_mm_sll_epi32(b, bs), _mm_sll_epi32(a, as)));
+
+			if (p.skip_transparent) {
+				__m128i const keep = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+				out = _mm_or_si128(_mm_and_si128(keep, px), _mm_andnot_si128(keep, out));
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), out);
+		}
+
+		ToneScalar(pixels + i, width - i, p);
+	}
+#endif
+
+#ifdef BITMAP_KERNELS_AVX2
+	// Same algorithm as the SSE2 kernel with 8 pixels per iteration
+
+	__attribute__((target("avx2")))
+	inline __m256i SaturateAVX2(__m256i c, __m256i lum, __m256i sat) {
+		__m256i v = _mm256_or_si256(lum, _mm256_slli_epi32(_mm256_sub_epi32(c, lum), 16));
+		v = _mm256_srai_epi32(_mm256_madd_epi16(v, sat), 10);
+		v = _mm256_max_epi16(v, _mm256_setzero_si256());
+		return _mm256_min_epi16(v, _mm256_set1_epi32(0xFF));
+	}
+
+	__attribute__((target("avx2")))
+	inline __m256i HardLightAVX2(__m256i c, __m256i k, __m256i m) {
+		__m256i v = _mm256_mullo_epi16(_mm256_xor_si256(c, m), k);
+		v = _mm256_srli_epi16(_mm256_mulhi_epu16(v, _mm256_set1_epi16((short)0x8081)), 7);
+		return _mm256_min_epi16(_mm256_xor_si256(v, m), _mm256_set1_epi32(0xFF));
+	}
+
+	__attribute__((target("avx2")))
+	void ToneAVX2(uint32_t* pixels, int width, BitmapKernels::ToneParams const& p) {
+		__m256i const byte = _mm256_set1_epi32(0xFF);
+		__m128i const rs = _mm_cvtsi32_si128(p.r_shift);
+		__m128i const gs = _mm_cvtsi32_si128(p.g_shift);
+		__m128i const bs = _mm_cvtsi32_si128(p.b_shift);
+		__m128i const as = _mm_cvtsi32_si128(p.a_shift);
+
+		__m256i const lum_bg = _mm256_set1_epi32((int)((uint32_t)(-27066 & 0xFFFF) << 16 | 7471));
+		__m256i const lum_r = _mm256_set1_epi32(19595);
+		__m256i const sat = _mm256_set1_epi32(p.sat << 16 | 1024);
+
+		__m256i const kr = _mm256_set1_epi32(HardLightFactor(p.red));
+		__m256i const kg = _mm256_set1_epi32(HardLightFactor(p.green));
+		__m256i const kb = _mm256_set1_epi32(HardLightFactor(p.blue));
+		__m256i const mr = _mm256_set1_epi32(HardLightMask(p.red));
+		__m256i const mg = _mm256_set1_epi32(HardLightMask(p.green));
+		__m256i const mb = _mm256_set1_epi32(HardLightMask(p.blue));
+
+		int i = 0;
+		for (; i + 8 <= width; i += 8) {
+			__m256i const px = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pixels + i));
+			__m256i r = _mm256_and_si256(_mm256_srl_epi32(px, rs), byte);
+			__m256i g = _mm256_and_si256(_mm256_srl_epi32(px, gs), byte);
+			__m256i b = _mm256_and_si256(_mm256_srl_epi32(px, bs), byte);
+			__m256i const a = _mm256_and_si256(_mm256_srl_epi32(px, as), byte);
+
+			if (p.gray) {
+				__m256i lum = _mm256_madd_epi16(_mm256_or_si256(b, _mm256_slli_epi32(g, 16)), lum_bg);
+				lum = _mm256_add_epi32(lum, _mm256_madd_epi16(r, lum_r));
+				lum = _mm256_srli_epi32(_mm256_add_epi32(lum, _mm256_slli_epi32(g, 16)), 16);
+
+				r = SaturateAVX2(r, lum, sat);
+				g = SaturateAVX2(g, lum, sat);
+				b = SaturateAVX2(b, lum, sat);
+			}
+
+			if (p.color) {
+				r = HardLightAVX2(r, kr, mr);
+				g = HardLightAVX2(g, kg, mg);
+				b = HardLightAVX2(b, kb, mb);
+			}
+
+			__m256i out = _mm256_or_si256(
+				_mm256_or_si256(_mm256_sll_epi32(r, rs), _mm256_sll_epi32(g, gs)),
+				_mm256_or_si256(_mm256_sll_epi32(b, bs), _mm256_sll_epi32(a, as)));
+
+			if (p.skip_transparent) {
+				__m256i const keep = _mm256_cmpeq_epi32(a, _mm256_setzero_si256());
+				out = _mm256_blendv_epi8(out, px, keep);
+			}
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), out);
+		}
+
+		ToneSSE2(pixels + i, width - i, p);
+	}
+
+	bool HasAVX2() {
+		static bool const avx2 = __builtin_cpu_supports("avx2");
+		return avx2;
+	}
+#endif
+
+#ifdef BITMAP_KERNELS_NEON
+	inline uint32x4_t SaturateNEON(uint32x4_t c, uint32x4_t lum, int32_t sat) {
+		// lum * 1024 + (c - lum) * sat
+		int32x4_t v = vreinterpretq_s32_u32(vshlq_n_u32(lum, 10));
+		v = vmlaq_n_s32(v, vsubq_s32(vreinterpretq_s32_u32(c), vreinterpretq_s32_u32(lum)), sat);
+		v = vshrq_n_s32(v, 10);
+		v = vminq_s32(vmaxq_s32(v, vdupq_n_s32(0)), vdupq_n_s32(0xFF));
+		return vreinterpretq_u32_s32(v);
+	}
+
+	inline uint32x4_t HardLightNEON(uint32x4_t c, uint32_t k, uint32x4_t m) {
+		uint32x4_t v = vmulq_n_u32(veorq_u32(c, m), k);
+		v = vshrq_n_u32(vmulq_n_u32(v, 0x8081), 23);
+		return vminq_u32(veorq_u32(v, m), vdupq_n_u32(0xFF));
+	}
+
+	void ToneNEON(uint32_t* pixels, int width, BitmapKernels::ToneParams const& p) {
+		uint32x4_t const byte = vdupq_n_u32(0xFF);
+		int32x4_t const rs = vdupq_n_s32(-p.r_shift);
+		int32x4_t const gs = vdupq_n_s32(-p.g_shift);
+		int32x4_t const bs = vdupq_n_s32(-p.b_shift);
+		int32x4_t const as = vdupq_n_s32(-p.a_shift);
+
+		uint32_t const kr = HardLightFactor(p.red);
+		uint32_t const kg = HardLightFactor(p.green);
+		uint32_t const kb = HardLightFactor(p.blue);
+		uint32x4_t const mr = vdupq_n_u32(HardLightMask(p.red));
+		uint32x4_t const mg = vdupq_n_u32(HardLightMask(p.green));
+		uint32x4_t const mb = vdupq_n_u32(HardLightMask(p.blue));
+
+		int i = 0;
+		for (; i + 4 <= width; i += 4) {
+			uint32x4_t const px = vld1q_u32(pixels + i);
+			uint32x4_t r = vandq_u32(vshlq_u32(px, rs), byte);
+			uint32x4_t g = vandq_u32(vshlq_u32(px, gs), byte);
+			uint32x4_t b = vandq_u32(vshlq_u32(px, bs), byte);
+			uint32x4_t const a = vandq_u32(vshlq_u32(px, as), byte);
+
+			if (p.gray) {
+				uint32x4_t lum = vmulq_n_u32(b, 7471);
+				lum = vmlaq_n_u32(lum, g, 38470);
+				lum = vmlaq_n_u32(lum, r, 19595);
+				lum = vshrq_n_u32(lum, 16);
+
+				r = SaturateNEON(r, lum, p.sat);
+				g = SaturateNEON(g, lum, p.sat);
+				b = SaturateNEON(b, lum, p.sat);
+			}
+
+			if (p.color) {
+				r = HardLightNEON(r, kr, mr);
+				g = HardLightNEON(g, kg, mg);
+				b = HardLightNEON(b, kb, mb);
+			}
+
+			uint32x4_t out = vorrq_u32(
+				vorrq_u32(vshlq_u32(r, vnegq_s32(rs)), vshlq_u32(g, vnegq_s32(gs))),
+				vorrq_u32(vshlq_u32(b, vnegq_s32(bs)), vshlq_u32(a, vnegq_s32(as))));
+
+			if (p.skip_transparent) {
+				uint32x4_t const keep = vceqq_u32(a, vdupq_n_u32(0));
+				out = vbslq_u32(keep, px, out);
+			}
+
+			vst1q_u32(pixels + i, out);
+		}
+
+		ToneScalar(pixels + i, width - i, p);
+	}
+#endif
+}
+
+BitmapKernels::ToneFunc BitmapKernels::GetToneKernel(Kernel kernel) {
+	switch (kernel) {
+	case Kernel_Scalar:
+		return &ToneScalar;
+#ifdef BITMAP_KERNELS_SSE2
+	case Kernel_SSE2:
+		return &ToneSSE2;
+#endif
+#ifdef BITMAP_KERNELS_AVX2
+	case Kernel_AVX2:
+		return HasAVX2() ? &ToneAVX2 : NULL;
+#endif
+#ifdef BITMAP_KERNELS_NEON
+	case Kernel_NEON:
+		return &ToneNEON;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+BitmapKernels::ToneFunc BitmapKernels::GetToneKernel() {
+	static ToneFunc const best = [] {
+		for (int kernel = Kernel_Count - 1; kernel > Kernel_Scalar; --kernel) {
+			ToneFunc func = GetToneKernel(static_cast<Kernel>(kernel));
+			if (func) {
+				return func;
+			}
+		}
+		return GetToneKernel(Kernel_Scalar);
+	}();
+
+	return best;
+}
+
+void BitmapKernels::Flash(uint32_t* pixels, int width, FlashParams const& p) {
+	for (int i = 0; i < width; ++i) {
+		uint32_t pixel = pixels[i];
+		int a = (pixel >> p.a_shift) & 0xFF;
+		if (a == 0) {
+			continue;
+		}
+		int r = (pixel >> p.r_shift) & 0xFF;
+		int g = (pixel >> p.g_shift) & 0xFF;
+		int b = (pixel >> p.b_shift) & 0xFF;
+
+		// (flash IN a) OVER pixel
+		int const fa = MulUn8(p.alpha, a);
+		int const inv = 255 - fa;
+		r = MulUn8(p.red, a) + MulUn8(r, inv);
+		g = MulUn8(p.green, a) + MulUn8(g, inv);
+		b = MulUn8(p.blue, a) + MulUn8(b, inv);
+		a = fa + MulUn8(a, inv);
+
+		pixels[i] = ((uint32_t)r << p.r_shift) | ((uint32_t)g << p.g_shift) | ((uint32_t)b << p.b_shift) | ((uint32_t)a << p.a_shift);
+	}
+}
+
+void BitmapKernels::HueChange(uint32_t* pixels, int width, int hue) {
+	// The HSL conversion divides by data dependent values and does not map
+	// to integer SIMD. Graphics using it are palette based, so the result
+	// of the previous color is reused instead.
+	uint32_t last_in = 0;
+	uint32_t last_out = 0;
+
+	for (int i = 0; i < width; ++i) {
+		uint32_t pixel = pixels[i];
+		uint8_t a = pixel & 0xFF;
+		if (a == 0) {
+			continue;
+		}
+		if (pixel == last_in) {
+			pixels[i] = last_out;
+			continue;
+		}
+		uint8_t r = (pixel>>24) & 0xFF;
+		uint8_t g = (pixel>>16) & 0xFF;
+		uint8_t b = (pixel>> 8) & 0xFF;
+		RGB_adjust_HSL(r, g, b, hue);
+		last_in = pixel;
+		last_out = ((uint32_t) r << 24) | ((uint32_t) g << 16) | ((uint32_t) b << 8) | (uint32_t) a;
+		pixels[i] = last_out;
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BITMAP_KERNELS_H_
+#define _BITMAP_KERNELS_H_
+
+// Headers
+#include <cstdint>
+
+/**
+ * Pixel loops of the Bitmap effects.
+ * Every kernel has a scalar reference implementation. SIMD versions are
+ * compiled in when the target supports them and are chosen at runtime.
+ * All versions produce bit-identical results.
+ */
+namespace BitmapKernels {
+	/** Available kernel implementations. */
+	enum Kernel {
+		Kernel_Scalar,
+		Kernel_SSE2,
+		Kernel_AVX2,
+		Kernel_NEON,
+		Kernel_Count
+	};
+
+	/** Parameters of a tone change, precomputed from a Tone. */
+	struct ToneParams {
+		/** Bit positions of the 8 bit channels in a pixel. */
+		int r_shift;
+		int g_shift;
+		int b_shift;
+		int a_shift;
+
+		/** Whether the saturation is changed. */
+		bool gray;
+		/** Saturation factor, 1024 keeps the saturation. */
+		int sat;
+
+		/** Whether the hard light color tone is applied. */
+		bool color;
+		uint8_t red;
+		uint8_t green;
+		uint8_t blue;
+
+		/** Leave pixels with an alpha of 0 untouched. */
+		bool skip_transparent;
+	};
+
+	/**
+	 * Applies a tone change to a row of 32 bit pixels in place.
+	 */
+	typedef void (*ToneFunc)(uint32_t* pixels, int width, ToneParams const& params);
+
+	/**
+	 * Gets the tone kernel of an implementation.
+	 *
+	 * @param kernel implementation.
+	 * @return kernel or NULL when not supported by this build or CPU.
+	 */
+	ToneFunc GetToneKernel(Kernel kernel);
+
+	/**
+	 * Gets the fastest tone kernel supported by the CPU.
+	 *
+	 * @return tone kernel.
+	 */
+	ToneFunc GetToneKernel();
+
+	/** Parameters of a flash, premultiplied like the pixels. */
+	struct FlashParams {
+		/** Bit positions of the 8 bit channels in a pixel. */
+		int r_shift;
+		int g_shift;
+		int b_shift;
+		int a_shift;
+
+		uint8_t red;
+		uint8_t green;
+		uint8_t blue;
+		uint8_t alpha;
+	};
+
+	/**
+	 * Blends the flash color over a row of premultiplied 32 bit pixels in
+	 * place, masked by the alpha of each pixel. Matches compositing a
+	 * solid color with PIXMAN_OP_OVER and the pixels as mask.
+	 *
+	 * @param pixels row.
+	 * @param width amount of pixels.
+	 * @param params flash color.
+	 */
+	void Flash(uint32_t* pixels, int width, FlashParams const& params);
+
+	/**
+	 * Rotates the hue of a row of RGBA pixels (red in the highest byte)
+	 * in place. Pixels with an alpha of 0 are left untouched.
+	 *
+	 * @param pixels row.
+	 * @param width amount of pixels.
+	 * @param hue hue change, 0x600 is a full turn.
+	 */
+	void HueChange(uint32_t* pixels, int width, int hue);
+}
+
+#endif
@@ -20,7 +20,12 @@
 #  pragma warning(disable: 4003)
 #endif
 
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <list>
 #include <map>
+#include <set>
 
 #include "async_handler.h"
 #include "cache.h"
@@ -31,6 +36,8 @@
 #include "output.h"
 #include "player.h"
 #include "data.h"
+#include "text.h"
+#include "thread_pool.h"
 
 namespace {
 	typedef std::pair<std::string,std::string> string_pair;
@@ -44,6 +51,25 @@ namespace {
 
 	static std::string system_name;
 
+	Cache::Stats stats = {};
+
+	struct Decoded {
+		bool transparent;
+		std::weak_ptr<Bitmap> bitmap;
+		/** Keeps the image until the listeners of its request ran. */
+		BitmapRef pending;
+	};
+
+	/**
+	 * Images decoded on worker threads that were not requested yet.
+	 * Afterwards the retention list holds them, so they are dropped like
+	 * other unused images when nobody claims them.
+	 */
+	std::map<string_pair, Decoded> decoded;
+
+	/** Images a worker thread is decoding. */
+	std::set<string_pair> decoding;
+
 	BitmapRef LoadBitmap(std::string const& folder_name, const std::string& filename,
 						 bool transparent, uint32_t const flags) {
 		string_pair const key(folder_name, filename);
@@ -51,14 +77,30 @@ namespace {
 		cache_type::const_iterator const it = cache.find(key);
 
 		if (it == cache.end() || it->second.expired()) {
+			auto const decoded_it = decoded.find(key);
+			if (decoded_it != decoded.end()) {
+				Decoded const entry = decoded_it->second;
+				decoded.erase(decoded_it);
+
+				BitmapRef const bitmap = entry.bitmap.lock();
+				if (bitmap && entry.transparent == transparent) {
+					++stats.misses;
+					return (cache[key] = bitmap).lock();
+				}
+			}
+
 			std::string const path = FileFinder::FindImage(folder_name, filename);
 
 			if (path.empty()) {
 				return BitmapRef();
 			}
 
+			++stats.misses;
 			return (cache[key] = Bitmap::Create(path, transparent, flags)).lock();
-		} else { return it->second.lock(); }
+		} else {
+			++stats.hits;
+			return it->second.lock();
+		}
 	}
 
 	struct Material {
@@ -113,25 +155,151 @@ namespace {
 		int min_width , max_width;
 		int min_height, max_height;
 		std::function<BitmapRef()> dummy_renderer;
+		/** Share of the retention budget in percent. */
+		int retention;
 	} const spec[] = {
-		{ "Backdrop", false, 320, 320, 160, 160, backdrop_dummy_func},
-		{ "Battle", true, 480, 480, 96, 480, battle_dummy_func },
-		{ "CharSet", true, 288, 288, 256, 256, charset_dummy_func },
-		{ "ChipSet", true, 480, 480, 256, 256, chipset_dummy_func },
-		{ "FaceSet", true, 192, 192, 192, 192, faceset_dummy_func },
-		{ "GameOver", false, 320, 320, 240, 240, gameover_dummy_func },
-		{ "Monster", true, 16, 320, 16, 160, monster_dummy_func },
-		{ "Panorama", false, 80, 640, 80, 480, panorama_dummy_func },
-		{ "Picture", true, 1, 640, 1, 480, picture_dummy_func },
-		{ "System", true, 160, 160, 80, 80, &DummySystem },
-		{ "Title", false, 320, 320, 240, 240, title_dummy_func },
-		{ "System2", true, 80, 80, 96, 96, system2_dummy_func },
-		{ "Battle2", true, 640, 640, 640, 640, battle2_dummy_func },
-		{ "BattleCharSet", true, 144, 144, 384, 384, battlecharset_dummy_func },
-		{ "BattleWeapon", true, 192, 192, 512, 512, battleweapon_dummy_func },
-		{ "Frame", true, 320, 320, 240, 240, frame_dummy_func },
+		{ "Backdrop", false, 320, 320, 160, 160, backdrop_dummy_func, 8 },
+		{ "Battle", true, 480, 480, 96, 480, battle_dummy_func, 10 },
+		{ "CharSet", true, 288, 288, 256, 256, charset_dummy_func, 24 },
+		{ "ChipSet", true, 480, 480, 256, 256, chipset_dummy_func, 8 },
+		{ "FaceSet", true, 192, 192, 192, 192, faceset_dummy_func, 8 },
+		{ "GameOver", false, 320, 320, 240, 240, gameover_dummy_func, 0 },
+		{ "Monster", true, 16, 320, 16, 160, monster_dummy_func, 8 },
+		{ "Panorama", false, 80, 640, 80, 480, panorama_dummy_func, 8 },
+		{ "Picture", true, 1, 640, 1, 480, picture_dummy_func, 8 },
+		{ "System", true, 160, 160, 80, 80, &DummySystem, 4 },
+		{ "Title", false, 320, 320, 240, 240, title_dummy_func, 0 },
+		{ "System2", true, 80, 80, 96, 96, system2_dummy_func, 2 },
+		{ "Battle2", true, 640, 640, 640, 640, battle2_dummy_func, 4 },
+		{ "BattleCharSet", true, 144, 144, 384, 384, battlecharset_dummy_func, 6 },
+		{ "BattleWeapon", true, 192, 192, 512, 512, battleweapon_dummy_func, 2 },
+		{ "Frame", true, 320, 320, 240, 240, frame_dummy_func, 0 },
+	};
+
+	uint32_t GetFlags(Material::Type type) {
+		return Bitmap::Flag_ReadOnly | (
+			type == Material::Chipset ? Bitmap::Flag_Chipset :
+			type == Material::System ? Bitmap::Flag_System :
+			0);
+	}
+
+	Material::Type FindMaterial(std::string const& directory) {
+		for (int i = 0; i < Material::END; ++i) {
+			if (directory == spec[i].directory) {
+				return static_cast<Material::Type>(i);
+			}
+		}
+		return Material::REND;
+	}
+
+	/**
+	 * Checks the file signature, Bitmap reports unsupported files as
+	 * error which must only happen on the main thread.
+	 */
+	bool IsSupportedImage(std::string const& path) {
+		FILE* stream = FileFinder::fopenUTF8(path, "rb");
+		if (!stream) {
+			return false;
+		}
+
+		char data[4];
+		size_t bytes = fread(&data, 1, 4, stream);
+		fclose(stream);
+
+		return (bytes >= 4 && strncmp(data, "XYZ1", 4) == 0) ||
+			(bytes > 2 && strncmp(data, "BM", 2) == 0) ||
+			(bytes >= 4 && strncmp(data + 1, "PNG", 3) == 0);
+	}
+
+	struct Retained {
+		string_pair key;
+		BitmapRef bitmap;
+		size_t bytes;
 	};
 
+	typedef std::list<Retained> retained_list;
+
+	/**
+	 * Strong references to the recently loaded images of one type, so
+	 * they survive while no scene uses them.
+	 */
+	struct Retention {
+		/** Most recently used first. */
+		retained_list lru;
+		std::map<string_pair, retained_list::iterator> index;
+		size_t bytes = 0;
+	};
+
+	Retention retention[Material::END];
+
+	size_t retention_budget = 8 * 1024 * 1024;
+
+	size_t GetRetentionBudget(Material::Type type) {
+		return retention_budget / 100 * spec[type].retention;
+	}
+
+	void Evict(Retention& r, size_t budget) {
+		while (r.bytes > budget) {
+			Retained const& oldest = r.lru.back();
+			r.bytes -= oldest.bytes;
+			r.index.erase(oldest.key);
+			r.lru.pop_back();
+			++stats.evictions;
+		}
+	}
+
+	/**
+	 * Keeps an image decoded after its last user is gone.
+	 *
+	 * @param type image type.
+	 * @param key image directory and name.
+	 * @param bitmap image.
+	 * @param prefetched image was not requested yet. It is kept as least
+	 *                   recently used and only when it fits without
+	 *                   dropping other images.
+	 */
+	void Retain(Material::Type type, string_pair const& key, BitmapRef const& bitmap, bool prefetched = false) {
+		Retention& r = retention[type];
+
+		auto const it = r.index.find(key);
+		if (it != r.index.end()) {
+			if (it->second->bitmap == bitmap) {
+				if (!prefetched) {
+					r.lru.splice(r.lru.begin(), r.lru, it->second);
+				}
+				return;
+			}
+
+			r.bytes -= it->second->bytes;
+			r.lru.erase(it->second);
+			r.index.erase(it);
+		}
+
+		size_t const budget = GetRetentionBudget(type);
+		size_t const bytes = static_cast<size_t>(bitmap->GetWidth()) * bitmap->GetHeight() * bitmap->bpp();
+
+		if (bytes > budget) {
+			return;
+		}
+
+		if (prefetched) {
+			if (r.bytes + bytes > budget) {
+				return;
+			}
+
+			r.lru.push_back(Retained{key, bitmap, bytes});
+			r.index[key] = std::prev(r.lru.end());
+			r.bytes += bytes;
+			return;
+		}
+
+		r.lru.push_front(Retained{key, bitmap, bytes});
+		r.index[key] = r.lru.begin();
+		r.bytes += bytes;
+
+		Evict(r, budget);
+	}
+
 	template<Material::Type T>
 	BitmapRef DrawCheckerboard() {
 		static_assert(Material::REND < T && T < Material::END, "Invalid material.");
@@ -185,10 +353,7 @@ namespace {
 			return BitmapRef();
 		}
 
-		BitmapRef ret = LoadBitmap(s.directory, f, transparent, Bitmap::Flag_ReadOnly | (
-										 T == Material::Chipset? Bitmap::Flag_Chipset:
-										 T == Material::System? Bitmap::Flag_System:
-										 0));
+		BitmapRef ret = LoadBitmap(s.directory, f, transparent, GetFlags(T));
 
 		if (!ret) {
 			Output::Warning("Image not found: %s/%s", s.directory, f.c_str());
@@ -196,6 +361,8 @@ namespace {
 			return LoadDummyBitmap<T>(s.directory, f);
 		}
 
+		Retain(T, string_pair(s.directory, f), ret);
+
 		if(ret->GetWidth() < s.min_width   || s.max_width  < ret->GetWidth() ||
 		   ret->GetHeight() < s.min_height || s.max_height < ret->GetHeight()) {
 			Output::Debug("Image size out of bounds: %s/%s (%dx%d < %dx%d < %dx%d)",
@@ -280,6 +447,20 @@ BitmapRef Cache::Tile(const std::string& filename, int tile_id) {
 }
 
 void Cache::Clear() {
+	// Rendered text holds references to the system graphic
+	Text::ClearCache();
+
+	Output::Debug("Image cache: %d hits, %d misses, %d evictions",
+				  stats.hits, stats.misses, stats.evictions);
+
+	decoded.clear();
+
+	for (Retention& r : retention) {
+		r.lru.clear();
+		r.index.clear();
+		r.bytes = 0;
+	}
+
 	for(cache_type::const_iterator i = cache.begin(); i != cache.end(); ++i) {
 		if(i->second.expired()) { continue; }
 		Output::Debug("possible leak in cached bitmap %s/%s",
@@ -295,6 +476,133 @@ void Cache::Clear() {
 	cache_tiles.clear();
 }
 
+std::function<BitmapRef()> Cache::PrepareDecode(const std::string& directory, const std::string& file) {
+	Material::Type const type = FindMaterial(directory);
+	if (type == Material::REND || file == CACHE_DEFAULT_BITMAP) {
+		return std::function<BitmapRef()>();
+	}
+
+	string_pair const key(directory, file);
+
+	cache_type::const_iterator const it = cache.find(key);
+	if (it != cache.end() && !it->second.expired()) {
+		// Already decoded
+		return std::function<BitmapRef()>();
+	}
+
+	auto const decoded_it = decoded.find(key);
+	if (decoded_it != decoded.end() && !decoded_it->second.bitmap.expired()) {
+		// Decoded and not requested yet
+		return std::function<BitmapRef()>();
+	}
+
+	if (decoding.count(key) > 0) {
+		return std::function<BitmapRef()>();
+	}
+
+	std::string const path = FileFinder::FindImage(directory, file);
+	if (path.empty()) {
+		return std::function<BitmapRef()>();
+	}
+
+	decoding.insert(key);
+
+	bool const transparent = spec[type].transparent;
+	uint32_t const flags = GetFlags(type);
+
+	return [path, transparent, flags]() {
+		if (!IsSupportedImage(path)) {
+			return BitmapRef();
+		}
+		return Bitmap::Create(path, transparent, flags);
+	};
+}
+
+void Cache::AddDecoded(const std::string& directory, const std::string& file, BitmapRef bitmap) {
+	string_pair const key(directory, file);
+	decoding.erase(key);
+
+	Material::Type const type = FindMaterial(directory);
+	if (type == Material::REND || !bitmap) {
+		return;
+	}
+
+	cache_type::const_iterator const it = cache.find(key);
+	if (it != cache.end() && !it->second.expired()) {
+		// Loaded meanwhile
+		return;
+	}
+
+	decoded[key] = Decoded{spec[type].transparent, bitmap, bitmap};
+}
+
+void Cache::ReleaseDecoded(const std::string& directory, const std::string& file) {
+	string_pair const key(directory, file);
+
+	auto const it = decoded.find(key);
+	if (it == decoded.end() || !it->second.pending) {
+		return;
+	}
+
+	Retain(FindMaterial(directory), key, it->second.pending);
+	it->second.pending.reset();
+
+	if (it->second.bitmap.expired()) {
+		// Did not fit into the budget
+		decoded.erase(it);
+	}
+}
+
+void Cache::Prefetch(const std::string& directory, const std::string& file) {
+	if (!ThreadPool::IsAvailable() || file.empty()) {
+		return;
+	}
+
+	std::function<BitmapRef()> decode = PrepareDecode(directory, file);
+	if (!decode) {
+		return;
+	}
+
+	std::shared_ptr<BitmapRef> bitmap = std::make_shared<BitmapRef>();
+
+	ThreadPool::Submit(
+		[decode, bitmap]() {
+			*bitmap = decode();
+		},
+		[directory, file, bitmap]() {
+			Material::Type const type = FindMaterial(directory);
+			string_pair const key(directory, file);
+			decoding.erase(key);
+
+			cache_type::const_iterator const it = cache.find(key);
+			if (!*bitmap || (it != cache.end() && !it->second.expired())) {
+				return;
+			}
+
+			cache[key] = *bitmap;
+			Retain(type, key, *bitmap, true);
+		});
+}
+
+Cache::Stats Cache::GetStats() {
+	Stats result = stats;
+
+	result.retained_bytes = 0;
+	for (Retention const& r : retention) {
+		result.retained_bytes += r.bytes;
+	}
+
+	return result;
+}
+
+void Cache::SetRetentionBudget(size_t bytes) {
+	retention_budget = bytes;
+
+	for (int i = 0; i < Material::END; ++i) {
+		Evict(retention[i], GetRetentionBudget(static_cast<Material::Type>(i)));
+	}
+}
+
 void Cache::SetSystemName(std::string const& filename) {
 	system_name = filename;
 }
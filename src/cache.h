@@ -19,6 +19,7 @@
 #define _CACHE_H_
 
 // Headers
+#include <functional>
 #include <string>
 
 #include "system.h"
@@ -52,6 +53,81 @@ namespace Cache {
 
 	void Clear();
 
+	/**
+	 * Prepares decoding an image on a worker thread.
+	 * The returned function only reads the file and decodes it. It
+	 * returns an empty bitmap when the file is no supported image.
+	 * Pass its result to AddDecoded, also when it is empty, so the image
+	 * is no longer considered in progress.
+	 *
+	 * @param directory image directory (e.g. "CharSet").
+	 * @param file image name.
+	 * @return decoding function, empty when the directory holds no
+	 *         images, the file does not exist or the image is already
+	 *         decoded or being decoded.
+	 */
+	std::function<BitmapRef()> PrepareDecode(const std::string& directory, const std::string& file);
+
+	/**
+	 * Keeps an image decoded by a PrepareDecode function until it is
+	 * requested or ReleaseDecoded is called.
+	 *
+	 * @param directory image directory.
+	 * @param file image name.
+	 * @param bitmap decoded image.
+	 */
+	void AddDecoded(const std::string& directory, const std::string& file, BitmapRef bitmap);
+
+	/**
+	 * Hands an image passed to AddDecoded that was not requested yet to
+	 * the recently used images. From then on it counts against the
+	 * retention budget and is dropped like them when nobody requests it.
+	 * Call it after the listeners of the file request ran.
+	 *
+	 * @param directory image directory.
+	 * @param file image name.
+	 */
+	void ReleaseDecoded(const std::string& directory, const std::string& file);
+
+	/**
+	 * Decodes an image on a worker thread and keeps it as least recently
+	 * used image when it fits into the retention budget without dropping
+	 * other images.
+	 * Does nothing when threads are not available.
+	 *
+	 * @param directory image directory.
+	 * @param file image name.
+	 */
+	void Prefetch(const std::string& directory, const std::string& file);
+
+	/** Counters for tuning the retention budget. */
+	struct Stats {
+		/** Requests served by an already decoded image. */
+		int hits;
+		/** Requests that decoded the image. */
+		int misses;
+		/** Images dropped from the recently used ones to stay within the budget. */
+		int evictions;
+		/** Memory held by the recently used images, including those still in use. */
+		size_t retained_bytes;
+	};
+
+	/**
+	 * @return counters since the start.
+	 */
+	Stats GetStats();
+
+	/**
+	 * Sets how much memory the recently used images may occupy.
+	 * They stay decoded while no scene uses them and are dropped least
+	 * recently used first. Images still in use count against the budget
+	 * too but are only freed once unused. The budget is split between
+	 * the image types.
+	 *
+	 * @param bytes budget, 0 drops images as soon as they are unused.
+	 */
+	void SetRetentionBudget(size_t bytes);
+
 	BitmapRef System();
 	void SetSystemName(std::string const& filename);
 }
@@ -0,0 +1,278 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "decoded_image_cache.h"
+#include "system.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#  define DECODED_IMAGE_CACHE_MMAP
+#  include <cstdio>
+#  include <cstring>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  ifdef SUPPORT_THREADS
+#    include <atomic>
+#  endif
+#endif
+
+#ifdef DECODED_IMAGE_CACHE_MMAP
+namespace {
+	/**
+	 * File layout: Header, source path, tile opacity values, padding,
+	 * pixels at pixel_offset. Values are stored in native byte order,
+	 * the cache is only valid on the machine that created it.
+	 */
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		int64_t source_mtime;
+		int64_t source_size;
+		uint32_t variant;
+		uint32_t path_length;
+		uint32_t width;
+		uint32_t height;
+		uint32_t pitch;
+		uint32_t pixman_format;
+		uint32_t tile_rows;
+		uint32_t tile_cols;
+		uint32_t pixel_offset;
+		uint8_t opacity;
+		uint8_t bg_color[4];
+		uint8_t sh_color[4];
+		uint8_t reserved[3];
+	};
+
+	const char magic[4] = { 'E', 'D', 'I', 'C' };
+	constexpr uint32_t version = 1;
+
+	/** Numbers the temporary files of this process. */
+#ifdef SUPPORT_THREADS
+	std::atomic<unsigned> temp_counter(0);
+#else
+	unsigned temp_counter = 0;
+#endif
+
+	/** Pixels start at a multiple of this, suitable for SIMD loads. */
+	constexpr size_t pixel_alignment = 64;
+
+	struct Mapping {
+		void* base;
+		size_t length;
+	};
+
+	std::string directory;
+
+	bool GetSourceInfo(const std::string& source, int64_t& mtime, int64_t& size) {
+		struct stat info;
+		if (stat(source.c_str(), &info) != 0) {
+			return false;
+		}
+		mtime = static_cast<int64_t>(info.st_mtime);
+		size = static_cast<int64_t>(info.st_size);
+		return true;
+	}
+
+	std::string GetEntryPath(const std::string& source, uint32_t variant) {
+		// FNV-1a, the header holds the full path against collisions
+		uint64_t hash = 14695981039346656037ULL;
+		for (char c : source) {
+			hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+		}
+		for (int i = 0; i < 4; ++i) {
+			hash = (hash ^ ((variant >> (i * 8)) & 0xFF)) * 1099511628211ULL;
+		}
+
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.img", static_cast<unsigned long long>(hash));
+		return directory + "/" + name;
+	}
+
+	size_t GetPixelOffset(size_t path_length, size_t tiles) {
+		size_t offset = sizeof(Header) + path_length + tiles;
+		return (offset + pixel_alignment - 1) / pixel_alignment * pixel_alignment;
+	}
+
+	bool WriteAll(int fd, const void* data, size_t length) {
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		while (length > 0) {
+			ssize_t written = write(fd, p, length);
+			if (written <= 0) {
+				return false;
+			}
+			p += written;
+			length -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+}
+
+bool DecodedImageCache::IsAvailable() {
+	return true;
+}
+
+void DecodedImageCache::SetDirectory(const std::string& dir) {
+	directory = dir;
+}
+
+bool DecodedImageCache::IsEnabled() {
+	return !directory.empty();
+}
+
+bool DecodedImageCache::Load(const std::string& source, uint32_t variant, Entry& entry, void*& mapping) {
+	int64_t mtime;
+	int64_t size;
+	if (!GetSourceInfo(source, mtime, size)) {
+		return false;
+	}
+
+	int fd = open(GetEntryPath(source, variant).c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+		close(fd);
+		return false;
+	}
+
+	size_t length = static_cast<size_t>(info.st_size);
+
+	// Private mapping: writes to the bitmap never reach the file
+	void* base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		return false;
+	}
+
+	const Header& header = *static_cast<const Header*>(base);
+	const char* path = static_cast<const char*>(base) + sizeof(Header);
+	size_t tiles = static_cast<size_t>(header.tile_rows) * header.tile_cols;
+
+	bool valid = memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+		header.version == version &&
+		header.source_mtime == mtime &&
+		header.source_size == size &&
+		header.variant == variant &&
+		header.path_length == source.size() &&
+		header.pixel_offset == GetPixelOffset(header.path_length, tiles) &&
+		header.pitch % 4 == 0 &&
+		length >= header.pixel_offset + static_cast<size_t>(header.pitch) * header.height &&
+		source.compare(0, std::string::npos, path, header.path_length) == 0;
+
+	if (!valid) {
+		munmap(base, length);
+		return false;
+	}
+
+	entry.width = static_cast<int>(header.width);
+	entry.height = static_cast<int>(header.height);
+	entry.pitch = static_cast<int>(header.pitch);
+	entry.pixman_format = header.pixman_format;
+	entry.opacity = header.opacity;
+	entry.tile_rows = static_cast<int>(header.tile_rows);
+	entry.tile_cols = static_cast<int>(header.tile_cols);
+	entry.tile_opacity.assign(path + header.path_length, path + header.path_length + tiles);
+	memcpy(entry.bg_color, header.bg_color, sizeof(entry.bg_color));
+	memcpy(entry.sh_color, header.sh_color, sizeof(entry.sh_color));
+	entry.pixels = static_cast<uint8_t*>(base) + header.pixel_offset;
+
+	mapping = new Mapping{base, length};
+
+	return true;
+}
+
+void DecodedImageCache::Release(void* mapping) {
+	Mapping* m = static_cast<Mapping*>(mapping);
+	munmap(m->base, m->length);
+	delete m;
+}
+
+void DecodedImageCache::Store(const std::string& source, uint32_t variant, const Entry& entry) {
+	Header header = {};
+	if (!GetSourceInfo(source, header.source_mtime, header.source_size)) {
+		return;
+	}
+
+	size_t tiles = entry.tile_opacity.size();
+
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.variant = variant;
+	header.path_length = static_cast<uint32_t>(source.size());
+	header.width = static_cast<uint32_t>(entry.width);
+	header.height = static_cast<uint32_t>(entry.height);
+	header.pitch = static_cast<uint32_t>(entry.pitch);
+	header.pixman_format = entry.pixman_format;
+	header.tile_rows = static_cast<uint32_t>(entry.tile_rows);
+	header.tile_cols = static_cast<uint32_t>(entry.tile_cols);
+	header.pixel_offset = static_cast<uint32_t>(GetPixelOffset(source.size(), tiles));
+	header.opacity = entry.opacity;
+	memcpy(header.bg_color, entry.bg_color, sizeof(header.bg_color));
+	memcpy(header.sh_color, entry.sh_color, sizeof(header.sh_color));
+
+	// Images are decoded on several threads and several players can share
+	// the directory, write to a private file and rename it so readers
+	// never see a partial entry
+	std::string path = GetEntryPath(source, variant);
+	std::string temp_path = path + "." + std::to_string(static_cast<long>(getpid())) +
+		"-" + std::to_string(temp_counter++) + ".tmp";
+
+	int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return;
+	}
+
+	std::vector<uint8_t> padding(header.pixel_offset - sizeof(Header) - source.size() - tiles);
+
+	bool ok = WriteAll(fd, &header, sizeof(header)) &&
+		WriteAll(fd, source.data(), source.size()) &&
+		(tiles == 0 || WriteAll(fd, entry.tile_opacity.data(), tiles)) &&
+		(padding.empty() || WriteAll(fd, padding.data(), padding.size())) &&
+		WriteAll(fd, entry.pixels, static_cast<size_t>(entry.pitch) * entry.height);
+
+	ok = close(fd) == 0 && ok;
+
+	if (!ok || rename(temp_path.c_str(), path.c_str()) != 0) {
+		unlink(temp_path.c_str());
+	}
+}
+#else
+bool DecodedImageCache::IsAvailable() {
+	return false;
+}
+
+void DecodedImageCache::SetDirectory(const std::string& /* dir */) {
+}
+
+bool DecodedImageCache::IsEnabled() {
+	return false;
+}
+
+bool DecodedImageCache::Load(const std::string& /* source */, uint32_t /* variant */, Entry& /* entry */, void*& /* mapping */) {
+	return false;
+}
+
+void DecodedImageCache::Release(void* /* mapping */) {
+}
+
+void DecodedImageCache::Store(const std::string& /* source */, uint32_t /* variant */, const Entry& /* entry */) {
+}
+#endif
@@ -0,0 +1,99 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DECODED_IMAGE_CACHE_H_
+#define _DECODED_IMAGE_CACHE_H_
+
+// Headers
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Stores decoded and converted images on disk so that a later launch can
+ * map the pixels directly instead of decoding the file again.
+ * Entries are keyed by the source path and validated against its
+ * modification time and size.
+ * Only available on platforms with mmap.
+ */
+namespace DecodedImageCache {
+	/** Pixels and the metadata Bitmap computes after decoding. */
+	struct Entry {
+		int width = 0;
+		int height = 0;
+		int pitch = 0;
+		uint32_t pixman_format = 0;
+		uint8_t opacity = 0;
+		int tile_rows = 0;
+		int tile_cols = 0;
+		/** tile_rows * tile_cols values, row by row. */
+		std::vector<uint8_t> tile_opacity;
+		uint8_t bg_color[4] = {};
+		uint8_t sh_color[4] = {};
+		/** Pixel data, pitch * height bytes. */
+		void* pixels = nullptr;
+	};
+
+	/**
+	 * @return whether the platform supports the cache.
+	 */
+	bool IsAvailable();
+
+	/**
+	 * Sets the directory the entries are stored in.
+	 *
+	 * @param directory existing directory, empty disables the cache.
+	 */
+	void SetDirectory(const std::string& directory);
+
+	/**
+	 * @return whether a directory is set.
+	 */
+	bool IsEnabled();
+
+	/**
+	 * Maps a stored image.
+	 * The pixels stay valid until the mapping is released and may be
+	 * written to, changes are not stored.
+	 *
+	 * @param source image file.
+	 * @param variant distinguishes different conversions of the file.
+	 * @param entry receives the image.
+	 * @param mapping receives the handle for Release.
+	 * @return whether a valid entry was found.
+	 */
+	bool Load(const std::string& source, uint32_t variant, Entry& entry, void*& mapping);
+
+	/**
+	 * Releases a mapping returned by Load.
+	 *
+	 * @param mapping handle.
+	 */
+	void Release(void* mapping);
+
+	/**
+	 * Stores an image. Errors are ignored, the cache is only an
+	 * optimization.
+	 *
+	 * @param source image file.
+	 * @param variant distinguishes different conversions of the file.
+	 * @param entry image to store.
+	 */
+	void Store(const std::string& source, uint32_t variant, const Entry& entry);
+}
+
+#endif
@@ -20,6 +20,7 @@
 #ifdef WANT_FMMIDI
 
 // Headers
+#include <algorithm>
 #include <cassert>
 #include "audio_decoder.h"
 #include "output.h"
@@ -91,12 +92,31 @@ int FmMidiDecoder::GetTicks() {
 
 int FmMidiDecoder::FillBuffer(uint8_t* buffer, int length) {
 	size_t samples = (size_t)length / sizeof(int_least16_t) / 2;
-
-	double delta = (double)samples / (frequency * pitch);
-
-	seq->play(mtime, this);
-	synthesize(reinterpret_cast<int_least16_t*>(buffer), samples, frequency * pitch);
-	mtime += delta;
+	int_least16_t* output = reinterpret_cast<int_least16_t*>(buffer);
+
+	double rate = frequency * pitch;
+	double start = mtime;
+	size_t done = 0;
+
+	// Synthesize up to each event, so events land on their sample
+	// instead of on the buffer boundary
+	while (done < samples) {
+		seq->play(mtime, this);
+
+		// The next event is due at the first sample after its time
+		double until_next = (seq->get_next_time() - mtime) * rate;
+		size_t count = samples - done;
+		if (until_next < (double)count) {
+			// Negative when float rounding kept the event from being sent
+			count = (size_t)std::max(until_next, 0.0) + 1;
+		}
+
+		synthesize(output + done * 2, count, rate);
+		done += count;
+
+		// Derived from the start to avoid accumulating rounding errors
+		mtime = start + done / rate;
+	}
 
 	return length;
 }
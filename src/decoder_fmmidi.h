@@ -63,9 +63,11 @@ private:
 	void meta_event(int, const void*, std::size_t) override;
 	void reset() override;
 
+	// The notes of synth live in the pool of note_factory,
+	// so note_factory must be destroyed last
+	std::unique_ptr<midisynth::fm_note_factory> note_factory;
 	std::unique_ptr<midisequencer::sequencer> seq;
 	std::unique_ptr<midisynth::synthesizer> synth;
-	std::unique_ptr<midisynth::fm_note_factory> note_factory;
 	midisynth::DRUMPARAMETER p;
 	void load_programs();
 };
@@ -18,6 +18,11 @@
 #ifndef _DRAWABLE_H_
 #define _DRAWABLE_H_
 
+#include <cstddef>
+
+class DrawableList;
+class Rect;
+
 // What kind of drawable is the current one?
 enum DrawableType {
 	TypeWindow,
@@ -45,6 +50,27 @@ public:
 	virtual DrawableType GetType() const = 0;
 
 	virtual bool IsGlobal() const { return false; }
+
+	/**
+	 * Reports the screen area that changes when the drawable is
+	 * drawn now compared to its last Draw call.
+	 * Used by Graphics to only repaint damaged parts of the screen.
+	 *
+	 * @param damage receives the changed area, empty when unchanged.
+	 * @return false when the change is unknown and the whole
+	 *         screen must be repainted.
+	 */
+	virtual bool GetDamage(Rect& /* damage */) { return false; }
+
+private:
+	friend class DrawableList;
+
+	/** List the drawable is registered in, managed by DrawableList. */
+	DrawableList* list = nullptr;
+	/** Position in the list. */
+	size_t list_index = 0;
+	/** Z changed since the list was sorted. */
+	bool z_dirty = false;
 };
 
 #endif
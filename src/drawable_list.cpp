@@ -0,0 +1,168 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "drawable_list.h"
+#include "drawable.h"
+
+DrawableList::DrawableList() :
+	size(0),
+	dirty(false) {
+}
+
+DrawableList::~DrawableList() {
+	Clear();
+}
+
+void DrawableList::Append(Drawable* drawable) {
+	Remove(drawable);
+
+	drawable->list = this;
+	drawable->list_index = entries.size();
+	drawable->z_dirty = true;
+
+	Entry entry = { drawable, 0, 0 };
+	entries.push_back(entry);
+
+	++size;
+	dirty = true;
+}
+
+void DrawableList::Remove(Drawable* drawable) {
+	DrawableList* list = drawable->list;
+	if (!list) {
+		return;
+	}
+
+	// The hole is closed by the next Sort
+	list->entries[drawable->list_index].drawable = nullptr;
+	list->dirty = true;
+	--list->size;
+
+	drawable->list = nullptr;
+	drawable->z_dirty = false;
+}
+
+void DrawableList::UpdateZ(Drawable* drawable) {
+	DrawableList* list = drawable->list;
+	if (!list) {
+		return;
+	}
+
+	drawable->z_dirty = true;
+	list->dirty = true;
+}
+
+void DrawableList::Sort() {
+	if (!dirty) {
+		return;
+	}
+
+	// Take out moved drawables and close the holes of removed ones.
+	// The rest stays ordered.
+	moved.clear();
+	size_t count = 0;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		Entry entry = entries[i];
+		if (!entry.drawable) {
+			continue;
+		}
+		entry.order = i;
+		if (entry.drawable->z_dirty) {
+			moved.push_back(entry);
+		} else {
+			entries[count++] = entry;
+		}
+	}
+	entries.resize(count);
+
+	if (!moved.empty()) {
+		// Same as a stable sort of the whole list by Z
+		auto const compare = [](Entry const& first, Entry const& second) {
+			return first.z < second.z || (first.z == second.z && first.order < second.order);
+		};
+
+		for (Entry& entry : moved) {
+			entry.z = entry.drawable->GetZ();
+			entry.drawable->z_dirty = false;
+		}
+		std::sort(moved.begin(), moved.end(), compare);
+
+		entries.insert(entries.end(), moved.begin(), moved.end());
+		std::inplace_merge(entries.begin(), entries.begin() + count, entries.end(), compare);
+	}
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entries[i].drawable->list_index = i;
+	}
+
+	dirty = false;
+}
+
+void DrawableList::Clear() {
+	for (Entry const& entry : entries) {
+		if (entry.drawable) {
+			entry.drawable->list = nullptr;
+			entry.drawable->z_dirty = false;
+		}
+	}
+
+	entries.clear();
+	size = 0;
+	dirty = false;
+}
+
+size_t DrawableList::GetSize() const {
+	return size;
+}
+
+DrawableList::Iterator::Iterator(DrawableList const* list, size_t index) :
+	list(list),
+	index(index) {
+	SkipRemoved();
+}
+
+Drawable* DrawableList::Iterator::operator*() const {
+	return list->entries[index].drawable;
+}
+
+DrawableList::Iterator& DrawableList::Iterator::operator++() {
+	++index;
+	SkipRemoved();
+	return *this;
+}
+
+bool DrawableList::Iterator::operator!=(Iterator const& other) const {
+	// The end is checked against the current size, drawables appended
+	// while iterating are visited as well
+	return index < list->entries.size() && index != other.index;
+}
+
+void DrawableList::Iterator::SkipRemoved() {
+	while (index < list->entries.size() && !list->entries[index].drawable) {
+		++index;
+	}
+}
+
+DrawableList::Iterator DrawableList::begin() const {
+	return Iterator(this, 0);
+}
+
+DrawableList::Iterator DrawableList::end() const {
+	return Iterator(this, static_cast<size_t>(-1));
+}
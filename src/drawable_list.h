@@ -0,0 +1,123 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DRAWABLE_LIST_H_
+#define _DRAWABLE_LIST_H_
+
+// Headers
+#include <cstddef>
+#include <vector>
+
+class Drawable;
+
+/**
+ * Z ordered registry of drawables.
+ * Drawables are stored contiguously and know their position, which makes
+ * removal O(1). Sort only moves the drawables that were appended or whose
+ * Z changed since the last call and merges them into the ordered rest.
+ */
+class DrawableList {
+public:
+	DrawableList();
+
+	/**
+	 * Destructor.
+	 * Unregisters all remaining drawables.
+	 */
+	~DrawableList();
+
+	/**
+	 * Registers a drawable, it is ordered by the next Sort call.
+	 *
+	 * @param drawable drawable to add.
+	 */
+	void Append(Drawable* drawable);
+
+	/**
+	 * Unregisters a drawable from the list it belongs to.
+	 * Does nothing when it is not registered.
+	 *
+	 * @param drawable drawable to remove.
+	 */
+	static void Remove(Drawable* drawable);
+
+	/**
+	 * Marks a drawable for reordering by the next Sort call of the
+	 * list it belongs to.
+	 *
+	 * @param drawable drawable whose Z changed.
+	 */
+	static void UpdateZ(Drawable* drawable);
+
+	/**
+	 * Restores the Z order. Drawables with the same Z keep their
+	 * relative order, appended ones are placed after them.
+	 */
+	void Sort();
+
+	/**
+	 * Unregisters all drawables.
+	 */
+	void Clear();
+
+	/**
+	 * @return amount of registered drawables.
+	 */
+	size_t GetSize() const;
+
+	/**
+	 * Iterates the registered drawables in list order.
+	 * Stays valid when drawables are added or removed meanwhile.
+	 */
+	class Iterator {
+	public:
+		Iterator(DrawableList const* list, size_t index);
+
+		Drawable* operator*() const;
+		Iterator& operator++();
+		bool operator!=(Iterator const& other) const;
+
+	private:
+		void SkipRemoved();
+
+		DrawableList const* list;
+		size_t index;
+	};
+
+	Iterator begin() const;
+	Iterator end() const;
+
+private:
+	struct Entry {
+		Drawable* drawable;
+		/** Z when the drawable was ordered. */
+		int z;
+		/** Position before Sort, keeps the order of equal Z. */
+		size_t order;
+	};
+
+	/** Ordered drawables, removed ones are NULL until the next Sort. */
+	std::vector<Entry> entries;
+
+	/** Drawables reordered by Sort, kept to reuse the memory. */
+	std::vector<Entry> moved;
+
+	size_t size;
+	bool dirty;
+};
+
+#endif
@@ -16,8 +16,11 @@
  */
 
 // Headers
+#include <algorithm>
 #include <cmath>
+#include <vector>
 #include "bitmap.h"
+#include "bitmap_kernels.h"
 
 // Rotate, Zoom, Opacity
 void Bitmap::EffectsBlit(const Matrix &fwd, Bitmap const& src, Rect const& src_rect, Opacity const& opacity) {
@@ -130,3 +133,107 @@ void Bitmap::EffectsBlit(int x, int y, int ox, int oy, Bitmap const& src, Rect c
 	else
 		Blit(x - ox, y - oy, *draw, src_rect, opacity);
 }
+
+// Flash, Tone, Flip, Opacity
+void Bitmap::EffectsBlit(int x, int y, int ox, int oy,
+						   Bitmap const& src, Rect const& src_rect_,
+						   Opacity const& opacity, const Tone& tone, const Color& flash,
+						   bool flip_x, bool flip_y) {
+	bool tone_change = tone != Tone();
+	bool flash_change = flash.alpha != 0;
+
+	if (!tone_change && !flash_change && !flip_x && !flip_y) {
+		Blit(x - ox, y - oy, src, src_rect_, opacity);
+		return;
+	}
+
+	if (opacity.IsTransparent())
+		return;
+
+	Rect src_rect = src_rect_;
+	src_rect.Adjust(src.GetWidth(), src.GetHeight());
+
+	Rect const full_rect(x - ox, y - oy, src_rect.width, src_rect.height);
+	Rect dst_rect = full_rect;
+	dst_rect.Adjust(GetRect());
+	if (dst_rect.IsEmpty())
+		return;
+
+	// Source columns of the visible part
+	int skip_left = dst_rect.x - full_rect.x;
+	int src_x = flip_x
+		? src_rect.x + src_rect.width - skip_left - dst_rect.width
+		: src_rect.x + skip_left;
+
+	// Effects are applied to one row at a time, which stays in the cache
+	// until it is composited
+	std::vector<uint32_t> pixels(dst_rect.width);
+	Bitmap row(reinterpret_cast<void*>(&pixels.front()), dst_rect.width, 1, dst_rect.width * 4, pixel_format);
+
+	BitmapKernels::FlashParams flash_params;
+	flash_params.r_shift = pixel_format.r.shift;
+	flash_params.g_shift = pixel_format.g.shift;
+	flash_params.b_shift = pixel_format.b.shift;
+	flash_params.a_shift = pixel_format.a.shift;
+	// Same precision as the solid fill used by BlendBlit
+	flash_params.red = (flash.red * flash.alpha) >> 8;
+	flash_params.green = (flash.green * flash.alpha) >> 8;
+	flash_params.blue = (flash.blue * flash.alpha) >> 8;
+	flash_params.alpha = flash.alpha;
+
+	BitmapKernels::ToneParams tone_params;
+	GetToneParams(tone, true, tone_params);
+	BitmapKernels::ToneFunc const tone_row = BitmapKernels::GetToneKernel();
+
+	// Rows in the bottom opacity.split rows use the bottom opacity
+	int split_row = opacity.IsSplit() ? src_rect.height - opacity.split : src_rect.height;
+
+	pixman_image_t* masks[2] = { (pixman_image_t*) NULL, (pixman_image_t*) NULL };
+	int values[2] = { opacity.top, opacity.IsSplit() ? opacity.bottom : opacity.top };
+	for (int i = 0; i < 2; ++i) {
+		if (values[i] > 0 && values[i] < 255) {
+			pixman_color_t tcolor = {0, 0, 0, static_cast<uint16_t>(values[i] << 8)};
+			masks[i] = pixman_image_create_solid_fill(&tcolor);
+		}
+	}
+
+	for (int dst_y = dst_rect.y; dst_y < dst_rect.y + dst_rect.height; ++dst_y) {
+		int offset = dst_y - full_rect.y;
+		int section = offset < split_row ? 0 : 1;
+		if (values[section] <= 0) {
+			continue;
+		}
+
+		int src_y = flip_y ? src_rect.y + src_rect.height - 1 - offset : src_rect.y + offset;
+
+		pixman_image_composite32(PIXMAN_OP_SRC,
+								 src.bitmap, (pixman_image_t*) NULL, row.bitmap,
+								 src_x, src_y,
+								 0, 0,
+								 0, 0,
+								 dst_rect.width, 1);
+
+		if (flip_x)
+			std::reverse(pixels.begin(), pixels.end());
+
+		if (flash_change)
+			BitmapKernels::Flash(&pixels.front(), dst_rect.width, flash_params);
+
+		if (tone_change)
+			tone_row(&pixels.front(), dst_rect.width, tone_params);
+
+		pixman_image_composite32(src.GetOperator(masks[section]),
+								 row.bitmap, masks[section], bitmap,
+								 0, 0,
+								 0, 0,
+								 dst_rect.x, dst_y,
+								 dst_rect.width, 1);
+	}
+
+	for (int i = 0; i < 2; ++i) {
+		if (masks[i] != NULL)
+			pixman_image_unref(masks[i]);
+	}
+
+	RefreshCallback();
+}
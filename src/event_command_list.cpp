@@ -0,0 +1,172 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <cassert>
+#include <string>
+#include "event_command_list.h"
+#include "event_jump_table.h"
+#include "command_codes.h"
+#include "player.h"
+#include "reader_lcf.h"
+#include "reader_util.h"
+
+namespace {
+	const std::vector<RPG::EventCommand> empty_commands;
+
+	// Move routes are stored as a stream of variable length integers
+	int DecodeInt(std::vector<int>::const_iterator& it) {
+		int value = 0;
+
+		for (;;) {
+			int x = *it++;
+			value <<= 7;
+			value |= x & 0x7F;
+			if (!(x & 0x80))
+				break;
+		}
+
+		return value;
+	}
+
+	std::string DecodeString(std::vector<int>::const_iterator& it) {
+		std::string out;
+		int len = DecodeInt(it);
+
+		for (int i = 0; i < len; i++)
+			out += (char) *it++;
+
+		return ReaderUtil::Recode(out, Player::encoding);
+	}
+
+	RPG::MoveCommand DecodeMove(std::vector<int>::const_iterator& it) {
+		RPG::MoveCommand cmd;
+		cmd.command_id = *it++;
+
+		switch (cmd.command_id) {
+		case 32:	// Switch ON
+		case 33:	// Switch OFF
+			cmd.parameter_a = DecodeInt(it);
+			break;
+		case 34:	// Change Graphic
+			cmd.parameter_string = DecodeString(it);
+			cmd.parameter_a = DecodeInt(it);
+			break;
+		case 35:	// Play Sound Effect
+			cmd.parameter_string = DecodeString(it);
+			cmd.parameter_a = DecodeInt(it);
+			cmd.parameter_b = DecodeInt(it);
+			cmd.parameter_c = DecodeInt(it);
+			break;
+		}
+
+		return cmd;
+	}
+
+	RPG::MoveRoute DecodeMoveRoute(const RPG::EventCommand& com) {
+		RPG::MoveRoute route;
+		route.repeat = com.parameters[2] != 0;
+		route.skippable = com.parameters[3] != 0;
+
+		std::vector<int>::const_iterator it;
+		for (it = com.parameters.begin() + 4; it < com.parameters.end(); )
+			route.move_commands.push_back(DecodeMove(it));
+
+		return route;
+	}
+
+	// Taken from readers because a kitten is killed when reader_structs is included
+	int GetEventCommandSize(const std::vector<RPG::EventCommand>& commands) {
+		std::vector<RPG::EventCommand>::const_iterator it;
+
+		int result = 0;
+		for (it = commands.begin(); it != commands.end(); ++it) {
+			result += LcfReader::IntSize(it->code);
+			result += LcfReader::IntSize(it->indent);
+			result += LcfReader::IntSize(it->string.size());
+			result += ReaderUtil::Recode(it->string, Player::encoding).size();
+
+			int count = it->parameters.size();
+			result += LcfReader::IntSize(count);
+			for (int i = 0; i < count; i++)
+				result += LcfReader::IntSize(it->parameters[i]);
+		}
+		result += 4; // No idea why but then it fits
+
+		return result;
+	}
+}
+
+EventCommandList::EventCommandList() {
+}
+
+EventCommandList::EventCommandList(const std::vector<RPG::EventCommand>& commands) {
+	if (!commands.empty()) {
+		data = std::make_shared<Data>();
+		data->commands = commands;
+
+		for (size_t i = 0; i < commands.size(); ++i) {
+			if (commands[i].code == Cmd::MoveEvent && commands[i].parameters.size() >= 4) {
+				data->move_routes[i] = DecodeMoveRoute(commands[i]);
+			}
+		}
+	}
+}
+
+void EventCommandList::clear() {
+	data.reset();
+}
+
+const std::vector<RPG::EventCommand>& EventCommandList::GetCommands() const {
+	return data ? data->commands : empty_commands;
+}
+
+const EventJumpTable& EventCommandList::GetJumpTable() const {
+	static const EventJumpTable empty_jump_table(empty_commands);
+
+	if (!data) {
+		return empty_jump_table;
+	}
+
+	if (!data->jump_table) {
+		data->jump_table.reset(new EventJumpTable(data->commands));
+	}
+	return *data->jump_table;
+}
+
+int EventCommandList::GetSaveSize() const {
+	if (!data) {
+		return GetEventCommandSize(empty_commands);
+	}
+
+	if (data->save_size < 0) {
+		data->save_size = GetEventCommandSize(data->commands);
+	}
+	return data->save_size;
+}
+
+const RPG::MoveRoute& EventCommandList::GetMoveRoute(size_t index) const {
+	static const RPG::MoveRoute empty_route;
+
+	if (!data) {
+		return empty_route;
+	}
+
+	auto it = data->move_routes.find(index);
+	assert(it != data->move_routes.end());
+	return it == data->move_routes.end() ? empty_route : it->second;
+}
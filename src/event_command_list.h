@@ -0,0 +1,125 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EVENT_COMMAND_LIST_H_
+#define _EVENT_COMMAND_LIST_H_
+
+// Headers
+#include <cassert>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "rpg_eventcommand.h"
+#include "rpg_moveroute.h"
+
+class EventJumpTable;
+
+/**
+ * Immutable event command list.
+ * Copies of an EventCommandList share the commands and their jump
+ * table, so interpreters can start the same list over and over without
+ * copying it. The commands are only copied when a list is created from
+ * a std::vector, that is also when operands needing decoding at run time
+ * are compiled.
+ */
+class EventCommandList {
+public:
+	/**
+	 * Constructs an empty list.
+	 */
+	EventCommandList();
+
+	/**
+	 * Constructs a list from a copy of commands.
+	 *
+	 * @param commands event commands.
+	 */
+	explicit EventCommandList(const std::vector<RPG::EventCommand>& commands);
+
+	/**
+	 * Gets a command.
+	 *
+	 * @param index command index, must be less than size().
+	 * @return command.
+	 */
+	const RPG::EventCommand& operator[](size_t index) const;
+
+	/** @return number of commands. */
+	size_t size() const;
+
+	/** @return whether there are no commands. */
+	bool empty() const;
+
+	/**
+	 * Releases the shared commands, the list is empty afterwards.
+	 */
+	void clear();
+
+	/** @return the commands. */
+	const std::vector<RPG::EventCommand>& GetCommands() const;
+
+	/**
+	 * Gets the jump table of the commands.
+	 * It is built on the first call and shared by all copies.
+	 *
+	 * @return jump table.
+	 */
+	const EventJumpTable& GetJumpTable() const;
+
+	/**
+	 * Gets the move route of a Move Event command, decoded when the list
+	 * was created.
+	 *
+	 * @param index index of a Move Event command.
+	 * @return move route.
+	 */
+	const RPG::MoveRoute& GetMoveRoute(size_t index) const;
+
+	/**
+	 * Gets the size of the commands in a save file, the strings are
+	 * stored in the game encoding there.
+	 * It is computed on the first call and shared by all copies.
+	 *
+	 * @return size in bytes.
+	 */
+	int GetSaveSize() const;
+
+private:
+	struct Data {
+		std::vector<RPG::EventCommand> commands;
+		std::unique_ptr<EventJumpTable> jump_table;
+		std::unordered_map<size_t, RPG::MoveRoute> move_routes;
+		int save_size = -1;
+	};
+
+	std::shared_ptr<Data> data;
+};
+
+inline const RPG::EventCommand& EventCommandList::operator[](size_t index) const {
+	assert(data && index < data->commands.size());
+	return data->commands[index];
+}
+
+inline size_t EventCommandList::size() const {
+	return data ? data->commands.size() : 0;
+}
+
+inline bool EventCommandList::empty() const {
+	return !data;
+}
+
+#endif
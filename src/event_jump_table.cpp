@@ -0,0 +1,115 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include "event_jump_table.h"
+#include "command_codes.h"
+
+EventJumpTable::EventJumpTable(const std::vector<RPG::EventCommand>& list) :
+	list(list) {
+	int size = static_cast<int>(list.size());
+	int max_indent = 0;
+	for (const RPG::EventCommand& com : list) {
+		max_indent = std::max(max_indent, com.indent);
+	}
+
+	next_sibling.assign(size, size);
+	block_end.assign(size, size);
+	loop_target.assign(size, -1);
+
+	// Backwards: the next command per indent level
+	std::vector<int> next_at(max_indent + 1, size);
+	std::vector<int> next_end_loop(max_indent + 1, size);
+	for (int i = size - 1; i >= 0; --i) {
+		int indent = std::max(list[i].indent, 0);
+
+		for (int level = 0; level <= indent; ++level) {
+			next_sibling[i] = std::min(next_sibling[i], next_at[level]);
+			if (level < indent) {
+				block_end[i] = std::min(block_end[i], next_at[level]);
+			}
+		}
+
+		if (list[i].code == Cmd::BreakLoop) {
+			int target = size;
+			for (int level = 0; level < indent; ++level) {
+				target = std::min(target, next_end_loop[level]);
+			}
+			loop_target[i] = target;
+		}
+
+		next_at[indent] = i;
+		if (list[i].code == Cmd::EndLoop) {
+			next_end_loop[indent] = i;
+		}
+	}
+
+	// Forwards: the last Loop per indent level, -1 once a lower indent
+	// closed the level
+	std::vector<int> last_loop(max_indent + 1, size);
+	for (int i = 0; i < size; ++i) {
+		int indent = std::max(list[i].indent, 0);
+
+		if (list[i].code == Cmd::EndLoop) {
+			loop_target[i] = last_loop[indent];
+		}
+
+		std::fill(last_loop.begin() + indent + 1, last_loop.end(), -1);
+
+		if (list[i].code == Cmd::Loop) {
+			last_loop[indent] = i;
+		} else if (list[i].code == Cmd::Label && !list[i].parameters.empty()) {
+			labels.insert(std::make_pair(list[i].parameters[0], i));
+		}
+	}
+}
+
+int EventJumpTable::Find(int index, int code, int code2, int indent) const {
+	int size = static_cast<int>(list.size());
+	int idx = index;
+
+	while (idx < size) {
+		const RPG::EventCommand& com = list[idx];
+		if (com.indent < indent) {
+			return -1;
+		}
+
+		if (com.indent > indent) {
+			idx = block_end[idx];
+		} else if (com.code == code || com.code == code2) {
+			return idx;
+		} else {
+			idx = next_sibling[idx];
+		}
+	}
+
+	return size;
+}
+
+int EventJumpTable::GetLoopStart(int index) const {
+	return loop_target[index];
+}
+
+int EventJumpTable::GetLoopBreak(int index) const {
+	return loop_target[index];
+}
+
+int EventJumpTable::GetLabel(int label_id) const {
+	auto it = labels.find(label_id);
+	return it == labels.end() ? -1 : it->second;
+}
@@ -0,0 +1,92 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EVENT_JUMP_TABLE_H_
+#define _EVENT_JUMP_TABLE_H_
+
+// Headers
+#include <unordered_map>
+#include <vector>
+#include "rpg_eventcommand.h"
+
+/**
+ * Precomputed control flow of an event command list.
+ * Answers the searches of the interpreter (skipping to else and end
+ * branches, choice options, loop starts, loop breaks and labels) without
+ * scanning the list, the results are identical to a linear scan.
+ */
+class EventJumpTable {
+public:
+	/**
+	 * Analyses a command list.
+	 *
+	 * @param list command list, must outlive the table and stay unchanged.
+	 */
+	explicit EventJumpTable(const std::vector<RPG::EventCommand>& list);
+
+	/**
+	 * Searches the first command starting at index with code or code2
+	 * at the given indent, skipping all deeper commands.
+	 *
+	 * @param index first command to check.
+	 * @param code code to find.
+	 * @param code2 alternative code to find.
+	 * @param indent indent of the command.
+	 * @return index of the command, -1 when a command with a lower
+	 *         indent comes first, list size when not found.
+	 */
+	int Find(int index, int code, int code2, int indent) const;
+
+	/**
+	 * Gets the Loop command an EndLoop jumps back to.
+	 *
+	 * @param index index of the EndLoop.
+	 * @return index of the Loop, -1 when a command with a lower indent
+	 *         comes first, list size when the list start is reached.
+	 */
+	int GetLoopStart(int index) const;
+
+	/**
+	 * Gets the EndLoop command a BreakLoop jumps to.
+	 *
+	 * @param index index of the BreakLoop.
+	 * @return index of the EndLoop or list size when there is none.
+	 */
+	int GetLoopBreak(int index) const;
+
+	/**
+	 * Gets the first Label command with an ID.
+	 *
+	 * @param label_id label ID.
+	 * @return index of the Label or -1 when there is none.
+	 */
+	int GetLabel(int label_id) const;
+
+private:
+	const std::vector<RPG::EventCommand>& list;
+
+	/** Next command with the same or a lower indent. */
+	std::vector<int> next_sibling;
+	/** Next command with a lower indent. */
+	std::vector<int> block_end;
+	/** Loop start of EndLoop, loop end of BreakLoop. */
+	std::vector<int> loop_target;
+
+	std::unordered_map<int, int> labels;
+};
+
+#endif
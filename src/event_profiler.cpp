@@ -0,0 +1,212 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "event_profiler.h"
+
+#ifdef ENABLE_EVENT_PROFILER
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <vector>
+#include "filefinder.h"
+#include "main_data.h"
+#include "output.h"
+
+namespace {
+	struct Counter {
+		uint64_t executions = 0;
+		std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+		int limit_hits = 0;
+	};
+
+	struct SourceCounter {
+		Counter total;
+		std::map<int, Counter> commands;
+	};
+
+	// Key: type, map ID, event ID
+	typedef std::tuple<int, int, int> SourceKey;
+
+	std::map<SourceKey, SourceCounter> sources;
+
+	SourceKey MakeKey(const EventProfiler::Source& source) {
+		return SourceKey(source.type, source.type == EventProfiler::Source_MapEvent ? source.map_id : 0, source.id);
+	}
+
+	const char* GetTypeName(int type) {
+		switch (type) {
+			case EventProfiler::Source_MapEvent:
+				return "map";
+			case EventProfiler::Source_CommonEvent:
+				return "common";
+			default:
+				return "other";
+		}
+	}
+
+	double ToMs(std::chrono::steady_clock::duration time) {
+		return std::chrono::duration<double, std::milli>(time).count();
+	}
+
+	std::string GetSourceName(const SourceKey& key) {
+		std::ostringstream name;
+		switch (std::get<0>(key)) {
+			case EventProfiler::Source_MapEvent:
+				name << "Map" << std::get<1>(key) << " EV" << std::get<2>(key);
+				break;
+			case EventProfiler::Source_CommonEvent:
+				name << "CE" << std::get<2>(key);
+				break;
+			default:
+				name << "Other";
+		}
+		return name.str();
+	}
+
+	std::vector<std::map<SourceKey, SourceCounter>::const_iterator> SortByTime() {
+		std::vector<std::map<SourceKey, SourceCounter>::const_iterator> sorted;
+		for (auto it = sources.cbegin(); it != sources.cend(); ++it) {
+			sorted.push_back(it);
+		}
+		std::stable_sort(sorted.begin(), sorted.end(),
+			[](std::map<SourceKey, SourceCounter>::const_iterator a, std::map<SourceKey, SourceCounter>::const_iterator b) {
+				return a->second.total.time > b->second.total.time;
+			});
+		return sorted;
+	}
+}
+
+bool EventProfiler::enabled = false;
+
+bool EventProfiler::IsAvailable() {
+	return true;
+}
+
+void EventProfiler::SetEnabled(bool enable) {
+	enabled = enable;
+}
+
+void EventProfiler::AddCommand(const Source& source, int code, std::chrono::steady_clock::duration time) {
+	SourceCounter& counter = sources[MakeKey(source)];
+	counter.total.executions++;
+	counter.total.time += time;
+
+	Counter& command = counter.commands[code];
+	command.executions++;
+	command.time += time;
+}
+
+void EventProfiler::AddLimitHit(const Source& source) {
+	sources[MakeKey(source)].total.limit_hits++;
+}
+
+std::string EventProfiler::GetSummary(int count) {
+	std::ostringstream summary;
+	summary.setf(std::ios::fixed);
+	summary.precision(1);
+
+	for (auto it : SortByTime()) {
+		if (count-- <= 0) {
+			break;
+		}
+		summary << GetSourceName(it->first) << ": " << ToMs(it->second.total.time) << " ms "
+			<< it->second.total.executions << " cmds";
+		if (it->second.total.limit_hits > 0) {
+			summary << " " << it->second.total.limit_hits << " limit";
+		}
+		summary << "\n";
+	}
+
+	return summary.str();
+}
+
+void EventProfiler::Dump() {
+	if (sources.empty()) {
+		return;
+	}
+
+	std::string csv_path = FileFinder::MakePath(Main_Data::GetSavePath(), "event_profile.csv");
+	std::shared_ptr<std::fstream> csv = FileFinder::openUTF8(csv_path, std::ios_base::out | std::ios_base::trunc);
+	std::string json_path = FileFinder::MakePath(Main_Data::GetSavePath(), "event_profile.json");
+	std::shared_ptr<std::fstream> json = FileFinder::openUTF8(json_path, std::ios_base::out | std::ios_base::trunc);
+
+	if (!csv || !json) {
+		Output::Warning("Event profiler: Cannot write %s", csv ? json_path.c_str() : csv_path.c_str());
+		return;
+	}
+
+	// One row per event with code "all", followed by its commands
+	*csv << "type,map_id,event_id,code,executions,time_ms,limit_hits\n";
+	*json << "[\n";
+
+	bool first = true;
+	for (auto it : SortByTime()) {
+		const SourceKey& key = it->first;
+		const SourceCounter& counter = it->second;
+		const char* type = GetTypeName(std::get<0>(key));
+
+		*csv << type << "," << std::get<1>(key) << "," << std::get<2>(key) << ",all,"
+			<< counter.total.executions << "," << ToMs(counter.total.time) << "," << counter.total.limit_hits << "\n";
+
+		*json << (first ? "" : ",\n") << "  {\"type\": \"" << type << "\", \"map_id\": " << std::get<1>(key)
+			<< ", \"event_id\": " << std::get<2>(key) << ", \"executions\": " << counter.total.executions
+			<< ", \"time_ms\": " << ToMs(counter.total.time) << ", \"limit_hits\": " << counter.total.limit_hits
+			<< ", \"commands\": [";
+		first = false;
+
+		bool first_command = true;
+		for (const auto& command : counter.commands) {
+			*csv << type << "," << std::get<1>(key) << "," << std::get<2>(key) << "," << command.first << ","
+				<< command.second.executions << "," << ToMs(command.second.time) << ",0\n";
+
+			*json << (first_command ? "" : ", ") << "{\"code\": " << command.first
+				<< ", \"executions\": " << command.second.executions
+				<< ", \"time_ms\": " << ToMs(command.second.time) << "}";
+			first_command = false;
+		}
+
+		*json << "]}";
+	}
+
+	*json << "\n]\n";
+
+	Output::Debug("Event profiler: Wrote %s", csv_path.c_str());
+}
+#else
+bool EventProfiler::IsAvailable() {
+	return false;
+}
+
+void EventProfiler::SetEnabled(bool /* enable */) {
+}
+
+void EventProfiler::AddCommand(const Source& /* source */, int /* code */, std::chrono::steady_clock::duration /* time */) {
+}
+
+void EventProfiler::AddLimitHit(const Source& /* source */) {
+}
+
+std::string EventProfiler::GetSummary(int /* count */) {
+	return std::string();
+}
+
+void EventProfiler::Dump() {
+}
+#endif
@@ -0,0 +1,105 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EVENT_PROFILER_H_
+#define _EVENT_PROFILER_H_
+
+// Headers
+#include <chrono>
+#include <string>
+#include "system.h"
+
+/**
+ * Profiler of the event interpreter.
+ * Records per map event, common event and command code how many commands
+ * ran, the time spent in them and how often an interpreter hit the limit
+ * of 10000 commands per frame.
+ * Only compiled in with ENABLE_EVENT_PROFILER and switched on at run time
+ * with --profile-events, otherwise IsEnabled is constant false.
+ */
+namespace EventProfiler {
+	enum SourceType {
+		Source_MapEvent,
+		Source_CommonEvent,
+		/** Battle events and restored interpreters */
+		Source_Other
+	};
+
+	/** Event the executed commands belong to. */
+	struct Source {
+		SourceType type;
+		int map_id;
+		int id;
+	};
+
+	/**
+	 * @return whether the profiler is compiled in.
+	 */
+	bool IsAvailable();
+
+#ifdef ENABLE_EVENT_PROFILER
+	extern bool enabled;
+
+	inline bool IsEnabled() {
+		return enabled;
+	}
+#else
+	inline bool IsEnabled() {
+		return false;
+	}
+#endif
+
+	/**
+	 * Switches recording on or off.
+	 * Has no effect when the profiler is not compiled in.
+	 *
+	 * @param enable whether to record.
+	 */
+	void SetEnabled(bool enable);
+
+	/**
+	 * Records an executed command.
+	 *
+	 * @param source event running the command.
+	 * @param code command code.
+	 * @param time time spent in the command.
+	 */
+	void AddCommand(const Source& source, int code, std::chrono::steady_clock::duration time);
+
+	/**
+	 * Records that an event hit the command limit of a frame.
+	 *
+	 * @param source event running the commands.
+	 */
+	void AddLimitHit(const Source& source);
+
+	/**
+	 * Describes the events that spent the most time.
+	 *
+	 * @param count maximum amount of events.
+	 * @return one line per event.
+	 */
+	std::string GetSummary(int count);
+
+	/**
+	 * Writes the recorded data to event_profile.csv and
+	 * event_profile.json in the save directory.
+	 */
+	void Dump();
+}
+
+#endif
@@ -36,6 +36,7 @@
 #include "output.h"
 #include "font.h"
 #include "bitmap.h"
+#include "glyph_atlas.h"
 #include "utils.h"
 #include "cache.h"
 
@@ -73,14 +74,18 @@ namespace {
 
 		using function_type = ShinonomeGlyph const*(*)(char32_t);
 
-		ShinonomeFont(function_type func);
+		ShinonomeFont(function_type func, bool prewarm);
 
 		Rect GetSize(std::u32string const& txt) const override;
 
 		BitmapRef Glyph(char32_t code) override;
 
+	protected:
+		void PrewarmGlyphs() override;
+
 	private:
 		function_type const func_;
+		bool const prewarm_;
 	}; // class ShinonomeFont
 
 #ifdef HAVE_FREETYPE
@@ -117,8 +122,12 @@ namespace {
 	}; // class FTFont
 #endif
 
-	FontRef const gothic = std::make_shared<ShinonomeFont>(&find_gothic_glyph);
-	FontRef const mincho = std::make_shared<ShinonomeFont>(&find_mincho_glyph);
+	// Mincho has no ASCII glyphs, only the default gothic font is prewarmed
+	FontRef const gothic = std::make_shared<ShinonomeFont>(&find_gothic_glyph, true);
+	FontRef const mincho = std::make_shared<ShinonomeFont>(&find_mincho_glyph, false);
+
+	// Amount of glyphs cached per font
+	int const glyph_atlas_capacity = 1024;
 
 	struct ExFont : public Font {
 		ExFont();
@@ -127,8 +136,8 @@ namespace {
 	};
 } // anonymous namespace
 
-ShinonomeFont::ShinonomeFont(ShinonomeFont::function_type func)
-	: Font("Shinonome", HEIGHT, false, false), func_(func) {}
+ShinonomeFont::ShinonomeFont(ShinonomeFont::function_type func, bool prewarm)
+	: Font("Shinonome", HEIGHT, false, false), func_(func), prewarm_(prewarm) {}
 
 Rect ShinonomeFont::GetSize(std::u32string const& txt) const {
 	size_t units = 0;
@@ -155,6 +164,20 @@ BitmapRef ShinonomeFont::Glyph(char32_t code) {
 	return bm;
 }
 
+void ShinonomeFont::PrewarmGlyphs() {
+	if (!prewarm_) {
+		return;
+	}
+
+	// ASCII
+	CacheGlyphs(0x20, 0x7E);
+	// Hiragana
+	CacheGlyphs(0x3041, 0x3093);
+	// Katakana and prolonged sound mark
+	CacheGlyphs(0x30A1, 0x30F6);
+	CacheGlyphs(0x30FC, 0x30FC);
+}
+
 #ifdef HAVE_FREETYPE
 std::weak_ptr<std::remove_pointer<FT_Library>::type> FTFont::library_checker_;
 
@@ -312,25 +335,63 @@ Rect Font::GetSize(std::string const& txt) const {
 	return GetSize(Utils::DecodeUTF32(txt));
 }
 
+BitmapRef Font::GetCachedGlyph(char32_t code, Rect& rect) {
+	if (!atlas || atlas_name != name || atlas_size != size || atlas_bold != bold || atlas_italic != italic) {
+		atlas_name = name;
+		atlas_size = size;
+		atlas_bold = bold;
+		atlas_italic = italic;
+
+		int const cell = std::max<int>(pixel_size(), size);
+		atlas = std::make_shared<GlyphAtlas>(cell, cell, glyph_atlas_capacity);
+
+		PrewarmGlyphs();
+	}
+
+	if (atlas->Find(code, rect)) {
+		return atlas->GetBitmap();
+	}
+
+	BitmapRef bm = Glyph(code);
+
+	if (atlas->Insert(code, *bm, rect)) {
+		return atlas->GetBitmap();
+	}
+
+	// Too large for the atlas
+	rect = bm->GetRect();
+	return bm;
+}
+
+void Font::CacheGlyphs(char32_t first, char32_t last) {
+	Rect rect;
+
+	for (char32_t code = first; code <= last; ++code) {
+		GetCachedGlyph(code, rect);
+	}
+}
+
 void Font::Render(Bitmap& bmp, int const x, int const y, Bitmap const& sys, int color, char32_t code) {
 	if(color != ColorShadow) {
 		BitmapRef system = Cache::System();
 		Render(bmp, x + 1, y + 1, system->GetShadowColor(), code);
 	}
 
-	BitmapRef bm = Glyph(code);
+	Rect rect;
+	BitmapRef bm = GetCachedGlyph(code, rect);
 
 	unsigned const
 		src_x = color == ColorShadow? 16 : color % 10 * 16 + 2,
-		src_y = color == ColorShadow? 32 : color / 10 * 16 + 48 + 16 - bm->height();
+		src_y = color == ColorShadow? 32 : color / 10 * 16 + 48 + 16 - rect.height;
 
-	bmp.MaskedBlit(Rect(x, y, bm->width(), bm->height()), *bm, 0, 0, sys, src_x, src_y);
+	bmp.MaskedBlit(Rect(x, y, rect.width, rect.height), *bm, rect.x, rect.y, sys, src_x, src_y);
 }
 
 void Font::Render(Bitmap& bmp, int x, int y, Color const& color, char32_t code) {
-	BitmapRef bm = Glyph(code);
+	Rect rect;
+	BitmapRef bm = GetCachedGlyph(code, rect);
 
-	bmp.MaskedBlit(Rect(x, y, bm->width(), bm->height()), *bm, 0, 0, color);
+	bmp.MaskedBlit(Rect(x, y, rect.width, rect.height), *bm, rect.x, rect.y, color);
 }
 
 ExFont::ExFont() : Font("exfont", 12, false, false) {
@@ -23,6 +23,7 @@
 #include <string>
 
 class Color;
+class GlyphAtlas;
 class Rect;
 
 /**
@@ -66,6 +67,39 @@ class Font {
 	size_t pixel_size() const { return size * 96 / 72; }
  protected:
 	Font(const std::string& name, int size, bool bold, bool italic);
+
+	/**
+	 * Called when the glyph atlas was created.
+	 * Fonts can render frequently used glyphs into it in advance.
+	 */
+	virtual void PrewarmGlyphs() {}
+
+	/**
+	 * Renders the glyphs of a code point range into the atlas.
+	 *
+	 * @param first first code point.
+	 * @param last last code point (inclusive).
+	 */
+	void CacheGlyphs(char32_t first, char32_t last);
+
+ private:
+	/**
+	 * Gets a glyph from the atlas, rendering it on a cache miss.
+	 *
+	 * @param code code point.
+	 * @param rect receives the glyph area in the returned bitmap.
+	 * @return bitmap holding the glyph in its alpha channel.
+	 */
+	BitmapRef GetCachedGlyph(char32_t code, Rect& rect);
+
+	/** Cached glyphs, created on first use. */
+	std::shared_ptr<GlyphAtlas> atlas;
+
+	/** Font attributes the atlas was filled with. */
+	std::string atlas_name;
+	unsigned atlas_size = 0;
+	bool atlas_bold = false;
+	bool atlas_italic = false;
 };
 
 #endif
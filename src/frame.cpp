@@ -52,12 +52,26 @@ void Frame::Update() {
 }
 
 void Frame::Draw() {
+	drawn_revision = frame_bitmap ? frame_bitmap->GetRevision() : 0;
+
 	if (frame_bitmap) {
 		BitmapRef dst = DisplayUi->GetDisplaySurface();
 		dst->Blit(0, 0, *frame_bitmap, frame_bitmap->GetRect(), 255);
 	}
 }
 
+bool Frame::GetDamage(Rect& damage) {
+	uint32_t revision = frame_bitmap ? frame_bitmap->GetRevision() : 0;
+
+	damage = Rect();
+
+	if (revision != drawn_revision) {
+		damage = DisplayUi->GetDisplaySurface()->GetRect();
+	}
+
+	return true;
+}
+
 void Frame::OnFrameGraphicReady(FileRequestResult* result) {
 	frame_bitmap = Cache::Frame(result->file);
 }
@@ -34,6 +34,8 @@ public:
 	void Draw() override;
 	void Update();
 
+	bool GetDamage(Rect& damage) override;
+
 	int GetZ() const override;
 	DrawableType GetType() const override;
 
@@ -46,6 +48,9 @@ private:
 
 	BitmapRef frame_bitmap;
 
+	/** Bitmap revision of the last Draw call, 0 when nothing was drawn. */
+	uint32_t drawn_revision = 0;
+
 	FileRequestBinding request_id;
 };
 
@@ -0,0 +1,160 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "frame_tracer.h"
+#include "filefinder.h"
+#include "output.h"
+#include "system.h"
+
+#ifdef SUPPORT_THREADS
+#  include <atomic>
+#  include <mutex>
+#endif
+
+namespace {
+	/** Events per thread, must be a power of two. */
+	constexpr size_t buffer_size = 1 << 16;
+
+	struct Event {
+		const char* name;
+		FrameTracer::Clock::time_point start;
+		FrameTracer::Clock::time_point end;
+	};
+
+	/** Ring buffer only written by its own thread. */
+	struct Buffer {
+		int thread_id;
+		std::vector<Event> events;
+#ifdef SUPPORT_THREADS
+		std::atomic<size_t> written;
+#else
+		size_t written;
+#endif
+
+		explicit Buffer(int thread_id) : thread_id(thread_id), events(buffer_size), written(0) {}
+	};
+
+	std::string trace_file;
+	FrameTracer::Clock::time_point trace_start;
+
+	std::vector<std::unique_ptr<Buffer>> buffers;
+
+#ifdef SUPPORT_THREADS
+	/** Guards buffers, only locked when a thread records its first event. */
+	std::mutex buffers_mutex;
+
+	thread_local Buffer* thread_buffer = nullptr;
+
+	Buffer* GetThreadBuffer() {
+		if (!thread_buffer) {
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+			buffers.emplace_back(new Buffer(static_cast<int>(buffers.size()) + 1));
+			thread_buffer = buffers.back().get();
+		}
+		return thread_buffer;
+	}
+
+	size_t GetWritten(const Buffer& buffer) {
+		return buffer.written.load(std::memory_order_acquire);
+	}
+
+	void Publish(Buffer& buffer, size_t written) {
+		buffer.written.store(written, std::memory_order_release);
+	}
+#else
+	/** Everything runs on the main thread, it gets the only buffer. */
+	Buffer* GetThreadBuffer() {
+		if (buffers.empty()) {
+			buffers.emplace_back(new Buffer(1));
+		}
+		return buffers.front().get();
+	}
+
+	size_t GetWritten(const Buffer& buffer) {
+		return buffer.written;
+	}
+
+	void Publish(Buffer& buffer, size_t written) {
+		buffer.written = written;
+	}
+#endif
+
+	long long ToUs(FrameTracer::Clock::duration time) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+	}
+}
+
+bool FrameTracer::enabled = false;
+
+void FrameTracer::Start(const std::string& filename) {
+	trace_file = filename;
+	trace_start = Clock::now();
+	enabled = true;
+}
+
+void FrameTracer::Finish() {
+	if (!enabled) {
+		return;
+	}
+	enabled = false;
+
+	std::shared_ptr<std::fstream> out = FileFinder::openUTF8(trace_file, std::ios_base::out | std::ios_base::trunc);
+	if (!out) {
+		Output::Warning("Frame tracer: Cannot write %s", trace_file.c_str());
+		return;
+	}
+
+	*out << "{\"traceEvents\":[\n";
+
+	bool first = true;
+#ifdef SUPPORT_THREADS
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+#endif
+	for (const auto& buffer : buffers) {
+		size_t written = GetWritten(*buffer);
+		size_t begin = written > buffer_size ? written - buffer_size : 0;
+
+		for (size_t i = begin; i < written; ++i) {
+			const Event& event = buffer->events[i & (buffer_size - 1)];
+			*out << (first ? "" : ",\n")
+				<< "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+				<< ",\"ts\":" << ToUs(event.start - trace_start)
+				<< ",\"dur\":" << ToUs(event.end - event.start) << "}";
+			first = false;
+		}
+	}
+
+	*out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	Output::Debug("Frame tracer: Wrote %s", trace_file.c_str());
+}
+
+void FrameTracer::AddEvent(const char* name, Clock::time_point start, Clock::time_point end) {
+	Buffer* buffer = GetThreadBuffer();
+
+	// Single writer: publish the slot after filling it
+	size_t index = GetWritten(*buffer);
+	Event& event = buffer->events[index & (buffer_size - 1)];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	Publish(*buffer, index + 1);
+}
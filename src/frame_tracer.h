@@ -0,0 +1,93 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FRAME_TRACER_H_
+#define _FRAME_TRACER_H_
+
+// Headers
+#include <chrono>
+#include <string>
+
+/**
+ * Records how long the phases of a frame take and writes them as a
+ * Chrome trace_event file (open it in chrome://tracing or Perfetto).
+ * Every thread records into its own ring buffer without locking, when a
+ * buffer is full the oldest events are overwritten.
+ */
+namespace FrameTracer {
+	typedef std::chrono::steady_clock Clock;
+
+	/**
+	 * Starts recording.
+	 *
+	 * @param filename file the trace is written to by Finish.
+	 */
+	void Start(const std::string& filename);
+
+	/**
+	 * Stops recording and writes the trace file.
+	 */
+	void Finish();
+
+	extern bool enabled;
+
+	/**
+	 * @return whether events are recorded.
+	 */
+	inline bool IsEnabled() {
+		return enabled;
+	}
+
+	/**
+	 * Records a finished event of the calling thread.
+	 *
+	 * @param name event name, must stay valid until Finish (string literal).
+	 * @param start start time.
+	 * @param end end time.
+	 */
+	void AddEvent(const char* name, Clock::time_point start, Clock::time_point end);
+
+	/**
+	 * Records the lifetime of the object as an event.
+	 */
+	class Scope {
+	public:
+		/**
+		 * @param name event name, must stay valid until Finish (string literal).
+		 */
+		explicit Scope(const char* name) : name(IsEnabled() ? name : nullptr) {
+			if (this->name) {
+				start = Clock::now();
+			}
+		}
+
+		~Scope() {
+			if (name) {
+				AddEvent(name, start, Clock::now());
+			}
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		const char* name;
+		Clock::time_point start;
+	};
+}
+
+#endif
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cassert>
 #include "data.h"
+#include "event_command_list.h"
 #include "game_actors.h"
 #include "game_enemyparty.h"
 #include "game_message.h"
@@ -52,6 +53,8 @@ namespace {
 	int message_position;
 	bool message_is_transparent;
 	std::vector<bool> page_executed;
+	/** Command lists of the troop pages, built when a page first runs */
+	std::vector<EventCommandList> page_lists;
 	int terrain_id;
 	int battle_mode;
 }
@@ -68,6 +71,7 @@ void Game_Battle::Init() {
 
 	troop = &Data::troops[Game_Temp::battle_troop_id - 1];
 	page_executed.resize(troop->pages.size());
+	page_lists.resize(troop->pages.size());
 
 	message_is_fixed = Game_Message::IsPositionFixed();
 	message_position = Game_Message::GetPosition();
@@ -92,6 +96,7 @@ void Game_Battle::Quit() {
 	}
 
 	page_executed.clear();
+	page_lists.clear();
 
 	Main_Data::game_party->ResetBattle();
 
@@ -294,7 +299,11 @@ bool Game_Battle::UpdateEvents() {
 	}
 
 	if (new_page != NULL) {
-		interpreter->Setup(new_page->event_commands, 0);
+		EventCommandList& page_list = page_lists[it - troop->pages.begin()];
+		if (page_list.empty()) {
+			page_list = EventCommandList(new_page->event_commands);
+		}
+		interpreter->Setup(page_list, 0);
 	}
 
 	return new_page == NULL;
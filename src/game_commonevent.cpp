@@ -93,8 +93,11 @@ int Game_CommonEvent::GetTrigger() const {
 	return Data::commonevents[common_event_id - 1].trigger;
 }
 
-std::vector<RPG::EventCommand>& Game_CommonEvent::GetList() {
-	return Data::commonevents[common_event_id - 1].event_commands;
+const EventCommandList& Game_CommonEvent::GetList() const {
+	if (list.empty()) {
+		list = EventCommandList(Data::commonevents[common_event_id - 1].event_commands);
+	}
+	return list;
 }
 
 RPG::SaveEventData Game_CommonEvent::GetSaveData() {
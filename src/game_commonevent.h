@@ -95,11 +95,11 @@ public:
 	int GetSwitchId() const;
 
 	/**
-	 * Gets event commands list.
+	 * Gets event commands list. It is built on the first call.
 	 *
 	 * @return event commands list.
 	 */
-	std::vector<RPG::EventCommand>& GetList();
+	const EventCommandList& GetList() const;
 
 	RPG::SaveEventData GetSaveData();
 
@@ -110,6 +110,8 @@ private:
 	 * When switched to running it continues where it was suspended.
 	 */
 	bool parallel_running = false;
+	/** Built by GetList, most common events never run. */
+	mutable EventCommandList list;
 
 	/** Interpreter for parallel common events. */
 	std::unique_ptr<Game_Interpreter_Map> interpreter;
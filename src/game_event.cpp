@@ -76,6 +76,7 @@ int Game_Event::GetX() const {
 
 void Game_Event::SetX(int new_x) {
 	data.position_x = new_x;
+	Game_Map::UpdateEventPosition(*this);
 }
 
 int Game_Event::GetY() const {
@@ -84,6 +85,7 @@ int Game_Event::GetY() const {
 
 void Game_Event::SetY(int new_y) {
 	data.position_y = new_y;
+	Game_Map::UpdateEventPosition(*this);
 }
 
 int Game_Event::GetMapId() const {
@@ -294,7 +296,7 @@ void Game_Event::Setup(RPG::EventPage* new_page) {
 	SetLayer(page->layer);
 	data.overlap_forbidden = page->overlap_forbidden;
 	trigger = page->trigger;
-	list = page->event_commands;
+	list = GetPageList(page - event.pages.data() + 1);
 
 	if (trigger == RPG::EventPage::Trigger_parallel) {
 		interpreter.reset(new Game_Interpreter_Map());
@@ -323,7 +325,7 @@ void Game_Event::SetupFromSave(RPG::EventPage* new_page) {
 	original_move_route = page->move_route;
 	animation_type = page->animation_type;
 	trigger = page->trigger;
-	list = page->event_commands;
+	list = GetPageList(page - event.pages.data() + 1);
 
 	// FIXME: transparency gets not restored otherwise
 	SetOpacity(page->translucent ? 160 : 255);
@@ -479,10 +481,28 @@ void Game_Event::Start(bool by_decision_key) {
 	started_by_decision_key = by_decision_key;
 }
 
-std::vector<RPG::EventCommand>& Game_Event::GetList() {
+const EventCommandList& Game_Event::GetList() const {
 	return list;
 }
 
+const EventCommandList& Game_Event::GetPageList(int page) {
+	static const EventCommandList empty_list;
+
+	if (page <= 0 || page - 1 >= (int)event.pages.size()) {
+		return empty_list;
+	}
+
+	if (page_lists.empty()) {
+		page_lists.resize(event.pages.size());
+	}
+
+	EventCommandList& page_list = page_lists[page - 1];
+	if (page_list.empty()) {
+		page_list = EventCommandList(event.pages[page - 1].event_commands);
+	}
+	return page_list;
+}
+
 void Game_Event::StartTalkToHero() {
 	if (!(IsDirectionFixed() || IsFacingLocked())) {
 		int prelock_dir = GetDirection();
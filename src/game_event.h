@@ -140,7 +140,17 @@ public:
 	 *
 	 * @return event commands list.
 	 */
-	std::vector<RPG::EventCommand>& GetList();
+	const EventCommandList& GetList() const;
+
+	/**
+	 * Gets the commands list of a page, shared by all interpreters
+	 * running it.
+	 *
+	 * @param page Page number (starting from 1)
+	 *
+	 * @return event commands list, empty when the page does not exist.
+	 */
+	const EventCommandList& GetPageList(int page);
 
 	/**
 	 * Event's sprite looks towards the hero but its original direction is remembered.
@@ -224,7 +234,8 @@ private:
 	int trigger;
 	RPG::Event event;
 	RPG::EventPage* page;
-	std::vector<RPG::EventCommand> list;
+	EventCommandList list;
+	std::vector<EventCommandList> page_lists;
 	std::shared_ptr<Game_Interpreter> interpreter;
 	bool from_save;
 };
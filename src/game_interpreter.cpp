@@ -16,11 +16,14 @@
  */
 
 // Headers
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
 #include "game_interpreter.h"
 #include "audio.h"
+#include "event_jump_table.h"
+#include "event_profiler.h"
 #include "game_map.h"
 #include "game_event.h"
 #include "game_player.h"
@@ -87,7 +90,7 @@ bool Game_Interpreter::IsRunning() const {
 
 // Setup.
 void Game_Interpreter::Setup(
-	const std::vector<RPG::EventCommand>& _list,
+	const EventCommandList& _list,
 	int _event_id,
 	bool started_by_decision_key,
 	int dbg_x, int dbg_y
@@ -218,7 +221,7 @@ void Game_Interpreter::Update() {
 		}
 
 		runned = true;
-		if (!ExecuteCommand()) {
+		if (!(EventProfiler::IsEnabled() ? ExecuteCommandProfiled() : ExecuteCommand())) {
 			break;
 		}
 
@@ -233,6 +236,10 @@ void Game_Interpreter::Update() {
 	if (loop_count > 9999) {
 		// Executed Events Count exceeded (10000)
 		Output::Debug("Event %d exceeded execution limit", event_id);
+
+		if (EventProfiler::IsEnabled()) {
+			EventProfiler::AddLimitHit(GetProfilerSource());
+		}
 	}
 
 	updating = false;
@@ -264,6 +271,15 @@ bool Game_Interpreter::SkipTo(int code, int code2, int min_indent, int max_inden
 	if (max_indent < 0)
 		max_indent = list[index].indent;
 
+	if (min_indent == max_indent) {
+		int idx = list.GetJumpTable().Find(index, code, code2, min_indent);
+		if (idx < 0)
+			return false;
+		if ((size_t) idx < list.size() || otherwise_end)
+			index = idx;
+		return true;
+	}
+
 	int idx;
 	for (idx = index; (size_t) idx < list.size(); idx++) {
 		if (list[idx].indent < min_indent)
@@ -284,6 +300,40 @@ bool Game_Interpreter::SkipTo(int code, int code2, int min_indent, int max_inden
 }
 
 // Execute Command.
+EventProfiler::Source Game_Interpreter::GetProfilerSource() const {
+	EventProfiler::Source source;
+
+	// Common events are set up with debug_y -2 and their ID at debug_x.
+	// Parallel common events pass the ID negated, the others as is.
+	if (debug_y == -2) {
+		source.type = EventProfiler::Source_CommonEvent;
+		source.map_id = 0;
+		source.id = std::abs(debug_x);
+	} else if (event_id > 0) {
+		source.type = EventProfiler::Source_MapEvent;
+		source.map_id = map_id;
+		source.id = event_id;
+	} else {
+		source.type = EventProfiler::Source_Other;
+		source.map_id = 0;
+		source.id = 0;
+	}
+
+	return source;
+}
+
+bool Game_Interpreter::ExecuteCommandProfiled() {
+	// The command can replace the list, fetch everything before running it
+	EventProfiler::Source source = GetProfilerSource();
+	int code = index < list.size() ? static_cast<int>(list[index].code) : static_cast<int>(Cmd::END);
+
+	auto start = std::chrono::steady_clock::now();
+	bool result = ExecuteCommand();
+	EventProfiler::AddCommand(source, code, std::chrono::steady_clock::now() - start);
+
+	return result;
+}
+
 bool Game_Interpreter::ExecuteCommand() {
 	RPG::EventCommand const& com = list[index];
 
@@ -521,30 +571,29 @@ bool Game_Interpreter::CommandControlSwitches(RPG::EventCommand const& com) { //
 			// Single and switch range
 			for (i = com.parameters[1]; i <= com.parameters[2]; i++) {
 				if (com.parameters[3] != 2) {
-					Game_Switches[i] = com.parameters[3] == 0;
+					Game_Switches.Set(i, com.parameters[3] == 0);
 				} else {
-					Game_Switches[i] = !Game_Switches[i];
+					Game_Switches.Flip(i);
 				}
 			}
 			break;
 		case 2:
 			// Switch from variable
 			if (com.parameters[3] != 2) {
-				Game_Switches[Game_Variables[com.parameters[1]]] = com.parameters[3] == 0;
+				Game_Switches.Set(Game_Variables[com.parameters[1]], com.parameters[3] == 0);
 			} else {
-				Game_Switches[Game_Variables[com.parameters[1]]] = !Game_Switches[Game_Variables[com.parameters[1]]];
+				Game_Switches.Flip(Game_Variables[com.parameters[1]]);
 			}
 			break;
 		default:
 			return false;
 	}
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_All);
 	return true;
 }
 
 // Command control vars
 bool Game_Interpreter::CommandControlVariables(RPG::EventCommand const& com) { // code 10220
-	int i, value = 0;
+	int i, value = 0, result;
 	Game_Actor* actor;
 	Game_Character* character;
 
@@ -736,86 +785,89 @@ bool Game_Interpreter::CommandControlVariables(RPG::EventCommand const& com) { /
 		case 1:
 			// Single and Var range
 			for (i = com.parameters[1]; i <= com.parameters[2]; i++) {
+				result = Game_Variables[i];
 				switch (com.parameters[3]) {
 					case 0:
 						// Assignement
-						Game_Variables[i] = value;
+						result = value;
 						break;
 					case 1:
 						// Addition
-						Game_Variables[i] += value;
+						result += value;
 						break;
 					case 2:
 						// Subtraction
-						Game_Variables[i] -= value;
+						result -= value;
 						break;
 					case 3:
 						// Multiplication
-						Game_Variables[i] *= value;
+						result *= value;
 						break;
 					case 4:
 						// Division
 						if (value != 0) {
-							Game_Variables[i] /= value;
+							result /= value;
 						}
 						break;
 					case 5:
 						// Module
 						if (value != 0) {
-							Game_Variables[i] %= value;
+							result %= value;
 						} else {
-							Game_Variables[i] = 0;
+							result = 0;
 						}
 				}
-				if (Game_Variables[i] > MaxSize) {
-					Game_Variables[i] = MaxSize;
+				if (result > MaxSize) {
+					result = MaxSize;
 				}
-				if (Game_Variables[i] < MinSize) {
-					Game_Variables[i] = MinSize;
+				if (result < MinSize) {
+					result = MinSize;
 				}
+				Game_Variables.Set(i, result);
 			}
 			break;
 
 		case 2:
 			int var_index = Game_Variables[com.parameters[1]];
+			result = Game_Variables[var_index];
 			switch (com.parameters[3]) {
 				case 0:
 					// Assignement
-					Game_Variables[var_index] = value;
+					result = value;
 					break;
 				case 1:
 					// Addition
-					Game_Variables[var_index] += value;
+					result += value;
 					break;
 				case 2:
 					// Subtraction
-					Game_Variables[var_index] -= value;
+					result -= value;
 					break;
 				case 3:
 					// Multiplication
-					Game_Variables[var_index] *= value;
+					result *= value;
 					break;
 				case 4:
 					// Division
 					if (value != 0) {
-						Game_Variables[var_index] /= value;
+						result /= value;
 					}
 					break;
 				case 5:
 					// Module
 					if (value != 0) {
-						Game_Variables[var_index] %= value;
+						result %= value;
 					}
 			}
-			if (Game_Variables[var_index] > MaxSize) {
-				Game_Variables[var_index] = MaxSize;
+			if (result > MaxSize) {
+				result = MaxSize;
 			}
-			if (Game_Variables[var_index] < MinSize) {
-				Game_Variables[var_index] = MinSize;
+			if (result < MinSize) {
+				result = MinSize;
 			}
+			Game_Variables.Set(var_index, result);
 	}
 
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
 	return true;
 }
 
@@ -919,7 +971,6 @@ bool Game_Interpreter::CommandChangeItems(RPG::EventCommand const& com) { // Cod
 			value
 		);
 	}
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
 	// Continue
 	return true;
 }
@@ -980,8 +1031,6 @@ bool Game_Interpreter::CommandChangePartyMember(RPG::EventCommand const& com) {
 		}
 	}
 
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
-
 	// Continue
 	return true;
 }
@@ -26,6 +26,8 @@
 #include "rpg_eventcommand.h"
 #include "system.h"
 #include "command_codes.h"
+#include "event_command_list.h"
+#include "event_profiler.h"
 
 class Game_Event;
 class Game_CommonEvent;
@@ -46,7 +48,7 @@ public:
 
 	void Clear();
 	void Setup(
-		const std::vector<RPG::EventCommand>& _list,
+		const EventCommandList& _list,
 		int _event_id,
 		bool started_by_decision_key = false,
 		int dbg_x = -1, int dbg_y = -1
@@ -63,6 +65,16 @@ public:
 
 	virtual bool ExecuteCommand();
 
+	/**
+	 * Runs ExecuteCommand and records it in the event profiler.
+	 */
+	bool ExecuteCommandProfiled();
+
+	/**
+	 * @return event the interpreter runs, for the event profiler.
+	 */
+	EventProfiler::Source GetProfilerSource() const;
+
 	enum Sizes {
 		MaxSize = 9999999,
 		MinSize = -9999999
@@ -86,7 +98,7 @@ protected:
 	typedef bool (Game_Interpreter::*ContinuationFunction)(RPG::EventCommand const& com);
 	ContinuationFunction continuation;
 
-	std::vector<RPG::EventCommand> list;
+	EventCommandList list;
 
 	int button_timer;
 	bool waiting_battle_anim;
@@ -114,6 +126,7 @@ protected:
 	Game_Character* GetCharacter(int character_id) const;
 
 	bool SkipTo(int code, int code2 = -1, int min_indent = -1, int max_indent = -1, bool otherwise_end = false);
+
 	void SetContinuation(ContinuationFunction func);
 
 	void CancelMenuCall();
@@ -20,6 +20,7 @@
 #include "game_battle.h"
 #include "game_enemyparty.h"
 #include "game_interpreter_battle.h"
+#include "game_map.h"
 #include "game_party.h"
 #include "game_switches.h"
 #include "game_variables.h"
@@ -85,7 +86,7 @@ bool Game_Interpreter_Battle::CommandCallCommonEvent(RPG::EventCommand const& co
 	const RPG::CommonEvent& event = Data::commonevents[event_id - 1];
 
 	child_interpreter.reset(new Game_Interpreter_Battle(depth + 1));
-	child_interpreter->Setup(event.event_commands, 0, false, event.ID, -2);
+	child_interpreter->Setup(Game_Map::GetCommonEvents()[event_id - 1].GetList(), 0, false, event.ID, -2);
 
 	return true;
 }
@@ -48,6 +48,7 @@
 #include "reader_util.h"
 #include "filefinder.h"
 #include "reader_lcf.h"
+#include "event_jump_table.h"
 
 Game_Interpreter_Map::Game_Interpreter_Map(int depth, bool main_flag) :
 	Game_Interpreter(depth, main_flag) {
@@ -57,7 +58,7 @@ bool Game_Interpreter_Map::SetupFromSave(const std::vector<RPG::SaveEventCommand
 	if (_index < (int)save.size()) {
 		map_id = Game_Map::GetMapId();
 		event_id = _event_id;
-		list = save[_index].commands;
+		list = EventCommandList(save[_index].commands);
 		index = save[_index].current_command;
 		triggered_by_decision_key = save[_index].actioned;
 
@@ -71,27 +72,6 @@ bool Game_Interpreter_Map::SetupFromSave(const std::vector<RPG::SaveEventCommand
 	return false;
 }
 
-// Taken from readers because a kitten is killed when reader_structs is included
-static int GetEventCommandSize(const std::vector<RPG::EventCommand>& commands) {
-	std::vector<RPG::EventCommand>::const_iterator it;
-
-	int result = 0;
-	for (it = commands.begin(); it != commands.end(); ++it) {
-		result += LcfReader::IntSize(it->code);
-		result += LcfReader::IntSize(it->indent);
-		result += LcfReader::IntSize(it->string.size());
-		result += ReaderUtil::Recode(it->string, Player::encoding).size();
-
-		int count = it->parameters.size();
-		result += LcfReader::IntSize(count);
-		for (int i = 0; i < count; i++)
-			result += LcfReader::IntSize(it->parameters[i]);
-	}
-	result += 4; // No idea why but then it fits
-
-	return result;
-}
-
 std::vector<RPG::SaveEventCommands> Game_Interpreter_Map::GetSaveData() const {
 	std::vector<RPG::SaveEventCommands> save;
 
@@ -105,9 +85,9 @@ std::vector<RPG::SaveEventCommands> Game_Interpreter_Map::GetSaveData() const {
 
 	while (save_interpreter != NULL) {
 		RPG::SaveEventCommands save_commands;
-		save_commands.commands = save_interpreter->list;
+		save_commands.commands = save_interpreter->list.GetCommands();
 		save_commands.current_command = save_interpreter->index;
-		save_commands.commands_size = GetEventCommandSize(save_commands.commands);
+		save_commands.commands_size = save_interpreter->list.GetSaveSize();
 		save_commands.ID = i++;
 		save_commands.event_id = event_id;
 		save_commands.actioned = triggered_by_decision_key;
@@ -118,58 +98,6 @@ std::vector<RPG::SaveEventCommands> Game_Interpreter_Map::GetSaveData() const {
 	return save;
 }
 
-int Game_Interpreter_Map::DecodeInt(std::vector<int>::const_iterator& it) {
-	int value = 0;
-
-	for (;;) {
-		int x = *it++;
-		value <<= 7;
-		value |= x & 0x7F;
-		if (!(x & 0x80))
-			break;
-	}
-
-	return value;
-}
-
-const std::string Game_Interpreter_Map::DecodeString(std::vector<int>::const_iterator& it)
-{
-	std::ostringstream out;
-	int len = DecodeInt(it);
-
-	for (int i = 0; i < len; i++)
-		out << (char) *it++;
-
-	std::string result = ReaderUtil::Recode(out.str(), Player::encoding);
-
-	return result;
-}
-
-RPG::MoveCommand Game_Interpreter_Map::DecodeMove(std::vector<int>::const_iterator& it)
-{
-	RPG::MoveCommand cmd;
-	cmd.command_id = *it++;
-
-	switch (cmd.command_id) {
-	case 32:	// Switch ON
-	case 33:	// Switch OFF
-		cmd.parameter_a = DecodeInt(it);
-		break;
-	case 34:	// Change Graphic
-		cmd.parameter_string = DecodeString(it);
-		cmd.parameter_a = DecodeInt(it);
-		break;
-	case 35:	// Play Sound Effect
-		cmd.parameter_string = DecodeString(it);
-		cmd.parameter_a = DecodeInt(it);
-		cmd.parameter_b = DecodeInt(it);
-		cmd.parameter_c = DecodeInt(it);
-		break;
-	}
-
-	return cmd;
-}
-
 /**
  * Execute Command.
  */
@@ -442,10 +370,9 @@ bool Game_Interpreter_Map::CommandMemorizeLocation(RPG::EventCommand const& com)
 	int var_map_id = com.parameters[0];
 	int var_x = com.parameters[1];
 	int var_y = com.parameters[2];
-	Game_Variables[var_map_id] = Game_Map::GetMapId();
-	Game_Variables[var_x] = player->GetX();
-	Game_Variables[var_y] = player->GetY();
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Variables.Set(var_map_id, Game_Map::GetMapId());
+	Game_Variables.Set(var_x, player->GetX());
+	Game_Variables.Set(var_y, player->GetY());
 	return true;
 }
 
@@ -483,8 +410,7 @@ bool Game_Interpreter_Map::CommandStoreTerrainID(RPG::EventCommand const& com) {
 	int x = ValueOrVariable(com.parameters[0], com.parameters[1]);
 	int y = ValueOrVariable(com.parameters[0], com.parameters[2]);
 	int var_id = com.parameters[3];
-	Game_Variables[var_id] = Game_Map::GetTerrainTag(x, y);
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Variables.Set(var_id, Game_Map::GetTerrainTag(x, y));
 	return true;
 }
 
@@ -494,8 +420,7 @@ bool Game_Interpreter_Map::CommandStoreEventID(RPG::EventCommand const& com) { /
 	int var_id = com.parameters[3];
 	std::vector<Game_Event*> events;
 	Game_Map::GetEventsXY(events, x, y);
-	Game_Variables[var_id] = events.size() > 0 ? events.back()->GetId() : 0;
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Variables.Set(var_id, events.size() > 0 ? events.back()->GetId() : 0);
 	return true;
 }
 
@@ -963,36 +888,27 @@ bool Game_Interpreter_Map::CommandChangePBG(RPG::EventCommand const& com) { // c
 }
 
 bool Game_Interpreter_Map::CommandJumpToLabel(RPG::EventCommand const& com) { // code 12120
-	int label_id = com.parameters[0];
-
-	for (int idx = 0; (size_t) idx < list.size(); idx++) {
-		if (list[idx].code != Cmd::Label)
-			continue;
-		if (list[idx].parameters[0] != label_id)
-			continue;
+	int idx = list.GetJumpTable().GetLabel(com.parameters[0]);
+	if (idx >= 0) {
 		index = idx;
-		break;
 	}
 
 	return true;
 }
 
-bool Game_Interpreter_Map::CommandBreakLoop(RPG::EventCommand const& com) { // code 12220
-	return SkipTo(Cmd::EndLoop, Cmd::EndLoop, 0, com.indent - 1, true);
+bool Game_Interpreter_Map::CommandBreakLoop(RPG::EventCommand const& /* com */) { // code 12220
+	index = list.GetJumpTable().GetLoopBreak(index);
+	return true;
 }
 
-bool Game_Interpreter_Map::CommandEndLoop(RPG::EventCommand const& com) { // code 22210
-	int indent = com.indent;
+bool Game_Interpreter_Map::CommandEndLoop(RPG::EventCommand const& /* com */) { // code 22210
+	int idx = list.GetJumpTable().GetLoopStart(index);
+	if (idx < 0) {
+		return false;
+	}
 
-	for (int idx = index; idx >= 0; idx--) {
-		if (list[idx].indent > indent)
-			continue;
-		if (list[idx].indent < indent)
-			return false;
-		if (list[idx].code != Cmd::Loop)
-			continue;
+	if ((size_t) idx < list.size()) {
 		index = idx;
-		break;
 	}
 
 	return true;
@@ -1007,16 +923,8 @@ bool Game_Interpreter_Map::CommandMoveEvent(RPG::EventCommand const& com) { // c
 			if (static_cast<Game_Vehicle*>(event)->IsInUse())
 				event = Main_Data::game_player.get();
 
-		RPG::MoveRoute route;
 		int move_freq = com.parameters[1];
-		route.repeat = com.parameters[2] != 0;
-		route.skippable = com.parameters[3] != 0;
-
-		std::vector<int>::const_iterator it;
-		for (it = com.parameters.begin() + 4; it < com.parameters.end(); )
-			route.move_commands.push_back(DecodeMove(it));
-
-		event->ForceMoveRoute(route, move_freq);
+		event->ForceMoveRoute(list.GetMoveRoute(index), move_freq);
 	}
 	return true;
 }
@@ -1422,7 +1330,7 @@ bool Game_Interpreter_Map::CommandCallEvent(RPG::EventCommand const& com) { // c
 	switch (com.parameters[0]) {
 		case 0: // Common Event
 			evt_id = com.parameters[1];
-			child_interpreter->Setup(Data::commonevents[evt_id - 1].event_commands, 0, false, Data::commonevents[evt_id - 1].ID, -2);
+			child_interpreter->Setup(Game_Map::GetCommonEvents()[evt_id - 1].GetList(), 0, false, Data::commonevents[evt_id - 1].ID, -2);
 			return true;
 		case 1: // Map Event
 			evt_id = com.parameters[1];
@@ -1440,7 +1348,7 @@ bool Game_Interpreter_Map::CommandCallEvent(RPG::EventCommand const& com) { // c
 	if (event) {
 		const RPG::EventPage* page = event->GetPage(event_page);
 		if (page) {
-			child_interpreter->Setup(page->event_commands, event->GetId(), false, event->GetX(), event->GetY());
+			child_interpreter->Setup(event->GetPageList(event_page), event->GetId(), false, event->GetX(), event->GetY());
 		} else {
 			Output::Warning("Can't call non-existant page %d of event %d", event_page, evt_id);
 		}
@@ -1575,8 +1483,7 @@ bool Game_Interpreter_Map::CommandKeyInputProc(RPG::EventCommand const& com) { /
 		}
 	}
 
-	Game_Variables[var_id] = result;
-	Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+	Game_Variables.Set(var_id, result);
 
 	if (!wait)
 		return true;
@@ -1588,7 +1495,7 @@ bool Game_Interpreter_Map::CommandKeyInputProc(RPG::EventCommand const& com) { /
 
 	if (time) {
 		// 10 per second
-		Game_Variables[time_id] = (int)((float)button_timer / Graphics::GetDefaultFps() * 10);
+		Game_Variables.Set(time_id, (int)((float)button_timer / Graphics::GetDefaultFps() * 10));
 	}
 
 	button_timer = 0;
@@ -1698,8 +1605,7 @@ bool Game_Interpreter_Map::CommandSimulatedAttack(RPG::EventCommand const& com)
 		CheckGameOver();
 
 		if (com.parameters[6] != 0) {
-			Game_Variables[com.parameters[7]] = result;
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Variables.Set(com.parameters[7], result);
 		}
 	}
 
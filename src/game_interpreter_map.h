@@ -137,9 +137,6 @@ private:
 
 private:
 	void OnChangeSystemGraphicReady(FileRequestResult* result);
-	int DecodeInt(std::vector<int>::const_iterator& it);
-	const std::string DecodeString(std::vector<int>::const_iterator& it);
-	RPG::MoveCommand DecodeMove(std::vector<int>::const_iterator& it);
 
 	static std::vector<Game_Character*> pending;
 
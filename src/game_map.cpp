@@ -21,6 +21,7 @@
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <unordered_map>
 
 #include "async_handler.h"
 #include "system.h"
@@ -35,14 +36,21 @@
 #include "lmu_reader.h"
 #include "reader_lcf.h"
 #include "map_data.h"
+#include "map_prefetcher.h"
 #include "main_data.h"
 #include "output.h"
 #include "util_macro.h"
+#include "utils.h"
 #include "game_system.h"
 #include "filefinder.h"
+#include "frame_tracer.h"
 #include "player.h"
 #include "input.h"
 
+#ifdef SUPPORT_THREADS
+#  include <mutex>
+#endif
+
 namespace {
 	RPG::SaveMapInfo& map_info = Main_Data::game_data.map_info;
 	RPG::SavePartyLocation& location = Main_Data::game_data.party_location;
@@ -63,6 +71,23 @@ namespace {
 	std::vector<Game_Event> events;
 	std::vector<Game_CommonEvent> common_events;
 
+	// Events by tile as linked lists of indices into events, ordered
+	// like events. -1 terminates a list and marks events outside the map.
+	std::vector<int> event_tile_first;
+	std::vector<int> event_tile_next;
+	std::vector<int> event_tile;
+
+#ifdef SUPPORT_THREADS
+	// liblcf reports errors through one global string
+	std::mutex lcf_mutex;
+#endif
+
+	// Events with a page condition on a value, by RefreshKey and ID
+	std::unordered_map<int, std::vector<int>> event_dependencies[Game_Map::RefreshKey_Count];
+	std::vector<int> refresh_events;
+	std::vector<bool> event_needs_refresh;
+	bool refresh_common_events;
+
 	std::unique_ptr<RPG::Map> map;
 	int scroll_direction;
 	int scroll_rest;
@@ -80,6 +105,116 @@ namespace {
 	int pan_speed;
 
 	int last_map_id;
+
+	int EventTile(int x, int y) {
+		return Game_Map::IsValid(x, y) ? x + y * Game_Map::GetWidth() : -1;
+	}
+
+	void LinkEvent(int index) {
+		int tile = EventTile(events[index].GetX(), events[index].GetY());
+		event_tile[index] = tile;
+		if (tile < 0) {
+			return;
+		}
+
+		// Keep the order of events, queries return the lowest index first
+		int* link = &event_tile_first[tile];
+		while (*link >= 0 && *link < index) {
+			link = &event_tile_next[*link];
+		}
+		event_tile_next[index] = *link;
+		*link = index;
+	}
+
+	void UnlinkEvent(int index) {
+		int tile = event_tile[index];
+		if (tile < 0) {
+			return;
+		}
+
+		int* link = &event_tile_first[tile];
+		while (*link != index) {
+			link = &event_tile_next[*link];
+		}
+		*link = event_tile_next[index];
+		event_tile[index] = -1;
+	}
+
+	/**
+	 * Returns the index of the first event on a tile.
+	 * When the tile is outside the map or the index is not built all
+	 * events are candidates and the caller must check the position.
+	 */
+	int FirstEventAt(int x, int y, bool& exact) {
+		int tile = event_tile_first.empty() ? -1 : EventTile(x, y);
+		exact = tile >= 0;
+		if (!exact) {
+			return events.empty() ? -1 : 0;
+		}
+		return event_tile_first[tile];
+	}
+
+	int NextEventAt(int index, bool exact) {
+		if (exact) {
+			return event_tile_next[index];
+		}
+		return index + 1 < static_cast<int>(events.size()) ? index + 1 : -1;
+	}
+
+	void AddEventDependency(Game_Map::RefreshKey key, int id, int index) {
+		std::vector<int>& dependent = event_dependencies[key][id];
+		if (dependent.empty() || dependent.back() != index) {
+			dependent.push_back(index);
+		}
+	}
+
+	void BuildEventDependencies() {
+		for (auto& dependencies : event_dependencies) {
+			dependencies.clear();
+		}
+		refresh_events.clear();
+		event_needs_refresh.assign(events.size(), false);
+
+		for (int i = 0; i < static_cast<int>(events.size()); ++i) {
+			for (const RPG::EventPage& page : map->events[i].pages) {
+				const RPG::EventPageCondition& condition = page.condition;
+
+				if (condition.flags.switch_a) {
+					AddEventDependency(Game_Map::RefreshKey_Switch, condition.switch_a_id, i);
+				}
+				if (condition.flags.switch_b) {
+					AddEventDependency(Game_Map::RefreshKey_Switch, condition.switch_b_id, i);
+				}
+				if (condition.flags.variable) {
+					AddEventDependency(Game_Map::RefreshKey_Variable, condition.variable_id, i);
+				}
+				if (condition.flags.item) {
+					AddEventDependency(Game_Map::RefreshKey_Item, condition.item_id, i);
+				}
+				if (condition.flags.actor) {
+					AddEventDependency(Game_Map::RefreshKey_Actor, condition.actor_id, i);
+				}
+				if (condition.flags.timer) {
+					AddEventDependency(Game_Map::RefreshKey_Timer1, 0, i);
+				}
+				if (condition.flags.timer2) {
+					AddEventDependency(Game_Map::RefreshKey_Timer2, 0, i);
+				}
+			}
+		}
+	}
+
+	void BuildEventIndex() {
+		event_tile_first.assign(Game_Map::GetWidth() * Game_Map::GetHeight(), -1);
+		event_tile_next.assign(events.size(), -1);
+		event_tile.assign(events.size(), -1);
+
+		for (int i = 0; i < static_cast<int>(events.size()); ++i) {
+			LinkEvent(i);
+		}
+
+		BuildEventDependencies();
+	}
 }
 
 void Game_Map::Init() {
@@ -114,10 +249,20 @@ void Game_Map::Init() {
 	location.pan_current_x = 0;
 	location.pan_current_y = 0;
 	last_map_id = -1;
+
+	MapPrefetcher::Clear();
 }
 
 void Game_Map::Dispose() {
 	events.clear();
+	event_tile_first.clear();
+	event_tile_next.clear();
+	event_tile.clear();
+	for (auto& dependencies : event_dependencies) {
+		dependencies.clear();
+	}
+	refresh_events.clear();
+	event_needs_refresh.clear();
 	pending.clear();
 
 	if (Main_Data::game_screen) {
@@ -130,6 +275,7 @@ void Game_Map::Dispose() {
 
 void Game_Map::Quit() {
 	Dispose();
+	MapPrefetcher::Clear();
 
 	common_events.clear();
 	interpreter.reset();
@@ -143,6 +289,9 @@ void Game_Map::Setup(int _id) {
 		events.emplace_back(location.map_id, ev);
 	}
 
+	BuildEventIndex();
+	MapPrefetcher::Prefetch(location.map_id, *map);
+
 	location.pan_finish_x = 0;
 	location.pan_finish_y = 0;
 	location.pan_current_x = 0;
@@ -168,6 +317,9 @@ void Game_Map::SetupFromSave() {
 			pending.push_back(&events.back());
 	}
 
+	BuildEventIndex();
+	MapPrefetcher::Prefetch(location.map_id, *map);
+
 	for (size_t i = 0; i < Main_Data::game_data.common_events.size() && i < common_events.size(); ++i) {
 		common_events[i].SetSaveData(Main_Data::game_data.common_events[i].event_data);
 	}
@@ -190,24 +342,18 @@ void Game_Map::SetupCommon(int _id) {
 
 	location.map_id = _id;
 
-	// Try loading EasyRPG map files first, then fallback to normal RPG Maker
-	std::stringstream ss;
-	ss << "Map" << std::setfill('0') << std::setw(4) << location.map_id << ".emu";
-
-	std::string map_file = FileFinder::FindDefault(ss.str());
-	if (map_file.empty()) {
-		ss.str("");
-		ss << "Map" << std::setfill('0') << std::setw(4) << location.map_id << ".lmu";
-		map_file = FileFinder::FindDefault(ss.str());
-
-		map = LMU_Reader::Load(map_file, Player::encoding);
+	map = MapPrefetcher::Take(location.map_id);
+	if (map) {
+		Output::Debug("Loading Map %04d (prefetched)", location.map_id);
 	} else {
-		map = LMU_Reader::LoadXml(map_file);
-	}
-	Output::Debug("Loading Map %s", ss.str().c_str());
+		std::string map_file = FindMapFile(location.map_id);
+		std::string error;
+		map = LoadMapFile(map_file, Player::encoding, error);
+		Output::Debug("Loading Map %s", map_file.c_str());
 
-	if (map.get() == NULL) {
-		Output::ErrorStr(LcfReader::GetError());
+		if (map.get() == NULL) {
+			Output::ErrorStr(error);
+		}
 	}
 
 	if (map->parallax_flag) {
@@ -230,7 +376,7 @@ void Game_Map::SetupCommon(int _id) {
 	int current_index = GetMapIndex(location.map_id);
 	map_info.encounter_rate = Data::treemap.maps[current_index].encounter_steps;
 
-	ss.str("");
+	std::stringstream ss;
 	for (int cur = current_index;
 		GetMapIndex(Data::treemap.maps[cur].parent_map) != cur;
 		cur = GetMapIndex(Data::treemap.maps[cur].parent_map)) {
@@ -304,18 +450,33 @@ void Game_Map::PlayBgm() {
 }
 
 void Game_Map::Refresh() {
+	std::vector<int> dependent;
+	dependent.swap(refresh_events);
+	for (int index : dependent) {
+		event_needs_refresh[index] = false;
+	}
+
 	if (location.map_id > 0) {
-		for (Game_Event& ev : events) {
-			ev.Refresh();
+		if (refresh_type == Refresh_Dependent) {
+			// Refresh in map order like a full refresh
+			std::sort(dependent.begin(), dependent.end());
+			for (int index : dependent) {
+				events[index].Refresh();
+			}
+		} else {
+			for (Game_Event& ev : events) {
+				ev.Refresh();
+			}
 		}
 
-		if (refresh_type == Refresh_All) {
+		if (refresh_type == Refresh_All || refresh_common_events) {
 			for (Game_CommonEvent& ev : common_events) {
 				ev.Refresh();
 			}
 		}
 	}
 
+	refresh_common_events = false;
 	refresh_type = Refresh_None;
 }
 
@@ -529,7 +690,9 @@ bool Game_Map::IsLandable(int x, int y, const Game_Character *self_event) {
 	int bit = Passable::Down | Passable::Right | Passable::Left | Passable::Up;
 
 	if (self_event) {
-		for (Game_Event& ev : events) {
+		bool exact;
+		for (int i = FirstEventAt(x, y, exact); i >= 0; i = NextEventAt(i, exact)) {
+			Game_Event& ev = events[i];
 			if (&ev != self_event && ev.IsInPosition(x, y)) {
 				if (!ev.GetThrough()) {
 					if (ev.GetLayer() == RPG::EventPage::Layers_same) {
@@ -633,14 +796,35 @@ bool Game_Map::AirshipLandOk(int const x, int const y) {
 	return Data::data.terrains[GetTerrainTag(x, y) - 1].airship_land;
 }
 
-void Game_Map::GetEventsXY(std::vector<Game_Event*>& events, int x, int y) {
-	for (Game_Event& ev : GetEvents()) {
+void Game_Map::GetEventsXY(std::vector<Game_Event*>& out, int x, int y) {
+	bool exact;
+	for (int i = FirstEventAt(x, y, exact); i >= 0; i = NextEventAt(i, exact)) {
+		Game_Event& ev = events[i];
 		if (ev.IsInPosition(x, y) && ev.GetActive()) {
-			events.push_back(&ev);
+			out.push_back(&ev);
 		}
 	}
 }
 
+void Game_Map::UpdateEventPosition(const Game_Event& ev) {
+	if (events.empty() || &ev < events.data() || &ev >= events.data() + events.size()) {
+		return;
+	}
+
+	int index = &ev - events.data();
+	if (index >= static_cast<int>(event_tile.size())) {
+		// Still being set up, BuildEventIndex links it
+		return;
+	}
+
+	if (event_tile[index] == EventTile(ev.GetX(), ev.GetY())) {
+		return;
+	}
+
+	UnlinkEvent(index);
+	LinkEvent(index);
+}
+
 bool Game_Map::LoopHorizontal() {
 	return map->scroll_type == RPG::Map::ScrollType_horizontal || map->scroll_type == RPG::Map::ScrollType_both;
 }
@@ -674,7 +858,9 @@ int Game_Map::YwithDirection(int y, int direction) {
 }
 
 int Game_Map::CheckEvent(int x, int y) {
-	for (const Game_Event& ev : events) {
+	bool exact;
+	for (int i = FirstEventAt(x, y, exact); i >= 0; i = NextEventAt(i, exact)) {
+		const Game_Event& ev = events[i];
 		if (ev.IsInPosition(x, y)) {
 			return ev.GetId();
 		}
@@ -715,6 +901,8 @@ void Game_Map::UpdateScroll() {
 }
 
 void Game_Map::Update(bool only_parallel) {
+	FrameTracer::Scope trace("Game_Map::Update");
+
 	if (GetNeedRefresh() != Refresh_None) Refresh();
 	UpdateScroll();
 	UpdatePan();
@@ -951,6 +1139,31 @@ void Game_Map::SetNeedRefresh(Game_Map::RefreshMode refresh_mode) {
 	refresh_type = refresh_mode;
 }
 
+void Game_Map::SetNeedRefresh(Game_Map::RefreshKey key, int id) {
+	bool needs_refresh = false;
+
+	if (key == RefreshKey_Switch) {
+		// Common events only depend on switches
+		refresh_common_events = true;
+		needs_refresh = true;
+	}
+
+	auto it = event_dependencies[key].find(id);
+	if (it != event_dependencies[key].end()) {
+		for (int index : it->second) {
+			if (!event_needs_refresh[index]) {
+				event_needs_refresh[index] = true;
+				refresh_events.push_back(index);
+			}
+		}
+		needs_refresh = true;
+	}
+
+	if (needs_refresh && refresh_type == Refresh_None) {
+		refresh_type = Refresh_Dependent;
+	}
+}
+
 std::vector<unsigned char>& Game_Map::GetPassagesDown() {
 	return passages_down;
 }
@@ -1210,6 +1423,39 @@ const std::string& Game_Map::GetParallaxName() {
 	return map_info.parallax_name;
 }
 
+std::string Game_Map::FindMapFile(int map_id) {
+	// Try loading EasyRPG map files first, then fallback to normal RPG Maker
+	std::stringstream ss;
+	ss << "Map" << std::setfill('0') << std::setw(4) << map_id << ".emu";
+
+	std::string map_file = FileFinder::FindDefault(ss.str());
+	if (map_file.empty()) {
+		ss.str("");
+		ss << "Map" << std::setfill('0') << std::setw(4) << map_id << ".lmu";
+		map_file = FileFinder::FindDefault(ss.str());
+	}
+
+	return map_file;
+}
+
+std::unique_ptr<RPG::Map> Game_Map::LoadMapFile(const std::string& map_file, const std::string& encoding, std::string& error) {
+#ifdef SUPPORT_THREADS
+	std::lock_guard<std::mutex> lock(lcf_mutex);
+#endif
+
+	std::unique_ptr<RPG::Map> result;
+	if (map_file.size() >= 4 && Utils::LowerCase(map_file.substr(map_file.size() - 4)) == ".emu") {
+		result = LMU_Reader::LoadXml(map_file);
+	} else {
+		result = LMU_Reader::Load(map_file, encoding);
+	}
+
+	if (!result) {
+		error = LcfReader::GetError();
+	}
+	return result;
+}
+
 FileRequestAsync* Game_Map::RequestMap(int map_id) {
 	std::stringstream ss;
 	ss << "Map" << std::setfill('0') << std::setw(4) << map_id << ".lmu";
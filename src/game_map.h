@@ -39,7 +39,20 @@ namespace Game_Map {
 	enum RefreshMode {
 		Refresh_None,
 		Refresh_All,
-		Refresh_Map
+		Refresh_Map,
+		/** Only events depending on values reported as changed */
+		Refresh_Dependent
+	};
+
+	/** Game state the page conditions of events depend on. */
+	enum RefreshKey {
+		RefreshKey_Switch,
+		RefreshKey_Variable,
+		RefreshKey_Item,
+		RefreshKey_Actor,
+		RefreshKey_Timer1,
+		RefreshKey_Timer2,
+		RefreshKey_Count
 	};
 
 	/**
@@ -437,6 +450,16 @@ namespace Game_Map {
 	 */
 	void SetNeedRefresh(RefreshMode refresh_type);
 
+	/**
+	 * Reports a changed value. Only the events with a page condition
+	 * on this value are refreshed, switches also refresh the common
+	 * events.
+	 *
+	 * @param key kind of the value.
+	 * @param id switch, variable, item or actor ID, 0 for timers.
+	 */
+	void SetNeedRefresh(RefreshKey key, int id);
+
 	/**
 	 * Gets lower passages list.
 	 *
@@ -496,6 +519,13 @@ namespace Game_Map {
 
 	void GetEventsXY(std::vector<Game_Event*>& events, int x, int y);
 
+	/**
+	 * Updates the tile index of an event after its position changed.
+	 *
+	 * @param ev event that moved.
+	 */
+	void UpdateEventPosition(const Game_Event& ev);
+
 	bool LoopHorizontal();
 	bool LoopVertical();
 
@@ -572,6 +602,26 @@ namespace Game_Map {
 	const std::string& GetParallaxName();
 
 	FileRequestAsync* RequestMap(int map_id);
+
+	/**
+	 * Finds the file of a map, EasyRPG map files (.emu) are preferred.
+	 *
+	 * @param map_id map ID.
+	 * @return path or empty string when not found.
+	 */
+	std::string FindMapFile(int map_id);
+
+	/**
+	 * Parses a map file. Only uses liblcf, so it can run on a worker
+	 * thread. Map files are parsed one at a time because liblcf keeps
+	 * the error message in a global.
+	 *
+	 * @param map_file path returned by FindMapFile.
+	 * @param encoding encoding of the game.
+	 * @param error receives the error message when parsing fails.
+	 * @return map or nullptr on error.
+	 */
+	std::unique_ptr<RPG::Map> LoadMapFile(const std::string& map_file, const std::string& encoding, std::string& error);
 }
 
 #endif
@@ -30,6 +30,28 @@
 
 static RPG::SaveInventory& data = Main_Data::game_data.inventory;
 
+/**
+ * Refreshes the events depending on a joining or leaving member.
+ * Item conditions count the equipment of the party too.
+ */
+static void RefreshMemberEvents(int actor_id) {
+	Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Actor, actor_id);
+
+	Game_Actor* actor = Game_Actors::GetActor(actor_id);
+	int const equipment[] = {
+		actor->GetWeaponId(),
+		actor->GetShieldId(),
+		actor->GetArmorId(),
+		actor->GetHelmetId(),
+		actor->GetAccessoryId()
+	};
+	for (int item_id : equipment) {
+		if (item_id > 0) {
+			Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Item, item_id);
+		}
+	}
+}
+
 Game_Party::Game_Party() {
 	data.Setup();
 
@@ -135,6 +157,10 @@ void Game_Party::AddItem(int item_id, int amount) {
 		return;
 	}
 
+	if (amount != 0) {
+		Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Item, item_id);
+	}
+
 	for (int i = 0; i < (int) data.item_ids.size(); i++) {
 		if (data.item_ids[i] != item_id)
 			continue;
@@ -205,6 +231,8 @@ void Game_Party::ConsumeItemUse(int item_id) {
 		data.item_usage[i]--;
 
 		if (data.item_usage[i] == 0) {
+			Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Item, item_id);
+
 			if (data.item_counts[i] == 1) {
 				// We just used up the last one
 				data.item_ids.erase(data.item_ids.begin() + i);
@@ -369,6 +397,7 @@ void Game_Party::AddActor(int actor_id) {
 		return;
 	data.party.push_back((int16_t)actor_id);
 	data.party_size = data.party.size();
+	RefreshMemberEvents(actor_id);
 	Main_Data::game_player->Refresh();
 }
 
@@ -377,6 +406,7 @@ void Game_Party::RemoveActor(int actor_id) {
 		return;
 	data.party.erase(std::find(data.party.begin(), data.party.end(), actor_id));
 	data.party_size = data.party.size();
+	RefreshMemberEvents(actor_id);
 	Main_Data::game_player->Refresh();
 }
 
@@ -445,11 +475,11 @@ void Game_Party::SetTimer(int which, int seconds) {
 	switch (which) {
 		case Timer1:
 			data.timer1_secs = seconds * DEFAULT_FPS;
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Timer1, 0);
 			break;
 		case Timer2:
 			data.timer2_secs = seconds * DEFAULT_FPS;
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Timer2, 0);
 			break;
 	}
 }
@@ -487,7 +517,7 @@ void Game_Party::UpdateTimers() {
 	if (data.timer1_active && (data.timer1_battle || !battle) && data.timer1_secs > 0) {
 		data.timer1_secs--;
 		if (data.timer1_secs % DEFAULT_FPS == 0) {
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Timer1, 0);
 		}
 		if (data.timer1_secs == 0) {
 			StopTimer(Timer1);
@@ -496,7 +526,7 @@ void Game_Party::UpdateTimers() {
 	if (data.timer2_active && (data.timer2_battle || !battle) && data.timer2_secs > 0) {
 		data.timer2_secs--;
 		if (data.timer2_secs % DEFAULT_FPS == 0) {
-			Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+			Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Timer2, 0);
 		}
 		if (data.timer2_secs == 0) {
 			StopTimer(Timer2);
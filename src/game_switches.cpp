@@ -17,6 +17,7 @@
 
 // Headers
 #include "game_switches.h"
+#include "game_map.h"
 #include "main_data.h"
 #include "output.h"
 
@@ -44,6 +45,18 @@ std::vector<bool>::reference Game_Switches_Class::operator[](int switch_id) {
 	return switches()[switch_id - 1];
 }
 
+void Game_Switches_Class::Set(int switch_id, bool value) {
+	std::vector<bool>::reference sw = (*this)[switch_id];
+	if (sw != value) {
+		sw = value;
+		Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Switch, switch_id);
+	}
+}
+
+void Game_Switches_Class::Flip(int switch_id) {
+	Set(switch_id, !(*this)[switch_id]);
+}
+
 std::string Game_Switches_Class::GetName(int _id) const {
 	if (!(_id > 0 && _id <= (int)Data::switches.size())) {
 		return "";
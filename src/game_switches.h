@@ -30,7 +30,24 @@ public:
 	Game_Switches_Class();
 
 	std::vector<bool>::reference operator[](int switch_id);
-	
+
+	/**
+	 * Sets a switch and reports the change to the map, so events
+	 * depending on it are refreshed.
+	 * Use this instead of operator[] for writing.
+	 *
+	 * @param switch_id switch ID.
+	 * @param value new state.
+	 */
+	void Set(int switch_id, bool value);
+
+	/**
+	 * Toggles a switch, see Set.
+	 *
+	 * @param switch_id switch ID.
+	 */
+	void Flip(int switch_id);
+
 	std::string GetName(int _id) const;
 
 	bool IsValid(int switch_id) const;
@@ -114,6 +114,16 @@ void Game_System::SePlay(RPG::Sound const& se) {
 	request->Start();
 }
 
+void Game_System::SePreloadSystem() {
+	for (int i = 0; i < SFX_Count; ++i) {
+		const std::string& name = GetSystemSE(i).name;
+		if (name.empty() || name == "(OFF)" || name == "(Brak)")
+			continue;
+
+		Audio().SE_Preload(name);
+	}
+}
+
 std::string Game_System::GetSystemName() {
 	return data.graphics_name;
 }
@@ -113,6 +113,12 @@ namespace Game_System {
 	 */
 	void SePlay(RPG::Sound const& se);
 
+	/**
+	 * Decodes the system sound effects ahead of time, so the first
+	 * cursor move or decision does not stall.
+	 */
+	void SePreloadSystem();
+
 	/**
 	 * Gets system graphic name.
 	 *
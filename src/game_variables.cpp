@@ -17,6 +17,7 @@
 
 // Headers
 #include "game_variables.h"
+#include "game_map.h"
 #include "main_data.h"
 #include "output.h"
 
@@ -45,6 +46,14 @@ int& Game_Variables_Class::operator[] (int variable_id) {
 	return (int&)variables()[variable_id - 1];
 }
 
+void Game_Variables_Class::Set(int variable_id, int value) {
+	int& var = (*this)[variable_id];
+	if (var != value) {
+		var = value;
+		Game_Map::SetNeedRefresh(Game_Map::RefreshKey_Variable, variable_id);
+	}
+}
+
 std::string Game_Variables_Class::GetName(int _id) const {
 	if (!(_id > 0 && _id <= (int)Data::variables.size())) {
 		return "";
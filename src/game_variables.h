@@ -31,6 +31,16 @@ public:
 
 	int& operator[] (int variable_id);
 
+	/**
+	 * Sets a variable and reports the change to the map, so events
+	 * depending on it are refreshed.
+	 * Use this instead of operator[] for writing.
+	 *
+	 * @param variable_id variable ID.
+	 * @param value new value.
+	 */
+	void Set(int variable_id, int value);
+
 	std::string GetName(int _id) const;
 
 	bool IsValid(int variable_id) const;
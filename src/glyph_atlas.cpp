@@ -0,0 +1,99 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <cmath>
+#include "glyph_atlas.h"
+#include "bitmap.h"
+
+GlyphAtlas::GlyphAtlas(int cell_width, int cell_height, int capacity) :
+	cell_width(cell_width),
+	cell_height(cell_height),
+	columns(static_cast<int>(std::ceil(std::sqrt(static_cast<double>(capacity))))),
+	capacity(capacity) {
+
+	int rows = (capacity + columns - 1) / columns;
+
+	bitmap = Bitmap::Create(reinterpret_cast<void*>(NULL), columns * cell_width, rows * cell_height, 0, DynamicFormat(8,8,0,8,0,8,0,8,0,PF::Alpha));
+
+	entries.reserve(capacity);
+}
+
+bool GlyphAtlas::Find(char32_t code, Rect& rect) {
+	std::unordered_map<char32_t, Entry>::iterator it = entries.find(code);
+	if (it == entries.end()) {
+		return false;
+	}
+
+	// Move to the front of the LRU list
+	lru.splice(lru.begin(), lru, it->second.lru);
+
+	rect = GetCellRect(it->second);
+	return true;
+}
+
+bool GlyphAtlas::Insert(char32_t code, Bitmap const& glyph, Rect& rect) {
+	if (glyph.GetWidth() > cell_width || glyph.GetHeight() > cell_height) {
+		return false;
+	}
+
+	std::unordered_map<char32_t, Entry>::iterator it = entries.find(code);
+
+	Entry entry;
+
+	if (it != entries.end()) {
+		// Rendered again, reuse the cell
+		entry = it->second;
+		lru.erase(entry.lru);
+		entries.erase(it);
+	} else if (static_cast<int>(entries.size()) < capacity) {
+		entry.cell = static_cast<int>(entries.size());
+	} else {
+		// Replace the least recently used glyph
+		std::unordered_map<char32_t, Entry>::iterator oldest = entries.find(lru.back());
+		entry.cell = oldest->second.cell;
+		entries.erase(oldest);
+		lru.pop_back();
+	}
+
+	entry.width = glyph.GetWidth();
+	entry.height = glyph.GetHeight();
+	entry.lru = lru.insert(lru.begin(), code);
+
+	rect = GetCellRect(entry);
+	bitmap->BlitFast(rect.x, rect.y, glyph, glyph.GetRect(), Opacity::opaque);
+
+	entries[code] = entry;
+
+	return true;
+}
+
+BitmapRef const& GlyphAtlas::GetBitmap() const {
+	return bitmap;
+}
+
+int GlyphAtlas::GetCount() const {
+	return static_cast<int>(entries.size());
+}
+
+Rect GlyphAtlas::GetCellRect(const Entry& entry) const {
+	return Rect(
+		(entry.cell % columns) * cell_width,
+		(entry.cell / columns) * cell_height,
+		entry.width,
+		entry.height);
+}
@@ -0,0 +1,101 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GLYPH_ATLAS_H_
+#define _GLYPH_ATLAS_H_
+
+// Headers
+#include <list>
+#include <unordered_map>
+#include "system.h"
+#include "rect.h"
+
+/**
+ * GlyphAtlas class.
+ * Stores rendered glyphs of one font in a single 8-bit alpha bitmap.
+ * The atlas is divided into equally sized cells, when all cells are
+ * in use the least recently used glyph is replaced.
+ */
+class GlyphAtlas {
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param cell_width maximal glyph width.
+	 * @param cell_height maximal glyph height.
+	 * @param capacity maximal amount of glyphs.
+	 */
+	GlyphAtlas(int cell_width, int cell_height, int capacity);
+
+	/**
+	 * Looks up a cached glyph and marks it as recently used.
+	 *
+	 * @param code code point.
+	 * @param rect receives the glyph area in the atlas bitmap.
+	 * @return whether the glyph is cached.
+	 */
+	bool Find(char32_t code, Rect& rect);
+
+	/**
+	 * Copies a rendered glyph into the atlas.
+	 * Only the alpha channel of the glyph is stored.
+	 *
+	 * @param code code point.
+	 * @param glyph glyph bitmap.
+	 * @param rect receives the glyph area in the atlas bitmap.
+	 * @return false when the glyph is larger than a cell.
+	 */
+	bool Insert(char32_t code, Bitmap const& glyph, Rect& rect);
+
+	/**
+	 * Gets the bitmap holding all glyphs.
+	 *
+	 * @return atlas bitmap.
+	 */
+	BitmapRef const& GetBitmap() const;
+
+	/**
+	 * Gets the amount of cached glyphs.
+	 *
+	 * @return glyph count.
+	 */
+	int GetCount() const;
+
+private:
+	struct Entry {
+		int cell;
+		int width;
+		int height;
+		std::list<char32_t>::iterator lru;
+	};
+
+	Rect GetCellRect(const Entry& entry) const;
+
+	int cell_width;
+	int cell_height;
+	int columns;
+	int capacity;
+
+	BitmapRef bitmap;
+
+	std::unordered_map<char32_t, Entry> entries;
+
+	/** Cached code points, most recently used first. */
+	std::list<char32_t> lru;
+};
+
+#endif
@@ -19,13 +19,15 @@
 #include <algorithm>
 #include <sstream>
 #include <vector>
-#include <list>
 
 #include "graphics.h"
+#include "allocation_counter.h"
 #include "bitmap.h"
 #include "cache.h"
 #include "baseui.h"
 #include "drawable.h"
+#include "drawable_list.h"
+#include "frame_tracer.h"
 #include "util_macro.h"
 #include "output.h"
 #include "player.h"
@@ -33,7 +35,11 @@
 namespace Graphics {
 	void UpdateTitle();
 	void DrawFrame();
+	void DrawList(const DrawableList& list);
+	void UpdateDisplay();
+	bool IsOverlayVisible();
 	void DrawOverlay();
+	bool CollectDamage(std::vector<Rect>& damage);
 
 	int fps;
 	int framerate;
@@ -53,20 +59,27 @@ namespace Graphics {
 
 	uint32_t next_fps_time;
 
+	/** Forces the next damage tracked frame to repaint the whole screen. */
+	bool full_redraw;
+	/** Display surface the last frame was composed on. */
+	const Bitmap* composed_surface;
+	std::vector<Rect> damage_rects;
+
 	struct State {
 		State() {}
-		std::list<Drawable*> drawable_list;
-		bool zlist_dirty = false;
+		DrawableList drawable_list;
 		bool draw_background = true;
 	};
 
 	int real_fps;
 
+	/** Heap allocations per frame during the last second. */
+	int real_allocations;
+	uint64_t last_allocation_count;
+
 	std::shared_ptr<State> state;
 	std::vector<std::shared_ptr<State> > stack;
 	std::shared_ptr<State> global_state;
-
-	bool SortDrawableList(const Drawable* first, const Drawable* second);
 }
 
 unsigned SecondToFrame(float const second) {
@@ -85,11 +98,14 @@ void Graphics::Init() {
 	global_state.reset(new State());
 
 	next_fps_time = 0;
+
+	full_redraw = true;
+	composed_surface = nullptr;
 }
 
 void Graphics::Quit() {
-	state->drawable_list.clear();
-	global_state->drawable_list.clear();
+	state->drawable_list.Clear();
+	global_state->drawable_list.Clear();
 
 	frozen_screen.reset();
 	black_screen.reset();
@@ -109,6 +125,10 @@ void Graphics::Update(bool time_left) {
 		next_fps_time += 1000;
 		real_fps = fps;
 
+		uint64_t allocation_count = AllocationCounter::GetCount();
+		real_allocations = (int)((allocation_count - last_allocation_count) / std::max(fps, 1));
+		last_allocation_count = allocation_count;
+
 		if (fps == 0) {
 			Output::Debug("Framerate is 0 FPS!");
 			DrawFrame();
@@ -143,65 +163,181 @@ void Graphics::UpdateTitle() {
 
 	if (Player::fps_flag) {
 		title << " - FPS " << real_fps;
+		if (AllocationCounter::IsEnabled()) {
+			title << " - Allocs/frame " << real_allocations;
+		}
 	}
 
 	DisplayUi->SetTitle(title.str());
 }
 
 void Graphics::DrawFrame() {
+	FrameTracer::Scope trace("Graphics::DrawFrame");
+
 	if (transition_frames_left > 0) {
 		UpdateTransition();
 
-		for (Drawable* drawable : global_state->drawable_list) {
-			drawable->Draw();
-		}
+		DrawList(global_state->drawable_list);
 
 		DrawOverlay();
 
-		DisplayUi->UpdateDisplay();
+		UpdateDisplay();
+		full_redraw = true;
 		return;
 	}
 
 	if (screen_erased) {
 		DisplayUi->CleanDisplay();
+		full_redraw = true;
 		return;
 	}
 
-	if (state->zlist_dirty) {
-		state->drawable_list.sort(SortDrawableList);
-		state->zlist_dirty = false;
-	}
+	state->drawable_list.Sort();
+	global_state->drawable_list.Sort();
+
+	BitmapRef surface = DisplayUi->GetDisplaySurface();
+	bool clipped = false;
+
+	if (Player::damage_tracking_flag && CollectDamage(damage_rects)) {
+		if (damage_rects.empty()) {
+			// Nothing changed, the surface still holds the last frame
+			UpdateDisplay();
+			return;
+		}
 
-	if (global_state->zlist_dirty) {
-		global_state->drawable_list.sort(SortDrawableList);
-		global_state->zlist_dirty = false;
+		surface->SetClipRects(damage_rects);
+		clipped = true;
 	}
 
 	if (state->draw_background) {
 		DisplayUi->AddBackground();
 	}
 
-	for (Drawable* drawable : state->drawable_list) {
-		drawable->Draw();
+	DrawList(state->drawable_list);
+	DrawList(global_state->drawable_list);
+
+	if (clipped) {
+		surface->ClearClipRects();
 	}
 
-	for (Drawable* drawable : global_state->drawable_list) {
+	full_redraw = false;
+	composed_surface = surface.get();
+
+	DrawOverlay();
+
+	UpdateDisplay();
+}
+
+namespace {
+	const char* GetTraceName(DrawableType type) {
+		switch (type) {
+			case TypeWindow:
+				return "Draw Window";
+			case TypeTilemap:
+				return "Draw Tilemap";
+			case TypeSprite:
+				return "Draw Sprite";
+			case TypePlane:
+				return "Draw Plane";
+			case TypeBackground:
+				return "Draw Background";
+			case TypeScreen:
+				return "Draw Screen";
+			case TypeFrame:
+				return "Draw Frame";
+			case TypeWeather:
+				return "Draw Weather";
+			case TypeMessageOverlay:
+				return "Draw MessageOverlay";
+			default:
+				return "Draw Default";
+		}
+	}
+}
+
+void Graphics::DrawList(const DrawableList& list) {
+	if (!FrameTracer::IsEnabled()) {
+		for (Drawable* drawable : list) {
+			drawable->Draw();
+		}
+		return;
+	}
+
+	// Consecutive drawables of the same type are traced as one event
+	const char* name = nullptr;
+	FrameTracer::Clock::time_point start;
+
+	for (Drawable* drawable : list) {
+		const char* type_name = GetTraceName(drawable->GetType());
+		if (type_name != name) {
+			FrameTracer::Clock::time_point now = FrameTracer::Clock::now();
+			if (name) {
+				FrameTracer::AddEvent(name, start, now);
+			}
+			name = type_name;
+			start = now;
+		}
 		drawable->Draw();
 	}
 
-	DrawOverlay();
+	if (name) {
+		FrameTracer::AddEvent(name, start, FrameTracer::Clock::now());
+	}
+}
 
+void Graphics::UpdateDisplay() {
+	FrameTracer::Scope trace("DisplayUi::UpdateDisplay");
 	DisplayUi->UpdateDisplay();
 }
 
-void Graphics::DrawOverlay() {
-	if (
+bool Graphics::CollectDamage(std::vector<Rect>& damage) {
+	damage.clear();
+
+	// The overlay is drawn on top of the composed frame and would
+	// accumulate when not repainted.
+	if (full_redraw || IsOverlayVisible() ||
+		composed_surface != DisplayUi->GetDisplaySurface().get()) {
+		return false;
+	}
+
+	Rect rect;
+
+	for (Drawable* drawable : state->drawable_list) {
+		if (!drawable->GetDamage(rect)) {
+			return false;
+		}
+		if (!rect.IsEmpty()) {
+			damage.push_back(rect);
+		}
+	}
+
+	for (Drawable* drawable : global_state->drawable_list) {
+		if (!drawable->GetDamage(rect)) {
+			return false;
+		}
+		if (!rect.IsEmpty()) {
+			damage.push_back(rect);
+		}
+	}
+
+	return true;
+}
+
+bool Graphics::IsOverlayVisible() {
+	return
 #ifndef EMSCRIPTEN
 		DisplayUi->IsFullscreen() &&
 #endif
-		Player::fps_flag) {
+		Player::fps_flag;
+}
+
+void Graphics::DrawOverlay() {
+	if (IsOverlayVisible()) {
 		std::stringstream text;
 		text << "FPS: " << real_fps;
+		if (AllocationCounter::IsEnabled()) {
+			text << " Allocs/frame: " << real_allocations;
+		}
 		DisplayUi->GetDisplaySurface()->TextDraw(2, 2, Color(255, 255, 255, 255), text.str());
 	}
 }
@@ -233,15 +369,8 @@ void Graphics::Transition(TransitionType type, int duration, bool erase) {
 		transition_duration = type == TransitionErase ? 1 : duration;
 		transition_frames_left = transition_duration;
 
-		if (state->zlist_dirty) {
-			state->drawable_list.sort(SortDrawableList);
-			state->zlist_dirty = false;
-		}
-
-		if (global_state->zlist_dirty) {
-			global_state->drawable_list.sort(SortDrawableList);
-			global_state->zlist_dirty = false;
-		}
+		state->drawable_list.Sort();
+		global_state->drawable_list.Sort();
 
 		Freeze();
 
@@ -435,38 +564,30 @@ void Graphics::FrameReset() {
 
 void Graphics::RegisterDrawable(Drawable* drawable) {
 	if (drawable->IsGlobal()) {
-		global_state->drawable_list.push_back(drawable);
+		global_state->drawable_list.Append(drawable);
 	} else {
-		state->drawable_list.push_back(drawable);
+		state->drawable_list.Append(drawable);
 	}
-	UpdateZCallback();
+	full_redraw = true;
 }
 
 void Graphics::RemoveDrawable(Drawable* drawable) {
-	std::list<Drawable*>::iterator it;
-	if (drawable->IsGlobal()) {
-		it = std::find(global_state->drawable_list.begin(), global_state->drawable_list.end(), drawable);
-		if (it != global_state->drawable_list.end()) { global_state->drawable_list.erase(it); }
-	} else {
-		it = std::find(state->drawable_list.begin(), state->drawable_list.end(), drawable);
-		if (it != state->drawable_list.end()) { state->drawable_list.erase(it); }
-	}
-}
+	DrawableList::Remove(drawable);
 
-void Graphics::UpdateZCallback() {
-	state->zlist_dirty = true;
-	global_state->zlist_dirty = true;
+	// The area it covered is unknown
+	full_redraw = true;
 }
 
-inline bool Graphics::SortDrawableList(const Drawable* first, const Drawable* second) {
-	if (first->GetZ() < second->GetZ()) return true;
-	return false;
+void Graphics::UpdateZCallback(Drawable* drawable) {
+	// Drawables include their Z in the damage, no full redraw needed
+	DrawableList::UpdateZ(drawable);
 }
 
 void Graphics::Push(bool draw_background) {
 	stack.push_back(state);
 	state.reset(new State());
 	state->draw_background = draw_background;
+	full_redraw = true;
 }
 
 void Graphics::Pop() {
@@ -474,6 +595,7 @@ void Graphics::Pop() {
 		state = stack.back();
 		stack.pop_back();
 	}
+	full_redraw = true;
 }
 
 int Graphics::GetDefaultFps() {
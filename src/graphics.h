@@ -123,7 +123,12 @@ namespace Graphics {
 	void RegisterDrawable(Drawable* drawable);
 	void RemoveDrawable(Drawable* drawable);
 
-	void UpdateZCallback();
+	/**
+	 * Reorders a drawable whose Z changes before the next frame.
+	 *
+	 * @param drawable drawable whose Z changes.
+	 */
+	void UpdateZCallback(Drawable* drawable);
 
 	void Push(bool draw_background = true);
 	void Pop();
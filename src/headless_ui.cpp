@@ -0,0 +1,258 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "headless_ui.h"
+#include "audio.h"
+#include "bitmap.h"
+#include "output.h"
+#include "player.h"
+#include "utils.h"
+
+namespace {
+	struct KeyName {
+		const char* name;
+		Input::Keys::InputKey key;
+	};
+
+	const KeyName key_names[] = {
+		{ "backspace", Input::Keys::BACKSPACE },
+		{ "tab", Input::Keys::TAB },
+		{ "return", Input::Keys::RETURN },
+		{ "enter", Input::Keys::RETURN },
+		{ "escape", Input::Keys::ESCAPE },
+		{ "space", Input::Keys::SPACE },
+		{ "pgup", Input::Keys::PGUP },
+		{ "pgdn", Input::Keys::PGDN },
+		{ "end", Input::Keys::ENDS },
+		{ "home", Input::Keys::HOME },
+		{ "left", Input::Keys::LEFT },
+		{ "up", Input::Keys::UP },
+		{ "right", Input::Keys::RIGHT },
+		{ "down", Input::Keys::DOWN },
+		{ "insert", Input::Keys::INSERT },
+		{ "del", Input::Keys::DEL },
+		{ "shift", Input::Keys::SHIFT },
+		{ "lshift", Input::Keys::LSHIFT },
+		{ "rshift", Input::Keys::RSHIFT },
+		{ "ctrl", Input::Keys::CTRL },
+		{ "lctrl", Input::Keys::LCTRL },
+		{ "rctrl", Input::Keys::RCTRL },
+		{ "alt", Input::Keys::ALT },
+		{ "lalt", Input::Keys::LALT },
+		{ "ralt", Input::Keys::RALT }
+	};
+
+	Input::Keys::InputKey KeyFromName(const std::string& name) {
+		std::string lower = Utils::LowerCase(name);
+
+		for (const KeyName& k : key_names) {
+			if (lower == k.name) {
+				return k.key;
+			}
+		}
+
+		if (lower.size() == 1) {
+			if (lower[0] >= 'a' && lower[0] <= 'z') {
+				return static_cast<Input::Keys::InputKey>(Input::Keys::A + (lower[0] - 'a'));
+			}
+			if (lower[0] >= '0' && lower[0] <= '9') {
+				return static_cast<Input::Keys::InputKey>(Input::Keys::N0 + (lower[0] - '0'));
+			}
+		}
+
+		if (lower.size() >= 2 && lower[0] == 'f') {
+			int n = atoi(lower.c_str() + 1);
+			if (n >= 1 && n <= 12) {
+				return static_cast<Input::Keys::InputKey>(Input::Keys::F1 + (n - 1));
+			}
+		}
+
+		return Input::Keys::NONE;
+	}
+}
+
+HeadlessUi::HeadlessUi(long width, long height) :
+	BaseUi(),
+	virtual_ticks(0),
+	rendered_frames(0),
+	frame_limit(0),
+	start_time(std::chrono::steady_clock::now()) {
+
+	current_display_mode.width = width;
+	current_display_mode.height = height;
+	current_display_mode.bpp = 32;
+	current_display_mode.effective = true;
+
+	// Same layout as the SDL2 streaming texture
+#ifdef WORDS_BIGENDIAN
+	const DynamicFormat format(
+		32,
+		0xFF000000,
+		0x00FF0000,
+		0x0000FF00,
+		0x000000FF,
+		PF::NoAlpha);
+#else
+	const DynamicFormat format(
+		32,
+		0x000000FF,
+		0x0000FF00,
+		0x00FF0000,
+		0xFF000000,
+		PF::NoAlpha);
+#endif
+
+	Bitmap::SetFormat(Bitmap::ChooseFormat(format));
+
+	main_surface = Bitmap::Create(width, height, Color(0, 0, 0, 255));
+
+	// Nobody is there to dismiss an error message
+	Output::IgnorePause(true);
+
+#ifdef SUPPORT_AUDIO
+	audio_.reset(new EmptyAudio());
+#endif
+}
+
+HeadlessUi::~HeadlessUi() {
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	int frames = Player::GetFrames();
+
+	Output::Debug("Headless: %d frames (%d rendered) in %.3f s, %.1f fps",
+		frames, rendered_frames, seconds, seconds > 0.0 ? frames / seconds : 0.0);
+}
+
+bool HeadlessUi::LoadInputScript(const std::string& filename) {
+	std::ifstream file(filename.c_str());
+	if (!file) {
+		Output::Warning("Headless: Cannot open input script %s", filename.c_str());
+		return false;
+	}
+
+	std::string line;
+	int line_no = 0;
+	while (std::getline(file, line)) {
+		++line_no;
+
+		std::istringstream ss(line);
+		std::string key_name;
+		ScriptedKey entry;
+		entry.duration = 1;
+
+		if (line.empty() || line[0] == '#' || !(ss >> entry.frame)) {
+			continue;
+		}
+
+		ss >> key_name >> entry.duration;
+
+		entry.key = KeyFromName(key_name);
+		if (entry.key == Input::Keys::NONE || entry.duration < 1) {
+			Output::Warning("Headless: Invalid input script entry in line %d", line_no);
+			continue;
+		}
+
+		input_script.push_back(entry);
+	}
+
+	std::stable_sort(input_script.begin(), input_script.end(),
+		[](const ScriptedKey& a, const ScriptedKey& b) { return a.frame < b.frame; });
+
+	return true;
+}
+
+void HeadlessUi::SetFrameLimit(int frames) {
+	frame_limit = frames;
+}
+
+uint32_t HeadlessUi::GetTicks() const {
+	return virtual_ticks;
+}
+
+void HeadlessUi::Sleep(uint32_t time_milli) {
+	// Nothing to wait for, the next frame is due immediately
+	virtual_ticks += time_milli;
+}
+
+void HeadlessUi::BeginDisplayModeChange() {
+	// no-op
+}
+
+void HeadlessUi::EndDisplayModeChange() {
+	// no-op
+}
+
+void HeadlessUi::Resize(long /*width*/, long /*height*/) {
+	// no-op
+}
+
+void HeadlessUi::ToggleFullscreen() {
+	// no-op
+}
+
+void HeadlessUi::ToggleZoom() {
+	// no-op
+}
+
+bool HeadlessUi::IsFullscreen() {
+	// Draws the fps overlay into the surface when --show-fps is used
+	return true;
+}
+
+void HeadlessUi::ProcessEvents() {
+	int frame = Player::GetFrames();
+
+	if (frame_limit > 0 && frame >= frame_limit) {
+		Player::exit_flag = true;
+	}
+
+	keys.reset();
+
+	for (const ScriptedKey& entry : input_script) {
+		if (entry.frame > frame) {
+			break;
+		}
+		if (frame < entry.frame + entry.duration) {
+			keys[entry.key] = true;
+		}
+	}
+}
+
+void HeadlessUi::UpdateDisplay() {
+	++rendered_frames;
+}
+
+void HeadlessUi::SetTitle(const std::string& /* title */) {
+	// no-op
+}
+
+bool HeadlessUi::ShowCursor(bool flag) {
+	bool temp_flag = cursor_visible;
+	cursor_visible = flag;
+	return temp_flag;
+}
+
+#ifdef SUPPORT_AUDIO
+AudioInterface& HeadlessUi::GetAudio() {
+	return *audio_;
+}
+#endif
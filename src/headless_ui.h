@@ -0,0 +1,126 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HEADLESS_UI_H_
+#define _HEADLESS_UI_H_
+
+// Headers
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "baseui.h"
+#include "keys.h"
+#include "system.h"
+
+struct AudioInterface;
+
+/**
+ * HeadlessUi class.
+ * Renders into an offscreen surface and uses a virtual clock, so the
+ * game runs as fast as the CPU allows without display, GPU or audio.
+ * Input is read from an optional script file.
+ */
+class HeadlessUi : public BaseUi {
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param width display client width.
+	 * @param height display client height.
+	 */
+	HeadlessUi(long width, long height);
+
+	/**
+	 * Destructor.
+	 * Reports the measured frame rate.
+	 */
+	~HeadlessUi() override;
+
+	/**
+	 * Inherited from BaseUi.
+	 */
+	/** @{ */
+
+	void BeginDisplayModeChange() override;
+	void EndDisplayModeChange() override;
+	void Resize(long width, long height) override;
+	void ToggleFullscreen() override;
+	void ToggleZoom() override;
+	void UpdateDisplay() override;
+	void SetTitle(const std::string &title) override;
+	bool ShowCursor(bool flag) override;
+
+	void ProcessEvents() override;
+
+	bool IsFullscreen() override;
+
+	uint32_t GetTicks() const override;
+	void Sleep(uint32_t time_milli) override;
+
+#ifdef SUPPORT_AUDIO
+	AudioInterface& GetAudio() override;
+#endif
+
+	/** @} */
+
+	/**
+	 * Loads an input script.
+	 * Every non-empty line not starting with # has the form
+	 * "FRAME KEY [DURATION]": KEY (e.g. UP, RETURN, Z, F12) is held
+	 * down for DURATION frames (default 1) starting at frame FRAME.
+	 *
+	 * @param filename script file.
+	 * @return whether the script was loaded.
+	 */
+	bool LoadInputScript(const std::string& filename);
+
+	/**
+	 * Sets the amount of frames after which the player exits.
+	 *
+	 * @param frames frame limit, 0 runs until the game ends.
+	 */
+	void SetFrameLimit(int frames);
+
+private:
+	struct ScriptedKey {
+		int frame;
+		int duration;
+		Input::Keys::InputKey key;
+	};
+
+	/** Scripted key presses, sorted by frame. */
+	std::vector<ScriptedKey> input_script;
+
+	/** Virtual clock in ms, only advanced by Sleep. */
+	uint32_t virtual_ticks;
+
+	/** Frames rendered through UpdateDisplay. */
+	int rendered_frames;
+
+	/** Exit after this amount of frames, 0 for no limit. */
+	int frame_limit;
+
+	/** Wall clock time of construction, used for the fps report. */
+	std::chrono::steady_clock::time_point start_time;
+
+#ifdef SUPPORT_AUDIO
+	std::unique_ptr<AudioInterface> audio_;
+#endif
+};
+
+#endif
@@ -26,6 +26,7 @@
 #include <vector>
 #include "output.h"
 #include "image_bmp.h"
+#include "image_target.h"
 
 static uint16_t get_2(const uint8_t *p)
 {
@@ -44,7 +45,7 @@ static uint32_t get_4(const uint8_t *p)
 }
 
 void ImageBMP::ReadBMP(const uint8_t* data, unsigned len, bool transparent,
-					   int& width, int& height, void*& pixels) {
+					   int& width, int& height, void*& pixels, const ImageTarget* target) {
 	pixels = NULL;
 
 	// BITMAPFILEHEADER structure
@@ -127,22 +128,31 @@ void ImageBMP::ReadBMP(const uint8_t* data, unsigned len, bool transparent,
 
 	pixels = malloc(width * height * 4);
 
-	uint8_t* dst = (uint8_t*) pixels;
+	// Expand the palette once, every pixel is a single lookup then.
+	// A color count of 0 means the palette has all 256 entries.
+	const int palette_size = num_colors == 0 ? 256 : num_colors;
+	uint32_t lut[256];
+	for (int i = 0; i < 256; i++) {
+		uint8_t alpha = (transparent && i == 0) ? 0 : 255;
+		if (i < palette_size) {
+			const uint8_t* color = palette[i];
+			lut[i] = ImageTarget::Pack(target, color[2], color[1], color[0], alpha);
+		} else {
+			lut[i] = ImageTarget::Pack(target, 0, 0, 0, alpha);
+		}
+	}
+
+	uint32_t* dst = (uint32_t*) pixels;
 	for (int y = 0; y < height; y++) {
 		const uint8_t* src = src_pixels + (vflip ? height - 1 - y : y) * (width + padding);
 		for (int x = 0; x < width; x++) {
-			const uint8_t& pix = *src++;
-			const uint8_t* color = palette[pix];
-			*dst++ = color[2];
-			*dst++ = color[1];
-			*dst++ = color[0];
-			*dst++ = (transparent && pix == 0) ? 0 : 255;
+			*dst++ = lut[*src++];
 		}
 	}
 }
 
 void ImageBMP::ReadBMP(FILE* stream, bool transparent,
-					int& width, int& height, void*& pixels) {
+					int& width, int& height, void*& pixels, const ImageTarget* target) {
 	fseek(stream, 0, SEEK_END);
 	long size = ftell(stream);
 	fseek(stream, 0, SEEK_SET);
@@ -152,7 +162,7 @@ void ImageBMP::ReadBMP(FILE* stream, bool transparent,
 		Output::Error("Error reading BMP file.");
 		return;
 	}
-	ReadBMP(&buffer.front(), (unsigned) size, transparent, width, height, pixels);
+	ReadBMP(&buffer.front(), (unsigned) size, transparent, width, height, pixels, target);
 }
 
 #endif // SUPPORT_BMP
@@ -23,9 +23,11 @@
 
 #include <cstdio>
 
+class ImageTarget;
+
 namespace ImageBMP {
-	void ReadBMP(const uint8_t* data, unsigned len, bool transparent, int& width, int& height, void*& pixels);
-	void ReadBMP(FILE* stream, bool transparent, int& width, int& height, void*& pixels);
+	void ReadBMP(const uint8_t* data, unsigned len, bool transparent, int& width, int& height, void*& pixels, const ImageTarget* target = nullptr);
+	void ReadBMP(FILE* stream, bool transparent, int& width, int& height, void*& pixels, const ImageTarget* target = nullptr);
 }
 
 #endif // SUPPORT_BMP
@@ -23,10 +23,12 @@
 #include <cstdlib>
 #include <cstring>
 #include <csetjmp>
+#include <string>
 #include <vector>
 
 #include "output.h"
 #include "image_png.h"
+#include "image_target.h"
 
 static void read_data(png_structp png_ptr, png_bytep data, png_size_t length) {
     png_bytep* bufp = (png_bytep*) png_get_io_ptr(png_ptr);
@@ -38,21 +40,24 @@ static void on_png_warning(png_structp, png_const_charp warn_msg) {
 	Output::Debug("%s", warn_msg);
 }
 
-static void on_png_error(png_structp, png_const_charp error_msg) {
-	Output::Error("%s", error_msg);
+static void on_png_error(png_structp png_ptr, png_const_charp error_msg) {
+	// Reported by ReadPNG, Output::Error must not unwind through libpng
+	*(std::string*) png_get_error_ptr(png_ptr) = error_msg;
+	longjmp(png_jmpbuf(png_ptr), 1);
 }
 
-static void ReadPalettedData(png_struct*, png_info*, png_uint_32, png_uint_32, bool, uint32_t*);
-static void ReadGrayData(png_struct*, png_info*, png_uint_32, png_uint_32, bool, uint32_t*);
-static void ReadGrayAlphaData(png_struct*, png_info*, png_uint_32, png_uint_32, uint32_t*);
-static void ReadRGBData(png_struct*, png_info*, png_uint_32, png_uint_32, uint32_t*);
-static void ReadRGBAData(png_struct*, png_info*, png_uint_32, png_uint_32, uint32_t*);
+static void ReadPalettedData(png_struct*, png_info*, png_uint_32, png_uint_32, bool, uint32_t*, const ImageTarget*);
+static void ReadGrayData(png_struct*, png_info*, png_uint_32, png_uint_32, bool, uint32_t*, const ImageTarget*);
+static void ReadGrayAlphaData(png_struct*, png_info*, png_uint_32, png_uint_32, uint32_t*, const ImageTarget*);
+static void ReadRGBData(png_struct*, png_info*, png_uint_32, png_uint_32, uint32_t*, const ImageTarget*);
+static void ReadRGBAData(png_struct*, png_info*, png_uint_32, png_uint_32, uint32_t*, const ImageTarget*);
 
 void ImagePNG::ReadPNG(FILE* stream, const void* buffer, bool transparent,
-					int& width, int& height, void*& pixels) {
+					int& width, int& height, void*& pixels, const ImageTarget* target) {
 	pixels = NULL;
 
-	png_struct *png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, on_png_error, on_png_warning);
+	std::string error;
+	png_struct *png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp) &error, on_png_error, on_png_warning);
 	if (png_ptr == NULL) {
 		Output::Error("Couldn't allocate PNG structure");
 		return;
@@ -64,6 +69,14 @@ void ImagePNG::ReadPNG(FILE* stream, const void* buffer, bool transparent,
 		return;
 	}
 
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+		free(pixels);
+		pixels = NULL;
+		Output::Error("%s", error.c_str());
+		return;
+	}
+
 	if (stream != NULL)
 		png_init_io(png_ptr, stream);
 	else
@@ -83,19 +96,19 @@ void ImagePNG::ReadPNG(FILE* stream, const void* buffer, bool transparent,
 
 	switch (color_type) {
 		case PNG_COLOR_TYPE_PALETTE:
-			ReadPalettedData(png_ptr, info_ptr, w, h, transparent, (uint32_t*)pixels);
+			ReadPalettedData(png_ptr, info_ptr, w, h, transparent, (uint32_t*)pixels, target);
 			break;
 		case PNG_COLOR_TYPE_GRAY:
-			ReadGrayData(png_ptr, info_ptr, w, h, transparent, (uint32_t*)pixels);
+			ReadGrayData(png_ptr, info_ptr, w, h, transparent, (uint32_t*)pixels, target);
 			break;
 		case PNG_COLOR_TYPE_GRAY_ALPHA:
-			ReadGrayAlphaData(png_ptr, info_ptr, w, h, (uint32_t*)pixels);
+			ReadGrayAlphaData(png_ptr, info_ptr, w, h, (uint32_t*)pixels, target);
 			break;
 		case PNG_COLOR_TYPE_RGB:
-			ReadRGBData(png_ptr, info_ptr, w, h, (uint32_t*)pixels);
+			ReadRGBData(png_ptr, info_ptr, w, h, (uint32_t*)pixels, target);
 			break;
 		case PNG_COLOR_TYPE_RGB_ALPHA:
-			ReadRGBAData(png_ptr, info_ptr, w, h, (uint32_t*)pixels);
+			ReadRGBAData(png_ptr, info_ptr, w, h, (uint32_t*)pixels, target);
 			break;
 	}
 
@@ -107,7 +120,8 @@ static void ReadPalettedData(
 	png_struct* png_ptr, png_info* info_ptr,
 	png_uint_32 w, png_uint_32 h,
 	bool transparent,
-	uint32_t* pixels
+	uint32_t* pixels,
+	const ImageTarget* target
 ) {
 	// For transparent images, all the colors are opaque, except the
 	// color with index 0. So we'll need to do index->RGB conversion
@@ -117,13 +131,25 @@ static void ReadPalettedData(
 		png_read_update_info(png_ptr, info_ptr);
 
 		if (!png_get_valid(png_ptr, info_ptr, PNG_INFO_PLTE)) {
-			Output::Error("Palette PNG without PLTE block");
+			png_error(png_ptr, "Palette PNG without PLTE block");
 		}
 
 		png_colorp palette;
 		int num_palette;
 		png_get_PLTE(png_ptr, info_ptr, &palette, &num_palette);
 
+		// Expand the palette once, every pixel is a single lookup then
+		uint32_t lut[256];
+		for (int i = 0; i < 256; i++) {
+			uint8_t alpha = i == 0 ? 0 : 255;
+			if (i < num_palette) {
+				png_color& color = palette[i];
+				lut[i] = ImageTarget::Pack(target, color.red, color.green, color.blue, alpha);
+			} else {
+				lut[i] = ImageTarget::Pack(target, 0, 0, 0, alpha);
+			}
+		}
+
 		for (png_uint_32 y = 0; y < h; y++) {
 			// We read the indices (w bytes) into the end of the pixel
 			// data for this row (4w bytes), then scan over them
@@ -137,12 +163,8 @@ static void ReadPalettedData(
 			png_read_row(png_ptr, (png_bytep)indices, NULL);
 
 			uint32_t* dst = beginning_of_row;
-			for (png_uint_32 x = 0; x < w; x++, dst++) {
-				uint8_t idx = indices[x];
-				png_color& color = palette[idx];
-				uint8_t alpha = idx == 0 ? 0 : 255;
-				uint8_t rgba[4] = { color.red, color.green, color.blue, alpha };
-				*dst = *(uint32_t*)rgba;
+			for (png_uint_32 x = 0; x < w; x++) {
+				*dst++ = lut[indices[x]];
 			}
 		}
 	}
@@ -155,6 +177,9 @@ static void ReadPalettedData(
 		for (png_uint_32 y = 0; y < h; y++) {
 			png_bytep dst = (png_bytep) pixels + y * w * 4;
 			png_read_row(png_ptr, dst, NULL);
+			if (target) {
+				target->ConvertRow((uint32_t*) dst, w);
+			}
 		}
 	}
 }
@@ -163,7 +188,8 @@ static void ReadGrayData(
 	png_struct* png_ptr, png_info* info_ptr,
 	png_uint_32 w, png_uint_32 h,
 	bool transparent,
-	uint32_t* pixels
+	uint32_t* pixels,
+	const ImageTarget* target
 ) {
 	png_set_strip_16(png_ptr);
 	png_set_expand(png_ptr);
@@ -171,28 +197,34 @@ static void ReadGrayData(
 	png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
 	png_read_update_info(png_ptr, info_ptr);
 
+	uint8_t ck1[4] = {0, 0, 0, 255};
+	uint8_t ck2[4] = {0, 0, 0,   0};
+	uint32_t srckey = *(uint32_t*)ck1;
+	uint32_t dstkey = *(uint32_t*)ck2;
+
 	for (png_uint_32 y = 0; y < h; y++) {
 		png_bytep dst = (png_bytep) pixels + y * w * 4;
 		png_read_row(png_ptr, dst, NULL);
-	}
 
-	// Black pixels are transparent
-	if (transparent) {
-		uint8_t ck1[4] = {0, 0, 0, 255};
-		uint8_t ck2[4] = {0, 0, 0,   0};
-		uint32_t srckey = *(uint32_t*)ck1;
-		uint32_t dstkey = *(uint32_t*)ck2;
-		uint32_t* p = (uint32_t*) pixels;
-		for (unsigned i = 0; i < w * h; i++, p++)
-			if (*p == srckey)
-				*p = dstkey;
+		// Black pixels are transparent
+		if (transparent) {
+			uint32_t* p = (uint32_t*) dst;
+			for (png_uint_32 x = 0; x < w; x++, p++)
+				if (*p == srckey)
+					*p = dstkey;
+		}
+
+		if (target) {
+			target->ConvertRow((uint32_t*) dst, w);
+		}
 	}
 }
 
 static void ReadGrayAlphaData(
 	png_struct* png_ptr, png_info* info_ptr,
 	png_uint_32 w, png_uint_32 h,
-	uint32_t* pixels
+	uint32_t* pixels,
+	const ImageTarget* target
 ) {
 	png_set_strip_16(png_ptr);
 	png_set_gray_to_rgb(png_ptr);
@@ -201,6 +233,9 @@ static void ReadGrayAlphaData(
 	for (png_uint_32 y = 0; y < h; y++) {
 		png_bytep dst = (png_bytep) pixels + y * w * 4;
 		png_read_row(png_ptr, dst, NULL);
+		if (target) {
+			target->ConvertRow((uint32_t*) dst, w);
+		}
 	}
 }
 
@@ -208,7 +243,8 @@ static void ReadGrayAlphaData(
 static void ReadRGBData(
 	png_struct* png_ptr, png_info* info_ptr,
 	png_uint_32 w, png_uint_32 h,
-	uint32_t* pixels
+	uint32_t* pixels,
+	const ImageTarget* target
 ) {
 	png_set_strip_16(png_ptr);
 	png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
@@ -217,13 +253,17 @@ static void ReadRGBData(
 	for (png_uint_32 y = 0; y < h; y++) {
 		png_bytep dst = (png_bytep) pixels + y * w * 4;
 		png_read_row(png_ptr, dst, NULL);
+		if (target) {
+			target->ConvertRow((uint32_t*) dst, w);
+		}
 	}
 }
 
 static void ReadRGBAData(
 	png_struct* png_ptr, png_info* info_ptr,
 	png_uint_32 w, png_uint_32 h,
-	uint32_t* pixels
+	uint32_t* pixels,
+	const ImageTarget* target
 ) {
 	png_set_strip_16(png_ptr);
 	png_read_update_info(png_ptr, info_ptr);
@@ -231,6 +271,9 @@ static void ReadRGBAData(
 	for (png_uint_32 y = 0; y < h; y++) {
 		png_bytep dst = (png_bytep) pixels + y * w * 4;
 		png_read_row(png_ptr, dst, NULL);
+		if (target) {
+			target->ConvertRow((uint32_t*) dst, w);
+		}
 	}
 }
 
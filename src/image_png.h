@@ -25,8 +25,10 @@
 #include <ostream>
 #include "system.h"
 
+class ImageTarget;
+
 namespace ImagePNG {
-	void ReadPNG(FILE* stream, const void* buffer, bool transparent, int& width, int& height, void*& pixels);
+	void ReadPNG(FILE* stream, const void* buffer, bool transparent, int& width, int& height, void*& pixels, const ImageTarget* target = nullptr);
 	bool WritePNG(std::ostream& os, uint32_t width, uint32_t height, uint32_t* data);
 }
 
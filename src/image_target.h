@@ -0,0 +1,96 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EASYRPG_IMAGE_TARGET_H_
+#define _EASYRPG_IMAGE_TARGET_H_
+
+// Headers
+#include <cstring>
+#include "system.h"
+
+/**
+ * Pixel layout image decoders write to instead of RGBA bytes:
+ * 32 bit pixels with 8 bit channels at the given shifts and color
+ * components premultiplied by alpha, like pixman expects them.
+ */
+class ImageTarget {
+public:
+	/**
+	 * @param r_shift red bit position.
+	 * @param g_shift green bit position.
+	 * @param b_shift blue bit position.
+	 * @param a_shift alpha bit position, negative when the layout has no
+	 *                alpha channel.
+	 */
+	ImageTarget(int r_shift, int g_shift, int b_shift, int a_shift) :
+		r_shift(r_shift), g_shift(g_shift), b_shift(b_shift), a_shift(a_shift) {}
+
+	/**
+	 * Converts a color.
+	 *
+	 * @return pixel value.
+	 */
+	uint32_t Pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a) const {
+		uint32_t pixel =
+			((uint32_t)(r * a / 0xFF) << r_shift) |
+			((uint32_t)(g * a / 0xFF) << g_shift) |
+			((uint32_t)(b * a / 0xFF) << b_shift);
+		if (a_shift >= 0) {
+			pixel |= (uint32_t)a << a_shift;
+		}
+		return pixel;
+	}
+
+	/**
+	 * Converts a row of RGBA bytes in place.
+	 *
+	 * @param row pixels.
+	 * @param width amount of pixels.
+	 */
+	void ConvertRow(uint32_t* row, int width) const {
+		for (int x = 0; x < width; ++x) {
+			uint8_t rgba[4];
+			memcpy(rgba, &row[x], 4);
+			row[x] = Pack(rgba[0], rgba[1], rgba[2], rgba[3]);
+		}
+	}
+
+	/**
+	 * Converts a color to a pixel value, or to RGBA bytes when there is
+	 * no target. Used to build palette lookup tables.
+	 *
+	 * @param target target layout or nullptr.
+	 * @return pixel value.
+	 */
+	static uint32_t Pack(const ImageTarget* target, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+		if (target) {
+			return target->Pack(r, g, b, a);
+		}
+		uint8_t rgba[4] = { r, g, b, a };
+		uint32_t pixel;
+		memcpy(&pixel, rgba, 4);
+		return pixel;
+	}
+
+private:
+	int r_shift;
+	int g_shift;
+	int b_shift;
+	int a_shift;
+};
+
+#endif
@@ -25,9 +25,10 @@
 #include <vector>
 #include "output.h"
 #include "image_xyz.h"
+#include "image_target.h"
 
 void ImageXYZ::ReadXYZ(const uint8_t* data, unsigned len, bool transparent,
-					int& width, int& height, void*& pixels) {
+					int& width, int& height, void*& pixels, const ImageTarget* target) {
 	pixels = NULL;
 
     if (len < 8) {
@@ -54,22 +55,23 @@ void ImageXYZ::ReadXYZ(const uint8_t* data, unsigned len, bool transparent,
 	height = h;
 	pixels = malloc(w * h * 4);
 
-    uint8_t* dst = (uint8_t*) pixels;
-    const uint8_t* src = (const uint8_t*) &dst_buffer[768];
-    for (int y = 0; y < h; y++) {
-		for (int x = 0; x < w; x++) {
-			uint8_t pix = *src++;
-			const uint8_t* color = palette[pix];
-			*dst++ = color[0];
-			*dst++ = color[1];
-			*dst++ = color[2];
-			*dst++ = (transparent && pix == 0) ? 0 : 255;
-		}
-    }
+	// Expand the palette once, every pixel is a single lookup then
+	uint32_t lut[256];
+	for (int i = 0; i < 256; i++) {
+		const uint8_t* color = palette[i];
+		uint8_t alpha = (transparent && i == 0) ? 0 : 255;
+		lut[i] = ImageTarget::Pack(target, color[0], color[1], color[2], alpha);
+	}
+
+	uint32_t* dst = (uint32_t*) pixels;
+	const uint8_t* src = (const uint8_t*) &dst_buffer[768];
+	for (int i = 0; i < w * h; i++) {
+		*dst++ = lut[*src++];
+	}
 }
 
 void ImageXYZ::ReadXYZ(FILE* stream, bool transparent,
-					int& width, int& height, void*& pixels) {
+					int& width, int& height, void*& pixels, const ImageTarget* target) {
     fseek(stream, 0, SEEK_END);
     long size = ftell(stream);
     fseek(stream, 0, SEEK_SET);
@@ -79,7 +81,7 @@ void ImageXYZ::ReadXYZ(FILE* stream, bool transparent,
         Output::Error("Error reading XYZ file.");
         return;
     }
-	ReadXYZ(&buffer.front(), (unsigned) size, transparent, width, height, pixels);
+	ReadXYZ(&buffer.front(), (unsigned) size, transparent, width, height, pixels, target);
 }
 
 
@@ -21,9 +21,11 @@
 #include <cstdio>
 #include "system.h"
 
+class ImageTarget;
+
 namespace ImageXYZ {
-	void ReadXYZ(const uint8_t* data, unsigned len, bool transparent, int& width, int& height, void*& pixels);
-	void ReadXYZ(FILE* stream, bool transparent, int& width, int& height, void*& pixels);
+	void ReadXYZ(const uint8_t* data, unsigned len, bool transparent, int& width, int& height, void*& pixels, const ImageTarget* target = nullptr);
+	void ReadXYZ(FILE* stream, bool transparent, int& width, int& height, void*& pixels, const ImageTarget* target = nullptr);
 }
 
 #endif
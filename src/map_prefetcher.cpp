@@ -0,0 +1,232 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+#include "map_prefetcher.h"
+#include "cache.h"
+#include "command_codes.h"
+#include "data.h"
+#include "game_map.h"
+#include "rpg_savetarget.h"
+#include "game_targets.h"
+#include "player.h"
+#include "thread_pool.h"
+
+namespace {
+	/** Memory prefetched maps may occupy. */
+	constexpr size_t budget = 4 * 1024 * 1024;
+
+	struct Entry {
+		/** Identifies the job loading the map. */
+		int job;
+		/** Empty while loading. */
+		std::unique_ptr<RPG::Map> map;
+		size_t bytes;
+	};
+
+	std::map<int, Entry> entries;
+	int next_job = 0;
+
+	void AddTarget(std::vector<int>& targets, int map_id) {
+		if (map_id > 0 && std::find(targets.begin(), targets.end(), map_id) == targets.end()) {
+			targets.push_back(map_id);
+		}
+	}
+
+	/**
+	 * Collects the map IDs the commands of the map lead to, in event
+	 * order. Targets stored in variables are not predicted.
+	 */
+	std::vector<int> CollectTargets(const RPG::Map& map) {
+		std::vector<int> targets;
+
+		for (const RPG::Event& ev : map.events) {
+			for (const RPG::EventPage& page : ev.pages) {
+				for (const RPG::EventCommand& com : page.event_commands) {
+					const std::vector<int32_t>& p = com.parameters;
+
+					switch (com.code) {
+						case Cmd::Teleport:
+							if (p.size() > 0) {
+								AddTarget(targets, p[0]);
+							}
+							break;
+						case Cmd::TeleportTargets:
+							if (p.size() > 1 && p[0] == 0) {
+								AddTarget(targets, p[1]);
+							}
+							break;
+						case Cmd::EscapeTarget:
+							if (p.size() > 0) {
+								AddTarget(targets, p[0]);
+							}
+							break;
+						case Cmd::SetVehicleLocation:
+							if (p.size() > 2 && p[1] == 0) {
+								AddTarget(targets, p[2]);
+							}
+							break;
+						default:
+							break;
+					}
+				}
+			}
+		}
+
+		const RPG::SaveTarget* escape = Game_Targets::GetEscapeTarget();
+		if (escape) {
+			AddTarget(targets, escape->map_id);
+		}
+
+		return targets;
+	}
+
+	size_t EstimateSize(const RPG::Map& map) {
+		size_t bytes = sizeof(RPG::Map) + (map.lower_layer.size() + map.upper_layer.size()) * sizeof(int16_t);
+
+		for (const RPG::Event& ev : map.events) {
+			bytes += sizeof(RPG::Event);
+			for (const RPG::EventPage& page : ev.pages) {
+				bytes += sizeof(RPG::EventPage) +
+					page.event_commands.size() * sizeof(RPG::EventCommand) +
+					page.move_route.move_commands.size() * sizeof(RPG::MoveCommand);
+			}
+		}
+
+		return bytes;
+	}
+
+	size_t GetUsedBytes() {
+		size_t bytes = 0;
+		for (const auto& entry : entries) {
+			bytes += entry.second.bytes;
+		}
+		return bytes;
+	}
+
+	void PrefetchGraphics(const RPG::Map& map) {
+		if (map.chipset_id > 0 && map.chipset_id <= static_cast<int>(Data::chipsets.size())) {
+			Cache::Prefetch("ChipSet", Data::chipsets[map.chipset_id - 1].chipset_name);
+		}
+
+		if (map.parallax_flag) {
+			Cache::Prefetch("Panorama", map.parallax_name);
+		}
+
+		// Many pages share a charset
+		std::set<std::string> charsets;
+		for (const RPG::Event& ev : map.events) {
+			for (const RPG::EventPage& page : ev.pages) {
+				charsets.insert(page.character_name);
+			}
+		}
+		for (const std::string& charset : charsets) {
+			Cache::Prefetch("CharSet", charset);
+		}
+	}
+
+	void StartLoad(int map_id) {
+		std::string map_file = Game_Map::FindMapFile(map_id);
+		if (map_file.empty()) {
+			return;
+		}
+
+		int job = next_job++;
+		entries[map_id] = Entry{job, nullptr, 0};
+
+		std::string encoding = Player::encoding;
+		std::shared_ptr<std::unique_ptr<RPG::Map>> loaded = std::make_shared<std::unique_ptr<RPG::Map>>();
+
+		ThreadPool::Submit(
+			[map_file, encoding, loaded]() {
+				// The error is reported when the map is really loaded
+				std::string error;
+				*loaded = Game_Map::LoadMapFile(map_file, encoding, error);
+			},
+			[map_id, job, loaded]() {
+				auto it = entries.find(map_id);
+				if (it == entries.end() || it->second.job != job) {
+					// Dropped meanwhile
+					return;
+				}
+
+				if (!*loaded) {
+					// Reported when the map is really loaded
+					entries.erase(it);
+					return;
+				}
+
+				size_t bytes = EstimateSize(**loaded);
+				if (GetUsedBytes() + bytes > budget) {
+					entries.erase(it);
+					return;
+				}
+
+				it->second.map = std::move(*loaded);
+				it->second.bytes = bytes;
+
+				PrefetchGraphics(*it->second.map);
+			});
+	}
+}
+
+void MapPrefetcher::Prefetch(int map_id, const RPG::Map& map) {
+	if (!ThreadPool::IsAvailable()) {
+		return;
+	}
+
+	std::vector<int> targets = CollectTargets(map);
+	targets.erase(std::remove(targets.begin(), targets.end(), map_id), targets.end());
+
+	for (auto it = entries.begin(); it != entries.end();) {
+		if (std::find(targets.begin(), targets.end(), it->first) == targets.end()) {
+			it = entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (int target : targets) {
+		if (GetUsedBytes() >= budget) {
+			break;
+		}
+
+		if (entries.find(target) == entries.end()) {
+			StartLoad(target);
+		}
+	}
+}
+
+std::unique_ptr<RPG::Map> MapPrefetcher::Take(int map_id) {
+	auto it = entries.find(map_id);
+	if (it == entries.end()) {
+		return nullptr;
+	}
+
+	std::unique_ptr<RPG::Map> map = std::move(it->second.map);
+	entries.erase(it);
+
+	return map;
+}
+
+void MapPrefetcher::Clear() {
+	entries.clear();
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MAP_PREFETCHER_H_
+#define _MAP_PREFETCHER_H_
+
+// Headers
+#include <memory>
+#include "rpg_map.h"
+
+/**
+ * Loads the maps the player will probably teleport to next in the
+ * background, together with their chipset, panorama and charsets.
+ * Targets are taken from the Teleport, teleport target, escape target
+ * and vehicle location commands of the current map.
+ */
+namespace MapPrefetcher {
+	/**
+	 * Predicts the next maps and starts loading them.
+	 * Prefetched maps that are no longer reachable are dropped.
+	 *
+	 * @param map_id ID of the current map.
+	 * @param map current map.
+	 */
+	void Prefetch(int map_id, const RPG::Map& map);
+
+	/**
+	 * Takes a prefetched map.
+	 *
+	 * @param map_id map ID.
+	 * @return map or nullptr when it was not prefetched (yet).
+	 */
+	std::unique_ptr<RPG::Map> Take(int map_id);
+
+	/**
+	 * Drops all prefetched maps.
+	 */
+	void Clear();
+}
+
+#endif
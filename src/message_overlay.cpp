@@ -48,9 +48,26 @@ bool MessageOverlay::IsGlobal() const {
 	return true;
 }
 
+bool MessageOverlay::GetDamage(Rect& damage) {
+	// The timer hiding the messages advances in Draw
+	if (IsAnyMessageVisible()) {
+		return false;
+	}
+
+	damage = Rect();
+
+	if (drawn != show_all || (drawn && bitmap->GetRevision() != drawn_revision)) {
+		damage = Rect(ox, oy, bitmap->GetWidth(), bitmap->GetHeight());
+	}
+
+	return true;
+}
+
 void MessageOverlay::Draw() {
 	std::deque<MessageOverlayItem>::iterator it;
 
+	drawn = false;
+
 	if (IsAnyMessageVisible()) {
 		++counter;
 		if (counter > 150) {
@@ -69,6 +86,8 @@ void MessageOverlay::Draw() {
 	}
 
 	DisplayUi->GetDisplaySurface()->Blit(ox, oy, *bitmap, bitmap->GetRect(), 255);
+	drawn = true;
+	drawn_revision = bitmap->GetRevision();
 
 	if (!dirty) return;
 
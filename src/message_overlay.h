@@ -44,6 +44,8 @@ public:
 
 	void Draw() override;
 
+	bool GetDamage(Rect& damage) override;
+
 	int GetZ() const override;
 
 	DrawableType GetType() const override;
@@ -76,6 +78,12 @@ private:
 	int counter;
 
 	bool show_all;
+
+	/** Whether the last Draw call blitted the overlay. */
+	bool drawn = false;
+
+	/** Bitmap revision blitted by the last Draw call. */
+	uint32_t drawn_revision = 0;
 };
 
 #endif
@@ -34,6 +34,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cassert>
 #include <algorithm>
+#include <limits>
 
 namespace midisequencer{
     static uint_least32_t read_variable_value(void* fp, int(*fgetc)(void*), uint_least32_t* track_length, const char* errtext)
@@ -117,6 +118,16 @@ namespace midisequencer{
             return messages.back().time;
         }
     }
+    // Returns the time of the next event play will send,
+    // or the largest float when all events were sent.
+    float sequencer::get_next_time()const
+    {
+        if(position == messages.end()){
+            return std::numeric_limits<float>::max();
+        }else{
+            return position->time;
+        }
+    }
     std::string sequencer::get_title()const
     {
         for(std::vector<midi_message>::const_iterator i = messages.begin(); i != messages.end(); ++i){
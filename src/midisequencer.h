@@ -71,6 +71,7 @@ namespace midisequencer{
         bool load(std::FILE* fp);
         int get_num_ports()const;
         float get_total_time()const;
+        float get_next_time()const;
         std::string get_title()const;
         std::string get_copyright()const;
         std::string get_song()const;
@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cassert>
 #include <cmath>
 #include <cstring>
+#include <new>
 #include <utility>
 
 #ifdef __BORLANDC__
@@ -53,8 +54,8 @@ namespace std{
 
 namespace midisynth{
     // Channel constructor.
-    channel::channel(note_factory* factory_, int bank):
-        factory(factory_), default_bank(bank)
+    channel::channel(note_factory* factory_, int bank, uint_least32_t& serial_counter):
+        next_serial(serial_counter), factory(factory_), default_bank(bank)
     {
         notes.reserve(16);
         reset_all_parameters();
@@ -90,7 +91,7 @@ namespace midisynth{
                 ++i;
             }else{
                 i = notes.erase(i);
-                delete note;
+                note->release();
             }
             ++num_notes;
         }
@@ -154,10 +155,54 @@ namespace midisynth{
     void channel::all_sound_off_immediately()
     {
         for(std::vector<NOTE>::iterator i = notes.begin(); i != notes.end(); ++i){
-            delete i->note;
+            i->note->release();
         }
         notes.clear();
     }
+    // Finds the note to drop when the polyphony is exhausted:
+    // the oldest released note, otherwise the quietest note.
+    std::vector<channel::NOTE>::const_iterator channel::find_steal_candidate()const
+    {
+        std::vector<NOTE>::const_iterator ret = notes.end();
+        for(std::vector<NOTE>::const_iterator i = notes.begin(); i != notes.end(); ++i){
+            if(ret == notes.end()){
+                ret = i;
+            }else if((i->status != NOTE::NOTEON) != (ret->status != NOTE::NOTEON)){
+                if(i->status != NOTE::NOTEON){
+                    ret = i;
+                }
+            }else if(i->status != NOTE::NOTEON){
+                if(i->serial < ret->serial){
+                    ret = i;
+                }
+            }else if(i->note->get_level() < ret->note->get_level()){
+                ret = i;
+            }
+        }
+        return ret;
+    }
+    // Describes the note steal_note would drop. Returns false without notes.
+    bool channel::get_steal_candidate(bool& released, uint_least32_t& serial, double& level)const
+    {
+        std::vector<NOTE>::const_iterator i = find_steal_candidate();
+        if(i == notes.end()){
+            return false;
+        }
+        released = i->status != NOTE::NOTEON;
+        serial = i->serial;
+        level = mute ? 0.0 : static_cast<double>(i->note->get_level()) * volume * expression;
+        return true;
+    }
+    // Drops a note immediately to make room for a new one.
+    void channel::steal_note()
+    {
+        std::vector<NOTE>::const_iterator i = find_steal_candidate();
+        if(i != notes.end()){
+            class note* note = i->note;
+            notes.erase(notes.begin() + (i - notes.begin()));
+            note->release();
+        }
+    }
     // Note on. Sound output.
     void channel::note_on(int note, int velocity)
     {
@@ -192,7 +237,7 @@ namespace midisynth{
                 if(pressure){
                     p->set_tremolo(pressure, tremolo_frequency);
                 }
-                notes.push_back(NOTE(p, note));
+                notes.push_back(NOTE(p, note, next_serial++));
             }
         }
     }
@@ -436,11 +481,13 @@ namespace midisynth{
     }
 
     // Synthesizer constructor.
-    synthesizer::synthesizer(note_factory* factory)
+    synthesizer::synthesizer(note_factory* factory_):
+        factory(factory_), next_serial(0)
     {
         for(int i = 0; i < 16; ++i){
-            channels[i].reset(new channel(factory, i == 9 ? 0x3C00 : 0x3C80));
+            channels[i].reset(new channel(factory, i == 9 ? 0x3C00 : 0x3C80, next_serial));
         }
+        set_max_voices(DEFAULT_MAX_VOICES);
         reset_all_parameters();
     }
     // Gets channel.
@@ -453,7 +500,9 @@ namespace midisynth{
     int synthesizer::synthesize(int_least16_t* output, std::size_t samples, float rate)
     {
         std::size_t n = samples * 2;
-        std::vector<int_least32_t> buf(n);
+        // Reused, synthesize is called once per MIDI event interval
+        std::vector<int_least32_t>& buf = mixing_buffer;
+        buf.assign(n, 0);
         int num_notes = synthesize_mixing(&buf[0], samples, rate);
         if(num_notes){
             for(std::size_t i = 0; i < n; ++i){
@@ -486,6 +535,69 @@ namespace midisynth{
         }
         return num_notes;
     }
+    // Note on. Steals a voice when the polyphony is exhausted.
+    void synthesizer::note_on(int channel, int note, int velocity)
+    {
+        // Only steal when the note replaces the voice, missing drums play nothing
+        if(velocity && max_voices > 0 && get_num_voices() >= max_voices && get_channel(channel)->can_note_on(note)){
+            steal_voice();
+        }
+        get_channel(channel)->note_on(note, velocity);
+    }
+    // Returns the number of notes over all channels.
+    int synthesizer::get_num_voices()const
+    {
+        int ret = 0;
+        for(int i = 0; i < NUM_CHANNELS; ++i){
+            ret += channels[i]->get_num_notes();
+        }
+        return ret;
+    }
+    // Drops the oldest released note, otherwise the quietest note.
+    void synthesizer::steal_voice()
+    {
+        int victim = -1;
+        bool victim_released = false;
+        uint_least32_t victim_serial = 0;
+        double victim_level = 0;
+        for(int i = 0; i < NUM_CHANNELS; ++i){
+            bool released;
+            uint_least32_t serial;
+            double level;
+            if(!channels[i]->get_steal_candidate(released, serial, level)){
+                continue;
+            }
+            bool better;
+            if(victim < 0){
+                better = true;
+            }else if(released != victim_released){
+                better = released;
+            }else if(released){
+                better = serial < victim_serial;
+            }else{
+                better = level < victim_level || (level == victim_level && serial < victim_serial);
+            }
+            if(better){
+                victim = i;
+                victim_released = released;
+                victim_serial = serial;
+                victim_level = level;
+            }
+        }
+        if(victim >= 0){
+            channels[victim]->steal_note();
+        }
+    }
+    // Sets the polyphony. It is limited to the notes the factory can
+    // create, 0 uses all of them.
+    void synthesizer::set_max_voices(int value)
+    {
+        int limit = factory->get_max_notes();
+        if(limit > 0 && (value <= 0 || value > limit)){
+            value = limit;
+        }
+        max_voices = value;
+    }
     // Resets the synthesizer completely.
     void synthesizer::reset()
     {
@@ -674,10 +786,10 @@ namespace midisynth{
             step = 0;
         }
     }
-    // Adds modulation.
-    void sine_wave_generator::add_modulation(int_least32_t x)
+    // Adds modulation, count times at once.
+    void sine_wave_generator::add_modulation(int_least32_t x, std::size_t count)
     {
-        position += static_cast<int_least32_t>(static_cast<int_least64_t>(step) * x >> 16);
+        position += static_cast<int_least32_t>((static_cast<int_least64_t>(step) * x >> 16) * static_cast<int_least64_t>(count));
     }
     // Gets the next sample.
     inline int sine_wave_generator::get_next()
@@ -691,6 +803,33 @@ namespace midisynth{
         uint_least32_t p = ((position += step) / 32768 + m) % sine_table::DIVISION;
         return sine_table.get(p);
     }
+    // Skips count samples and gets the last one. Used by the LFOs, which run at control rate.
+    int sine_wave_generator::advance(std::size_t count)
+    {
+        position += step * static_cast<uint_least32_t>(count);
+        return sine_table.get(position / 32768 % sine_table::DIVISION);
+    }
+    // Gets the next count samples (modulation may be NULL).
+    // The phase of each sample is computed from the block start instead of
+    // being accumulated, so the loops carry no dependency and can be vectorized.
+    void sine_wave_generator::get_block(int_least32_t* out, std::size_t count, const int_least32_t* modulation)
+    {
+        uint_least32_t position = this->position;
+        uint_least32_t step = this->step;
+        if(modulation){
+            for(std::size_t i = 0; i < count; ++i){
+                uint_least32_t m = modulation[i] * sine_table::DIVISION / 65536;
+                uint_least32_t p = position + step * static_cast<uint_least32_t>(i + 1);
+                out[i] = sine_table.get((p / 32768 + m) % sine_table::DIVISION);
+            }
+        }else{
+            for(std::size_t i = 0; i < count; ++i){
+                uint_least32_t p = position + step * static_cast<uint_least32_t>(i + 1);
+                out[i] = sine_table.get(p / 32768 % sine_table::DIVISION);
+            }
+        }
+        this->position = position + step * static_cast<uint_least32_t>(count);
+    }
 
     // Logarithmic conversion table. Use in the subsequent decay of the envelope generator.
     namespace{
@@ -753,7 +892,7 @@ namespace midisynth{
     // Envelope generator constructor.
     envelope_generator::envelope_generator(int AR_, int DR_, int SR_, int RR_, int SL, int TL_):
         state(ATTACK), AR(AR_), DR(DR_), SR(SR_), RR(RR_), TL(TL_),
-        current(0), rate(1), hold(0), freeze(0)
+        current(0), level(0), rate(1), hold(0), freeze(0)
     {	    
         if(AR >= 63) AR = 63;
         if(DR >= 63) DR = 63;
@@ -767,14 +906,13 @@ namespace midisynth{
         assert(TL >= 0 && TL <= 127);
 
         fTL = envelope_table.TL[TL];
-        fSS = fSL = envelope_table.SL[SL][TL];
+        fSL = envelope_table.SL[SL][TL];
         fAR = 0;
         fDR = 0;
         fSR = 0;
         fRR = 0;
         fOR = 0;
         fDRR = 0;
-        fDSS = 0;
     }
     // Set the playback rate.
     inline void envelope_generator::set_rate(float rate)
@@ -825,9 +963,7 @@ namespace midisynth{
         this->fSR = static_cast<uint_least32_t>(fSR);
         this->fRR = static_cast<uint_least32_t>(fRR);
         this->fOR = static_cast<uint_least32_t>(envelope_table.RR[63][0] / rate);
-        this->fSS = std::max(this->fDR, fSL);
         this->fDRR = std::max(this->fDR, this->fRR);
-        this->fDSS = std::max(this->fDRR, this->fSS);
     }
     // Key-off. Gets into release step.
     void envelope_generator::key_off()
@@ -867,29 +1003,30 @@ namespace midisynth{
     // In fact it gets muted when lesser than 1 as it is rounded to an integer actually.
     // A higher value may sound not natural but improves performance
     #define SOUNDOFF_LEVEL 1024
-    // Gets the next sample.
-    int envelope_generator::get_next()
+    // Advances the envelope by count samples at once and returns the level reached.
+    int envelope_generator::advance(uint_least32_t count)
     {
         uint_least32_t current = this->current;
         switch(state){
         case ATTACK:
             if(current < fTL){
-                return this->current = current + fAR;
+                return this->current = std::min(current + fAR * count, fTL);
             }
             this->current = static_cast<uint_least32_t>(65536 * LOGTABLE_FACTOR * std::log10(static_cast<double>(fTL)));
             state = DECAY;
             return fTL;
         case DECAY:
-            if(current > fSS){
-                this->current = current -= fDR;
+            // Stops at the sustain level instead of overshooting it by up to a block
+            if(current > fSL && current - fSL > fDR * count){
+                this->current = current -= fDR * count;
                 return log_table.get(current / 65536);
             }
             this->current = current = fSL;
             state = SASTAIN;
             return log_table.get(current / 65536);
         case SASTAIN:
-            if(current > fSR){
-                this->current = current -= fSR;
+            if(current > fSR * count){
+                this->current = current -= fSR * count;
                 int n = log_table.get(current / 65536);
                 if(n > 1){
                     return n;
@@ -899,22 +1036,22 @@ namespace midisynth{
             return 0;
         case ATTACK_RELEASE:
             if(current < fTL){
-                return this->current = current + fAR;
+                return this->current = std::min(current + fAR * count, fTL);
             }
             this->current = static_cast<uint_least32_t>(65536 * LOGTABLE_FACTOR * std::log10(static_cast<double>(fTL)));
             state = DECAY_RELEASE;
             return fTL;
         case DECAY_RELEASE:
-            if(current > fDSS){
-                this->current = current -= fDRR;
+            if(current > fSL && current - fSL > fDRR * count){
+                this->current = current -= fDRR * count;
                 return log_table.get(current / 65536);
             }
             this->current = current = fSL;
             state = RELEASE;
             return log_table.get(current / 65536);
         case RELEASE:
-            if(current > fRR){
-                this->current = current -= fRR;
+            if(current > fRR * count){
+                this->current = current -= fRR * count;
                 int n = log_table.get(current / 65536);
                 if(n > SOUNDOFF_LEVEL){
                     return n;
@@ -925,8 +1062,8 @@ namespace midisynth{
             state = FINISHED;
             return 0;
         case SOUNDOFF:
-            if(current > fOR){
-                this->current = current -= fOR;
+            if(current > fOR * count){
+                this->current = current -= fOR * count;
                 int n = log_table.get(current / 65536);
                 if(n > 1){
                     return n;
@@ -938,6 +1075,20 @@ namespace midisynth{
             return 0;
         }
     }
+    // Gets the next count levels.
+    // The envelope is evaluated once per block (control rate) and interpolated linearly in between.
+    void envelope_generator::get_block(int_least32_t* out, std::size_t count)
+    {
+        assert(count > 0);
+        int_least32_t from = level;
+        level = advance(static_cast<uint_least32_t>(count));
+        // 10 bits of fraction, the level difference is at most 16 bits and the block at most 32 samples
+        int_least32_t delta = ((level - from) * 1024) / static_cast<int_least32_t>(count);
+        for(std::size_t i = 0; i < count; ++i){
+            out[i] = from + ((delta * static_cast<int_least32_t>(i + 1)) >> 10);
+        }
+        out[count - 1] = level;
+    }
 
     namespace{
         // Key scaling table
@@ -1087,18 +1238,32 @@ namespace midisynth{
         swg.set_cycle(rate / freq);
         eg.set_rate(rate);
     }
-    // Gets the next sample.
-    inline int fm_operator::get_next()
+    // Gets the next count samples (modulate may be NULL).
+    void fm_operator::get_block(int_least32_t* out, std::size_t count, const int_least32_t* modulate, int ams)
     {
-        return static_cast<int_least32_t>(swg.get_next()) * eg.get_next() >> 15;
-    }
-    inline int fm_operator::get_next(int modulate)
-    {
-        return static_cast<int_least32_t>(swg.get_next(modulate)) * eg.get_next() >> 15;
+        int_least32_t env[fm_sound_generator::BLOCK_SIZE];
+        assert(count <= fm_sound_generator::BLOCK_SIZE);
+        int_least32_t gain = ams * ams_factor + ams_bias;
+        eg.get_block(env, count);
+        swg.get_block(out, count, modulate);
+        for(std::size_t i = 0; i < count; ++i){
+            out[i] = (out[i] * env[i] >> 15) * gain >> 15;
+        }
     }
-    inline int fm_operator::get_next(int ams, int modulate)
-    {
-        return (static_cast<int_least32_t>(swg.get_next(modulate)) * eg.get_next() >> 15) * (ams * ams_factor + ams_bias) >> 15;
+    // Gets the next count samples modulated by its own output.
+    // Each sample depends on the previous one, so this one can not be vectorized.
+    void fm_operator::get_block(int_least32_t* out, std::size_t count, int& feedback, int FB, int ams)
+    {
+        int_least32_t env[fm_sound_generator::BLOCK_SIZE];
+        assert(count <= fm_sound_generator::BLOCK_SIZE);
+        int_least32_t gain = ams * ams_factor + ams_bias;
+        eg.get_block(env, count);
+        int_least32_t last = feedback;
+        for(std::size_t i = 0; i < count; ++i){
+            int modulate = (last << 1) >> FB;
+            out[i] = last = (static_cast<int_least32_t>(swg.get_next(modulate)) * env[i] >> 15) * gain >> 15;
+        }
+        feedback = last;
     }
 
     // Vibrato table.
@@ -1259,109 +1424,133 @@ namespace midisynth{
             return true;
         }
     }
-    // Gets the next sample.
-    int fm_sound_generator::get_next()
+    namespace{
+        // Adds a block of operator output to another.
+        inline void mix_block(int_least32_t* out, const int_least32_t* in, std::size_t count)
+        {
+            for(std::size_t i = 0; i < count; ++i){
+                out[i] += in[i];
+            }
+        }
+    }
+    // Gets the next count samples, at most BLOCK_SIZE.
+    void fm_sound_generator::get_block(int_least32_t* out, std::size_t count)
     {
+        assert(count <= BLOCK_SIZE);
         if(vibrato_depth){
-            int x = static_cast<int_least32_t>(vibrato_lfo.get_next()) * vibrato_depth >> 15;
+            int x = static_cast<int_least32_t>(vibrato_lfo.advance(count)) * vibrato_depth >> 15;
             int_least32_t modulation = vibrato_table.get(x);
-            op1.add_modulation(modulation);
-            op2.add_modulation(modulation);
-            op3.add_modulation(modulation);
-            op4.add_modulation(modulation);
-        }
-        int feedback = (this->feedback << 1) >> FB;
-        int ret;
-        if(ams_enable){
-            int ams = ams_lfo.get_next() >> 7;
-            switch(ALG){
-            case 0:
-                ret = op4(ams, op3(ams, op2(ams, this->feedback = op1(ams, feedback))));
-                break;
-            case 1:
-                ret = op4(ams, op3(ams, op2(ams, 0) + (this->feedback = op1(ams, feedback))));
-                break;
-            case 2:
-                ret = op4(ams, op3(ams, op2(ams, 0)) + (this->feedback = op1(ams, feedback)));
-                break;
-            case 3:
-                ret = op4(ams, op3(ams, 0) + op2(ams, this->feedback = op1(ams, feedback)));
-                break;
-            case 4:
-                ret = op4(ams, op3(ams, 0)) + op2(ams, this->feedback = op1(ams, feedback));
-                break;
-            case 5:
-                this->feedback = feedback = op1(ams, feedback);
-                ret = op4(ams, feedback) + op3(ams, feedback) + op2(ams, feedback);
-                break;
-            case 6:
-                ret = op4(ams, 0) + op3(ams, 0) + op2(ams, this->feedback = op1(ams, feedback));
-                break;
-            case 7:
-                ret = op4(ams, 0) + op3(ams, 0) + op2(ams, 0) + (this->feedback = op1(ams, feedback));
-                break;
-            default:
-                assert(!"fm_sound_generator: invalid algorithm number");
-                return 0;
-            }
-        }else{
-            switch(ALG){
-            case 0:
-                ret = op4(op3(op2(this->feedback = op1(feedback))));
-                break;
-            case 1:
-                ret = op4(op3(op2() + (this->feedback = op1(feedback))));
-                break;
-            case 2:
-                ret = op4(op3(op2()) + (this->feedback = op1(feedback)));
-                break;
-            case 3:
-                ret = op4(op3() + op2(this->feedback = op1(feedback)));
-                break;
-            case 4:
-                ret = op4(op3()) + op2(this->feedback = op1(feedback));
-                break;
-            case 5:
-                this->feedback = feedback = op1(feedback);
-                ret = op4(feedback) + op3(feedback) + op2(feedback);
-                break;
-            case 6:
-                ret = op4() + op3() + op2(this->feedback = op1(feedback));
-                break;
-            case 7:
-                ret = op4() + op3() + op2() + (this->feedback = op1(feedback));
-                break;
-            default:
-                assert(!"fm_sound_generator: invalid algorithm number");
-                return 0;
-            }
+            op1.add_modulation(modulation, count);
+            op2.add_modulation(modulation, count);
+            op3.add_modulation(modulation, count);
+            op4.add_modulation(modulation, count);
+        }
+        // Without AMS every operator has a gain of exactly 1.0 whatever the LFO value is.
+        int ams = ams_enable ? ams_lfo.advance(count) >> 7 : 0;
+        int_least32_t m1[BLOCK_SIZE], m2[BLOCK_SIZE], m3[BLOCK_SIZE];
+        op1.get_block(m1, count, feedback, FB, ams);
+        switch(ALG){
+        case 0:
+            op2.get_block(m2, count, m1, ams);
+            op3.get_block(m3, count, m2, ams);
+            op4.get_block(out, count, m3, ams);
+            break;
+        case 1:
+            op2.get_block(m2, count, NULL, ams);
+            mix_block(m2, m1, count);
+            op3.get_block(m3, count, m2, ams);
+            op4.get_block(out, count, m3, ams);
+            break;
+        case 2:
+            op2.get_block(m2, count, NULL, ams);
+            op3.get_block(m3, count, m2, ams);
+            mix_block(m3, m1, count);
+            op4.get_block(out, count, m3, ams);
+            break;
+        case 3:
+            op3.get_block(m3, count, NULL, ams);
+            op2.get_block(m2, count, m1, ams);
+            mix_block(m3, m2, count);
+            op4.get_block(out, count, m3, ams);
+            break;
+        case 4:
+            op3.get_block(m3, count, NULL, ams);
+            op4.get_block(out, count, m3, ams);
+            op2.get_block(m2, count, m1, ams);
+            mix_block(out, m2, count);
+            break;
+        case 5:
+            op4.get_block(out, count, m1, ams);
+            op3.get_block(m3, count, m1, ams);
+            op2.get_block(m2, count, m1, ams);
+            mix_block(out, m3, count);
+            mix_block(out, m2, count);
+            break;
+        case 6:
+            op4.get_block(out, count, NULL, ams);
+            op3.get_block(m3, count, NULL, ams);
+            op2.get_block(m2, count, m1, ams);
+            mix_block(out, m3, count);
+            mix_block(out, m2, count);
+            break;
+        case 7:
+            op4.get_block(out, count, NULL, ams);
+            op3.get_block(m3, count, NULL, ams);
+            op2.get_block(m2, count, NULL, ams);
+            mix_block(out, m3, count);
+            mix_block(out, m2, count);
+            mix_block(out, m1, count);
+            break;
+        default:
+            assert(!"fm_sound_generator: invalid algorithm number");
+            std::fill(out, out + count, 0);
+            return;
         }
         if(tremolo_depth){
-            int_least32_t x = 4096 - (((static_cast<int_least32_t>(tremolo_lfo.get_next()) + 32768) * tremolo_depth) >> 11);
-            ret = ret * x >> 12;
+            int_least32_t x = 4096 - (((static_cast<int_least32_t>(tremolo_lfo.advance(count)) + 32768) * tremolo_depth) >> 11);
+            for(std::size_t i = 0; i < count; ++i){
+                out[i] = out[i] * x >> 12;
+            }
         }
-        return ret;
     }
 
     // FM notes constructor.
-    fm_note::fm_note(const FMPARAMETER& params, int note, int velocity_, int panpot, int assign, float frequency_multiplier):
+    fm_note::fm_note(const FMPARAMETER& params, int note, int velocity_, int panpot, int assign, float frequency_multiplier, fm_note_pool* pool_):
         midisynth::note(assign, panpot),
         fm(params, note, frequency_multiplier),
-        velocity(velocity_)
+        velocity(velocity_),
+        pool(pool_)
     {
         assert(velocity >= 1 && velocity <= 127);
         ++velocity;
     }
+    // Frees the note, pooled notes return their slot.
+    void fm_note::release()
+    {
+        if(pool){
+            fm_note_pool* p = pool;
+            this->~fm_note();
+            p->deallocate(this);
+        }else{
+            delete this;
+        }
+    }
     // Waveform output.
     bool fm_note::synthesize(int_least32_t* buf, std::size_t samples, float rate, int_least32_t left, int_least32_t right)
     {
         left = (left * velocity) >> 7;
         right = (right * velocity) >> 7;
         fm.set_rate(rate);
-        for(std::size_t i = 0; i < samples; ++i){
-            int_least32_t sample = fm.get_next();
-            buf[i * 2 + 0] += (sample * left) >> 14;
-            buf[i * 2 + 1] += (sample * right) >> 14;
+        int_least32_t block[fm_sound_generator::BLOCK_SIZE];
+        while(samples){
+            std::size_t n = std::min<std::size_t>(samples, fm_sound_generator::BLOCK_SIZE);
+            fm.get_block(block, n);
+            for(std::size_t i = 0; i < n; ++i){
+                buf[i * 2 + 0] += (block[i] * left) >> 14;
+                buf[i * 2 + 1] += (block[i] * right) >> 14;
+            }
+            buf += n * 2;
+            samples -= n;
         }
         return !fm.is_finished();
     }
@@ -1406,8 +1595,35 @@ namespace midisynth{
         fm.set_freeze(value);
     }
 
+    // FM note pool constructor.
+    fm_note_pool::fm_note_pool(std::size_t capacity):
+        slots(capacity)
+    {
+        free_slots.reserve(capacity);
+        for(std::size_t i = capacity; i > 0; --i){
+            free_slots.push_back(&slots[i - 1]);
+        }
+    }
+    // Takes a free slot.
+    void* fm_note_pool::allocate()
+    {
+        if(free_slots.empty()){
+            return NULL;
+        }
+        void* p = free_slots.back();
+        free_slots.pop_back();
+        return p;
+    }
+    // Returns a slot.
+    void fm_note_pool::deallocate(void* p)
+    {
+        assert(free_slots.size() < slots.size());
+        free_slots.push_back(p);
+    }
+
     // FM note factory initialization.
-    fm_note_factory::fm_note_factory()
+    fm_note_factory::fm_note_factory(std::size_t max_notes):
+        pool(max_notes)
     {
         clear();
     }
@@ -1515,25 +1731,41 @@ namespace midisynth{
             return false;
         }
     }
+    // Finds the drum for a note, NULL when the drum set has none.
+    const DRUMPARAMETER* fm_note_factory::find_drum(int_least32_t program, int note)const
+    {
+        int n = (program & 0x3FFF) * 128 + note;
+        std::map<int, DRUMPARAMETER>::const_iterator i = drums.find(n);
+        if(i == drums.end()){
+            i = drums.find(n & 0x3FFF);
+        }
+        if(i == drums.end()){
+            i = drums.find(note);
+        }
+        if(i == drums.end()){
+            i = drums.find(-1);
+        }
+        return i != drums.end() ? &i->second : NULL;
+    }
+    // Whether note_on creates a note. Unknown programs use the default tone.
+    bool fm_note_factory::can_note_on(int_least32_t program, int note)const
+    {
+        return (program >> 14) != 120 || find_drum(program, note) != NULL;
+    }
     // Note on.
     note* fm_note_factory::note_on(int_least32_t program, int note, int velocity, float frequency_multiplier)
     {
         bool drum = (program >> 14) == 120;
         if(drum){
-            int n = (program & 0x3FFF) * 128 + note;
-            struct DRUMPARAMETER* p;
-            if(drums.find(n) != drums.end()){
-                p = &drums[n];
-            }else if(drums.find(n & 0x3FFF) != drums.end()){
-                p = &drums[n & 0x3FFF];
-            }else if(drums.find(note) != drums.end()){
-                p = &drums[note];
-            }else if(drums.find(-1) != drums.end()){
-                p = &drums[-1];
-            }else{
+            const struct DRUMPARAMETER* p = find_drum(program, note);
+            if(!p){
+                return NULL;
+            }
+            void* storage = pool.allocate();
+            if(!storage){
                 return NULL;
             }
-            return new fm_note(*p, p->key, velocity, p->panpot, p->assign, 1);
+            return new(storage) fm_note(*p, p->key, velocity, p->panpot, p->assign, 1, &pool);
         }else{
             struct FMPARAMETER* p;
             if(programs.find(program) != programs.end()){
@@ -1543,7 +1775,11 @@ namespace midisynth{
             }else{
                 p = &programs[-1];
             }
-            return new fm_note(*p, note, velocity, 8192, 0, frequency_multiplier);
+            void* storage = pool.allocate();
+            if(!storage){
+                return NULL;
+            }
+            return new(storage) fm_note(*p, note, velocity, 8192, 0, frequency_multiplier, &pool);
         }
     }
 }
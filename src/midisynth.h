@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 #include <map>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 namespace midisynth{
@@ -44,6 +45,9 @@ namespace midisynth{
     */
     class channel;
 
+    // Default polyphony: notes sounding at once over all channels.
+    enum{ DEFAULT_MAX_VOICES = 64 };
+
     // System mode enumeration type.
     enum system_mode_t{ system_mode_default, system_mode_gm, system_mode_gm2, system_mode_gs, system_mode_xg };
 
@@ -61,8 +65,12 @@ namespace midisynth{
     public:
         note(int assign_, int panpot_):assign(assign_), panpot(panpot_){}
         virtual ~note(){}
+        // Frees the note, notes are owned by the channel that plays them.
+        virtual void release(){ delete this; }
         int get_assign()const{ return assign; }
         int get_panpot()const{ return panpot; }
+        // Loudness estimate used to choose notes to steal.
+        virtual int get_level()const{ return 0; }
         virtual bool synthesize(int_least32_t* buf, std::size_t samples, float rate, int_least32_t left, int_least32_t right) = 0;
         virtual void note_off(int velocity) = 0;
         virtual void sound_off() = 0;
@@ -82,6 +90,10 @@ namespace midisynth{
     class note_factory:uncopyable{
     public:
         virtual note* note_on(int_least32_t program, int note, int velocity, float frequency_multiplier)=0;
+        // Number of notes that can exist at once, 0 for no limit.
+        virtual int get_max_notes()const{ return 0; }
+        // Whether note_on creates a note for the program and key when a note is free.
+        virtual bool can_note_on(int_least32_t /*program*/, int /*note*/)const{ return true; }
     protected:
         ~note_factory(){}
     };
@@ -90,7 +102,7 @@ namespace midisynth{
     class channel:uncopyable{
         enum{ NUM_NOTES = 128 };
     public:
-        channel(note_factory* factory, int bank);
+        channel(note_factory* factory, int bank, uint_least32_t& serial_counter);
         ~channel();
 
         int synthesize(int_least32_t* out, std::size_t samples, float rate, int_least32_t master_volume, int master_balance);
@@ -102,6 +114,10 @@ namespace midisynth{
 
         void note_off(int note, int velocity);
         void note_on(int note, int velocity);
+        int get_num_notes()const{ return static_cast<int>(notes.size()); }
+        bool can_note_on(int note)const{ return factory->can_note_on(program, note); }
+        bool get_steal_candidate(bool& released, uint_least32_t& serial, double& level)const;
+        void steal_note();
         void polyphonic_key_pressure(int note, int value);
         void program_change(int value){ set_program(128 * bank + value); }
         void channel_pressure(int value);
@@ -161,9 +177,12 @@ namespace midisynth{
             enum STATUS{
                 NOTEON, NOTEOFF, SOUNDOFF
             }status;
-            NOTE(class note* p, int key_):note(p),key(key_),status(NOTEON){}
+            // Note on order over all channels, used to find the oldest note.
+            uint_least32_t serial;
+            NOTE(class note* p, int key_, uint_least32_t serial_):note(p),key(key_),status(NOTEON),serial(serial_){}
         };
         std::vector<NOTE> notes;
+        uint_least32_t& next_serial;
         note_factory* factory;
         int default_bank;
         int program;
@@ -191,6 +210,7 @@ namespace midisynth{
         float master_frequency_multiplier;
         system_mode_t system_mode;
 
+        std::vector<NOTE>::const_iterator find_steal_candidate()const;
         int get_registered_parameter();
         void set_registered_parameter(int value);
         void update_frequency_multiplier();
@@ -214,7 +234,7 @@ namespace midisynth{
         void all_sound_off();
         void all_sound_off_immediately();
 
-        void note_on(int channel, int note, int velocity){ get_channel(channel)->note_on(note, velocity); }
+        void note_on(int channel, int note, int velocity);
         void note_off(int channel, int note, int velocity){ get_channel(channel)->note_off(note, velocity); }
         void polyphonic_key_pressure(int channel, int note, int value){ get_channel(channel)->polyphonic_key_pressure(note, value); }
         void control_change(int channel, int control, int value){ get_channel(channel)->control_change(control, value); }
@@ -231,6 +251,7 @@ namespace midisynth{
         void set_master_fine_tuning(int value){ master_fine_tuning = value; update_master_frequency_multiplier(); }
         void set_master_coarse_tuning(int value){ master_coarse_tuning = value; update_master_frequency_multiplier(); }
         void set_system_mode(system_mode_t mode);
+        void set_max_voices(int value);
 
         int get_main_volume()const{ return main_volume; }
         int get_master_volume()const{ return master_volume; }
@@ -238,9 +259,16 @@ namespace midisynth{
         int get_master_fine_tuning()const{ return master_fine_tuning; }
         int get_master_coarse_tuning()const{ return master_coarse_tuning; }
         system_mode_t get_system_mode()const{ return system_mode; }
+        int get_max_voices()const{ return max_voices; }
+        int get_num_voices()const;
 
     private:
         std::unique_ptr<channel> channels[NUM_CHANNELS];
+        std::vector<int_least32_t> mixing_buffer;
+        note_factory* factory;
+        // Note on order over all channels of this synthesizer.
+        uint_least32_t next_serial;
+        int max_voices;
         float active_sensing;
         int main_volume;
         int master_volume;
@@ -250,6 +278,7 @@ namespace midisynth{
         float master_frequency_multiplier;
         system_mode_t system_mode;
         void update_master_frequency_multiplier();
+        void steal_voice();
     };
 
     // Sine wave generator.
@@ -259,9 +288,11 @@ namespace midisynth{
         sine_wave_generator();
         sine_wave_generator(float cycle);
         void set_cycle(float cycle);
-        void add_modulation(int_least32_t x);
+        void add_modulation(int_least32_t x, std::size_t count = 1);
         int get_next();
         int get_next(int_least32_t modulation);
+        int advance(std::size_t count);
+        void get_block(int_least32_t* out, std::size_t count, const int_least32_t* modulation);
     private:
         uint_least32_t position;
         uint_least32_t step;
@@ -278,16 +309,18 @@ namespace midisynth{
         void key_off();
         void sound_off();
         bool is_finished()const{ return state == FINISHED; }
-        int get_next();
+        void get_block(int_least32_t* out, std::size_t count);
     private:
         enum{ ATTACK, ATTACK_RELEASE, DECAY, DECAY_RELEASE, SASTAIN, RELEASE, SOUNDOFF, FINISHED }state;
         int AR, DR, SR, RR, TL;
-        uint_least32_t fAR, fDR, fSR, fRR, fSL, fTL, fOR, fSS, fDRR, fDSS;
+        uint_least32_t fAR, fDR, fSR, fRR, fSL, fTL, fOR, fDRR;
         uint_least32_t current;
+        int_least32_t level;
         float rate;
         float hold;
         float freeze;
         void update_parameters();
+        int advance(uint_least32_t count);
     };
 
     // FM operator (modulator and carrier).
@@ -297,16 +330,12 @@ namespace midisynth{
         void set_freq_rate(float freq, float rate);
         void set_hold(float value){ eg.set_hold(value); }
         void set_freeze(float value){ eg.set_freeze(value); }
-        void add_modulation(int_least32_t x){ swg.add_modulation(x); }
+        void add_modulation(int_least32_t x, std::size_t count){ swg.add_modulation(x, count); }
         void key_off(){ eg.key_off(); }
         void sound_off(){ eg.sound_off(); }
         bool is_finished()const{ return eg.is_finished(); }
-        int get_next();
-        int get_next(int modulate);
-        int get_next(int lfo, int modulate);
-        inline int operator()(){ return get_next(); }
-        inline int operator()(int m){ return get_next(m); }
-        inline int operator()(int lfo, int m){ return get_next(lfo, m); }
+        void get_block(int_least32_t* out, std::size_t count, const int_least32_t* modulate, int lfo);
+        void get_block(int_least32_t* out, std::size_t count, int& feedback, int FB, int lfo);
     private:
         sine_wave_generator swg;
         envelope_generator eg;
@@ -331,6 +360,8 @@ namespace midisynth{
     // FM sound generator.
     class fm_sound_generator{
     public:
+        // Samples rendered per block. Envelopes and LFOs are updated once per block.
+        enum{ BLOCK_SIZE = 32 };
         fm_sound_generator(const FMPARAMETER& params, int note, float frequency_multiplier);
         void set_rate(float rate);
         void set_frequency_multiplier(float value);
@@ -342,7 +373,7 @@ namespace midisynth{
         void key_off();
         void sound_off();
         bool is_finished()const;
-        int get_next();
+        void get_block(int_least32_t* out, std::size_t count);
     private:
         fm_operator op1;
         fm_operator op2;
@@ -368,10 +399,12 @@ namespace midisynth{
     };
 
     // FM sound generator notes.
+    class fm_note_pool;
     class fm_note:public note{
     public:
-        fm_note(const FMPARAMETER& params, int note, int velocity, int panpot, int assign, float frequency_multiplier);
-        virtual void release(){ delete this; }
+        fm_note(const FMPARAMETER& params, int note, int velocity, int panpot, int assign, float frequency_multiplier, fm_note_pool* pool = NULL);
+        virtual void release();
+        virtual int get_level()const{ return velocity; }
         virtual bool synthesize(int_least32_t* buf, std::size_t samples, float rate, int_least32_t left, int_least32_t right);
         virtual void note_off(int velocity);
         virtual void sound_off();
@@ -384,20 +417,42 @@ namespace midisynth{
     public:
         fm_sound_generator fm;
         int velocity;
+    private:
+        fm_note_pool* pool;
+    };
+
+    // Fixed-capacity storage for FM notes, so playing notes does not
+    // allocate. Free slots are kept in a free list.
+    class fm_note_pool:uncopyable{
+    public:
+        explicit fm_note_pool(std::size_t capacity);
+        // Returns storage for one note or NULL when all slots are in use.
+        void* allocate();
+        void deallocate(void* p);
+        std::size_t get_capacity()const{ return slots.size(); }
+        std::size_t get_num_used()const{ return slots.size() - free_slots.size(); }
+    private:
+        typedef std::aligned_storage<sizeof(fm_note), alignof(fm_note)>::type slot;
+        std::vector<slot> slots;
+        std::vector<void*> free_slots;
     };
 
     // FM sound generator note factory.
     class fm_note_factory:public note_factory{
     public:
-        fm_note_factory();
+        explicit fm_note_factory(std::size_t max_notes = DEFAULT_MAX_VOICES);
         void clear();
         void get_program(int number, FMPARAMETER& p);
         bool set_program(int number, const FMPARAMETER& p);
         bool set_drum_program(int number, const DRUMPARAMETER& p);
         virtual note* note_on(int_least32_t program, int note, int velocity, float frequency_multiplier);
+        virtual int get_max_notes()const{ return static_cast<int>(pool.get_capacity()); }
+        virtual bool can_note_on(int_least32_t program, int note)const;
     private:
+        const DRUMPARAMETER* find_drum(int_least32_t program, int note)const;
         std::map<int, FMPARAMETER> programs;
         std::map<int, DRUMPARAMETER> drums;
+        fm_note_pool pool;
     };
 }
 
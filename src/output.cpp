@@ -42,11 +42,20 @@
 #include "bitmap.h"
 #include "main_data.h"
 #include "message_overlay.h"
+#include "thread_pool.h"
 #include "utils.h"
 
+#ifdef SUPPORT_THREADS
+#  include <mutex>
+#endif
+
 namespace {
 	std::ofstream LOG_FILE;
 	bool init = false;
+#ifdef SUPPORT_THREADS
+	// Image decoders log from worker threads
+	std::mutex log_mutex;
+#endif
 	
 	std::ostream& output_time() {
 		if (!init) {
@@ -117,6 +126,10 @@ void Output::IgnorePause(bool const val) {
 }
 
 static void WriteLog(std::string const& type, std::string const& msg, Color const& c = Color()) {
+#ifdef SUPPORT_THREADS
+	std::lock_guard<std::mutex> lock(log_mutex);
+#endif
+
 // Skip logging to file in the browser
 #ifndef EMSCRIPTEN
 	if (!Main_Data::GetSavePath().empty()) {
@@ -252,6 +265,14 @@ void Output::Error(const char* fmt, ...) {
 }
 
 void Output::ErrorStr(std::string const& err) {
+#ifdef SUPPORT_THREADS
+	if (ThreadPool::IsWorkerThread()) {
+		// Only the main thread may show the error and exit
+		WriteLog("Debug", err);
+		throw ThreadPool::JobFailed();
+	}
+#endif
+
 	WriteLog("Error", err);
 	static bool recursive_call = false;
 	if (!recursive_call && DisplayUi) {
@@ -26,7 +26,8 @@ Plane::Plane() :
 	visible(true),
 	z(0),
 	ox(0),
-	oy(0) {
+	oy(0),
+	drawn_state(DamageState()) {
 
 	Graphics::RegisterDrawable(this);
 }
@@ -36,6 +37,8 @@ Plane::~Plane() {
 }
 
 void Plane::Draw() {
+	drawn_state = GetDamageState();
+
 	if (!visible || !bitmap) return;
 
 	BitmapRef dst = DisplayUi->GetDisplaySurface();
@@ -44,6 +47,40 @@ void Plane::Draw() {
 	dst->TiledBlit(-ox, -oy, bitmap->GetRect(), *bitmap, dst_rect, 255);
 }
 
+bool Plane::GetDamage(Rect& damage) {
+	damage = Rect();
+
+	if (!(GetDamageState() == drawn_state)) {
+		// Tiled over the whole screen
+		damage = Rect(0, 0, DisplayUi->GetWidth(), DisplayUi->GetHeight());
+	}
+
+	return true;
+}
+
+Plane::DamageState Plane::GetDamageState() const {
+	DamageState state = DamageState();
+
+	state.shown = visible && bitmap;
+
+	if (state.shown) {
+		state.z = z;
+		state.revision = bitmap->GetRevision();
+		state.ox = ox;
+		state.oy = oy;
+	}
+
+	return state;
+}
+
+bool Plane::DamageState::operator==(const DamageState& other) const {
+	return shown == other.shown &&
+		z == other.z &&
+		revision == other.revision &&
+		ox == other.ox &&
+		oy == other.oy;
+}
+
 BitmapRef const& Plane::GetBitmap() const {
 	return bitmap;
 }
@@ -61,7 +98,7 @@ int Plane::GetZ() const {
 	return z;
 }
 void Plane::SetZ(int nz) {
-	if (z != nz) Graphics::UpdateZCallback();
+	if (z != nz) Graphics::UpdateZCallback(this);
 	z = nz;
 }
 int Plane::GetOx() const {
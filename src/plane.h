@@ -34,6 +34,8 @@ public:
 
 	void Draw() override;
 
+	bool GetDamage(Rect& damage) override;
+
 	BitmapRef const& GetBitmap() const;
 	void SetBitmap(BitmapRef const& bitmap);
 	bool GetVisible() const;
@@ -56,6 +58,22 @@ private:
 	int z;
 	int ox;
 	int oy;
+
+	/** Everything that decides which pixels Draw produces. */
+	struct DamageState {
+		bool shown;
+		int z;
+		uint32_t revision;
+		int ox;
+		int oy;
+
+		bool operator==(const DamageState& other) const;
+	};
+
+	/** State of the last Draw call. */
+	DamageState drawn_state;
+
+	DamageState GetDamageState() const;
 };
 
 #endif
@@ -44,8 +44,12 @@
 
 #include "async_handler.h"
 #include "audio.h"
+#include "audio_stream.h"
 #include "cache.h"
+#include "decoded_image_cache.h"
+#include "event_profiler.h"
 #include "filefinder.h"
+#include "frame_tracer.h"
 #include "game_actors.h"
 #include "game_map.h"
 #include "game_message.h"
@@ -69,6 +73,7 @@
 #include "reader_util.h"
 #include "scene_battle.h"
 #include "scene_logo.h"
+#include "thread_pool.h"
 #include "utils.h"
 #include "version.h"
 
@@ -89,6 +94,11 @@ namespace Player {
 	int start_map_id;
 	bool no_rtp_flag;
 	bool no_audio_flag;
+	bool damage_tracking_flag;
+	bool headless_flag;
+	int headless_frames;
+	std::string headless_input;
+	bool profile_events_flag;
 	std::string encoding;
 	std::string escape_symbol;
 	int engine;
@@ -196,6 +206,14 @@ void Player::Init(int argc, char *argv[]) {
 
 	ParseCommandLine(argc, argv);
 
+	if (profile_events_flag) {
+		if (EventProfiler::IsAvailable()) {
+			EventProfiler::SetEnabled(true);
+		} else {
+			Output::Debug("--profile-events: Event profiler not available in this build");
+		}
+	}
+
 #ifdef EMSCRIPTEN
 	Output::IgnorePause(true);
 
@@ -279,6 +297,8 @@ void Player::Resume() {
 }
 
 void Player::Update(bool update_scene) {
+	FrameTracer::Scope trace("Player::Update");
+
 	// available ms per frame, game logic expects 60 fps
 	static const double framerate_interval = 1000.0 / Graphics::GetDefaultFps();
 	next_frame = start_time + framerate_interval;
@@ -329,9 +349,16 @@ void Player::Update(bool update_scene) {
 		}
 	}
 
-	Audio().Update();
-	Input::Update();
+	{
+		FrameTracer::Scope trace_audio("Audio::Update");
+		Audio().Update();
+	}
+	{
+		FrameTracer::Scope trace_input("Input::Update");
+		Input::Update();
+	}
 	if (update_scene) {
+		FrameTracer::Scope trace_scene("Scene::Update");
 		Scene::instance->Update();
 	}
 
@@ -367,6 +394,10 @@ void Player::Exit() {
 	DisplayUi->UpdateDisplay();
 #endif
 
+	EventProfiler::Dump();
+	FrameTracer::Finish();
+	ThreadPool::Quit();
+
 	Font::Dispose();
 	Graphics::Quit();
 	FileFinder::Quit();
@@ -416,6 +447,11 @@ void Player::ParseCommandLine(int argc, char *argv[]) {
 	start_map_id = -1;
 	no_rtp_flag = false;
 	no_audio_flag = false;
+	damage_tracking_flag = false;
+	headless_flag = false;
+	headless_frames = 0;
+	headless_input.clear();
+	profile_events_flag = false;
 
 	std::vector<std::string> args;
 
@@ -569,9 +605,69 @@ void Player::ParseCommandLine(int argc, char *argv[]) {
 		else if (*it == "--disable-audio") {
 			no_audio_flag = true;
 		}
+		else if (*it == "--audio-buffer") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			AudioStream::SetBufferAhead(atoi((*it).c_str()));
+		}
 		else if (*it == "--disable-rtp") {
 			no_rtp_flag = true;
 		}
+		else if (*it == "--damage-tracking") {
+			damage_tracking_flag = true;
+		}
+		else if (*it == "--decoded-image-cache") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			if (DecodedImageCache::IsAvailable()) {
+				// case sensitive
+				DecodedImageCache::SetDirectory(argv[it - args.begin() + 1]);
+			} else {
+				Output::Debug("--decoded-image-cache: Not supported on this platform");
+			}
+		}
+		else if (*it == "--image-cache-size") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			Cache::SetRetentionBudget(static_cast<size_t>(std::max(atoi((*it).c_str()), 0)) * 1024);
+		}
+		else if (*it == "--trace-frames") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			// case sensitive
+			FrameTracer::Start(argv[it - args.begin() + 1]);
+		}
+		else if (*it == "--profile-events") {
+			profile_events_flag = true;
+		}
+		else if (*it == "--headless") {
+			headless_flag = true;
+		}
+		else if (*it == "--headless-frames") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			headless_flag = true;
+			headless_frames = atoi((*it).c_str());
+		}
+		else if (*it == "--headless-input") {
+			++it;
+			if (it == args.end()) {
+				return;
+			}
+			headless_flag = true;
+			// case sensitive
+			headless_input = argv[it - args.begin() + 1];
+		}
 		else if (*it == "--version" || *it == "-v") {
 			PrintVersion();
 			exit(0);
@@ -838,7 +934,15 @@ void Player::PrintUsage() {
 	std::cout <<
 R"(EasyRPG Player - An open source interpreter for RPG Maker 2000/2003 games.
 Options:
+      --audio-buffer MS    Decode streamed music MS milliseconds ahead
+                           (default 200). Raise it when the music stutters.
       --battle-test N      Start a battle test with monster party N.
+      --damage-tracking    Only repaint the parts of the screen that changed.
+                           Saves power on slow devices.
+      --decoded-image-cache PATH
+                           Store decoded images in PATH and map them on later
+                           launches instead of decoding them again. The
+                           directory must exist.
       --disable-audio      Disable audio (in case you prefer your own music).
       --disable-rtp        Disable support for the Runtime Package (RTP).
       --encoding N         Instead of auto detecting the encoding or using
@@ -850,12 +954,24 @@ Options:
                             rpg2k3  - RPG Maker 2003 engine
                             rpg2k3e - RPG Maker 2003 (English release) engine
       --fullscreen         Start in fullscreen mode.
+      --headless           Run without display and audio as fast as possible
+                           and report the frame rate on exit.
+      --headless-frames N  Run headless and exit after N frames.
+      --headless-input F   Run headless and replay the input script F.
+                           Every line has the form "FRAME KEY [DURATION]".
       --show-fps           Enable frames per second counter.
       --hide-title         Hide the title background image and center the
                            command menu.
+      --image-cache-size N Keep up to N KiB of recently used images decoded
+                           (default 8192). 0 frees images as soon as they
+                           are unused.
       --load-game-id N     Skip the title scene and load SaveN.lsd
                            (N is padded to two digits).
       --new-game           Skip the title scene and start a new game directly.
+      --profile-events     Record the time spent per event and command and
+                           write it to event_profile.csv/.json in the save
+                           directory on exit. Needs a build with the event
+                           profiler enabled.
       --project-path PATH  Instead of using the working directory the game in
                            PATH is used.
       --save-path PATH     Instead of storing save files in the game directory
@@ -873,6 +989,9 @@ Options:
                            with IDs A, B, C...
                            Incompatible with --load-game-id.
       --test-play          Enable TestPlay mode.
+      --trace-frames FILE  Record the duration of the frame phases and write
+                           them as Chrome trace (chrome://tracing) to FILE
+                           on exit.
       --window             Start in window mode.
   -v, --version            Display program version and exit.
   -h, --help               Display this help and exit.
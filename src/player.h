@@ -202,6 +202,21 @@ namespace Player {
 	/** Mutes audio playback */
 	extern bool no_audio_flag;
 
+	/** Only repaints the screen areas that changed since the last frame */
+	extern bool damage_tracking_flag;
+
+	/** Runs without display, audio and input devices using a virtual clock */
+	extern bool headless_flag;
+
+	/** Frames after which a headless run exits, 0 runs until the game ends */
+	extern int headless_frames;
+
+	/** Input script replayed by a headless run */
+	extern std::string headless_input;
+
+	/** Records the time spent in event commands (needs ENABLE_EVENT_PROFILER) */
+	extern bool profile_events_flag;
+
 	/** Encoding used */
 	extern std::string encoding;
 
@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <algorithm>
 #include "rect.h"
 
 Rect::Rect() :
@@ -125,6 +126,25 @@ Rect Rect::GetSubRect(const Rect &src_rect) {
 	return rect;
 }
 
+void Rect::Extend(const Rect& rect) {
+	if (rect.IsEmpty()) {
+		return;
+	}
+
+	if (IsEmpty()) {
+		*this = rect;
+		return;
+	}
+
+	int x2 = std::max(x + width, rect.x + rect.width);
+	int y2 = std::max(y + height, rect.y + rect.height);
+
+	x = std::min(x, rect.x);
+	y = std::min(y, rect.y);
+	width = x2 - x;
+	height = y2 - y;
+}
+
 bool Rect::AdjustRectangles(Rect& src, Rect& dst, const Rect& ref) {
 	if (src.x < ref.x) {
 		int dx = ref.x - src.x;
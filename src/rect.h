@@ -108,6 +108,14 @@ public:
 	 */
 	Rect GetSubRect(Rect const& rect);
 
+	/**
+	 * Grows the rect to the bounding box of itself and
+	 * the given rect. Empty rects are ignored.
+	 *
+	 * @param rect rect to include.
+	 */
+	void Extend(Rect const& rect);
+
 	/** X coordinate. */
 	int x;
 
@@ -66,6 +66,8 @@ Scene::Scene() {
 void Scene::MainFunction() {
 	static bool init = false;
 
+	AsyncHandler::Update();
+
 	if (AsyncHandler::IsImportantFilePending() || Graphics::IsTransitionPending()) {
 		Player::Update(false);
 	} else if (!init) {
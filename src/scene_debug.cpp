@@ -21,6 +21,7 @@
 #include <iomanip>
 #include "baseui.h"
 #include "cache.h"
+#include "event_profiler.h"
 #include "input.h"
 #include "game_variables.h"
 #include "game_switches.h"
@@ -31,6 +32,7 @@
 #include "window_command.h"
 #include "window_varlist.h"
 #include "window_numberinput.h"
+#include "window_help.h"
 #include "bitmap.h"
 
 Scene_Debug::Scene_Debug() {
@@ -44,6 +46,7 @@ void Scene_Debug::Start() {
 	CreateRangeWindow();
 	CreateVarListWindow();
 	CreateNumberInputWindow();
+	CreateProfilerWindow();
 
 	range_window->SetActive(true);
 	var_window->SetActive(false);
@@ -82,7 +85,7 @@ void Scene_Debug::Update() {
 			var_window->SetActive(true);
 		} else if (var_window->GetActive()) {
 			if (current_var_type == TypeSwitch && Game_Switches.IsValid(GetIndex()))
-				Game_Switches[GetIndex()] = !Game_Switches[GetIndex()];
+				Game_Switches.Flip(GetIndex());
 			else if (current_var_type == TypeInt && Game_Variables.IsValid(GetIndex())) {
 				var_window->SetActive(false);
 				numberinput_window->SetNumber(Game_Variables[GetIndex()]);
@@ -91,7 +94,7 @@ void Scene_Debug::Update() {
 			}
 			var_window->Refresh();
 		} else if (numberinput_window->GetActive()) {
-			Game_Variables[GetIndex()] = numberinput_window->GetNumber();
+			Game_Variables.Set(GetIndex(), numberinput_window->GetNumber());
 			numberinput_window->SetActive(false);
 			numberinput_window->SetVisible(false);
 			var_window->SetActive(true);
@@ -186,6 +189,21 @@ void Scene_Debug::CreateNumberInputWindow() {
 	numberinput_window->SetShowOperator(true);
 }
 
+void Scene_Debug::CreateProfilerWindow() {
+	if (!EventProfiler::IsEnabled()) {
+		return;
+	}
+
+	// Events do not run while the scene is open, the summary stays valid
+	std::string summary = EventProfiler::GetSummary(1);
+	if (!summary.empty() && summary.back() == '\n') {
+		summary.pop_back();
+	}
+
+	profiler_window.reset(new Window_Help(0, 208, 320, 32));
+	profiler_window->SetText(summary.empty() ? "No events profiled" : summary);
+}
+
 int Scene_Debug::GetIndex() {
 	return (range_page * 100 + range_index * 10 + var_window->GetIndex() + 1);
 }
@@ -25,6 +25,7 @@
 class Window_Command;
 class Window_VarList;
 class Window_NumberInput;
+class Window_Help;
 
 /**
  * Scene Equip class.
@@ -83,12 +84,17 @@ private:
 	/** Creates number input window. */
 	void CreateNumberInputWindow();
 
+	/** Creates event profiler window. */
+	void CreateProfilerWindow();
+
 	/** Displays a range selection for current var type. */
 	std::unique_ptr<Window_Command> range_window;
 	/** Displays the vars inside the current range. */
 	std::unique_ptr<Window_VarList> var_window;
 	/** Number Editor. */
 	std::unique_ptr<Window_NumberInput> numberinput_window;
+	/** Shows the most expensive event, only with --profile-events. */
+	std::unique_ptr<Window_Help> profiler_window;
 };
 
 #endif
@@ -59,9 +59,8 @@ void Scene_Item::Update() {
 
 			if (Data::items[item_id - 1].type == RPG::Item::Type_switch) {
 				Main_Data::game_party->UseItem(item_id);
-				Game_Switches[Data::items[item_id - 1].switch_id] = true;
+				Game_Switches.Set(Data::items[item_id - 1].switch_id, true);
 				Scene::PopUntil(Scene::Map);
-				Game_Map::SetNeedRefresh(Game_Map::Refresh_All);
 			} else {
 				Scene::Push(std::make_shared<Scene_ActorTarget>(item_id, item_window->GetIndex()));
 				item_index = item_window->GetIndex();
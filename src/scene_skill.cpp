@@ -66,7 +66,6 @@ void Scene_Skill::Update() {
 			if (type == RPG::Skill::Type_switch) {
 				actor->UseSkill(skill_id);
 				Scene::PopUntil(Scene::Map);
-				Game_Map::SetNeedRefresh(Game_Map::Refresh_All);
 			} else if (type == RPG::Skill::Type_normal || type >= RPG::Skill::Type_subskill) {
 				Scene::Push(std::make_shared<Scene_ActorTarget>(skill_id, actor_index, skill_window->GetIndex()));
 				skill_index = skill_window->GetIndex();
@@ -47,6 +47,8 @@ void Scene_Title::Start() {
 	}
 
 	CreateCommandWindow();
+
+	Game_System::SePreloadSystem();
 }
 
 void Scene_Title::Continue() {
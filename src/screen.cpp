@@ -46,12 +46,30 @@ DrawableType Screen::GetType() const {
 void Screen::Update() {
 }
 
+bool Screen::GetDamage(Rect& damage) {
+	int flash_time_left;
+	int flash_current_level;
+	Main_Data::game_screen->GetFlash(flash_current_level, flash_time_left);
+
+	// Tone and flash cover the whole composed screen.
+	// ToneBlit also ignores the clip, so always repaint everything.
+	if (drawn_effects || Main_Data::game_screen->GetTone() != default_tone || flash_time_left > 0) {
+		return false;
+	}
+
+	damage = Rect();
+	return true;
+}
+
 void Screen::Draw() {
 	BitmapRef disp = DisplayUi->GetDisplaySurface();
 
 	Tone tone = Main_Data::game_screen->GetTone();
 
+	drawn_effects = false;
+
 	if (tone != default_tone) {
+		drawn_effects = true;
 		disp->ToneBlit(0, 0, *disp, Rect(0, 0, SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT), tone, Opacity::opaque);
 	}
 
@@ -60,6 +78,8 @@ void Screen::Draw() {
 	Color flash_color = Main_Data::game_screen->GetFlash(flash_current_level, flash_time_left);
 
 	if (flash_time_left > 0) {
+		drawn_effects = true;
+
 		if (!flash) {
 			flash = Bitmap::Create(SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT, flash_color);
 		} else {
@@ -40,6 +40,8 @@ public:
 	void Draw() override;
 	void Update();
 
+	bool GetDamage(Rect& damage) override;
+
 	int GetZ() const override;
 	DrawableType GetType() const override;
 
@@ -49,6 +51,9 @@ private:
 
 	Tone default_tone;
 	BitmapRef flash;
+
+	/** Whether the last Draw call applied tone or flash. */
+	bool drawn_effects = false;
 };
 
 #endif
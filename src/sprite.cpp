@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <cmath>
 #include <string>
 #include "sprite.h"
 #include "player.h"
@@ -57,7 +58,8 @@ Sprite::Sprite() :
 	current_tone(Tone()),
 	current_flash(Color(0,0,0,0)),
 	current_flip_x(false),
-	current_flip_y(false) {
+	current_flip_y(false),
+	drawn_state(DamageState()) {
 
 	Graphics::RegisterDrawable(this);
 }
@@ -69,18 +71,130 @@ Sprite::~Sprite() {
 
 // Draw
 void Sprite::Draw() {
+	drawn_state = GetDamageState();
+
 	if (!visible) return;
 	if (GetWidth() <= 0 || GetHeight() <= 0) return;
 
 	BlitScreen();
 }
 
+bool Sprite::GetDamage(Rect& damage) {
+	DamageState state = GetDamageState();
+
+	// Rotated and wavering sprites don't cover their rect
+	if (state.transformed || drawn_state.transformed) {
+		return false;
+	}
+
+	damage = Rect();
+
+	if (!(state == drawn_state)) {
+		if (drawn_state.shown) {
+			damage = drawn_state.rect;
+		}
+		if (state.shown) {
+			damage.Extend(state.rect);
+		}
+	}
+
+	return true;
+}
+
+Sprite::DamageState Sprite::GetDamageState() const {
+	DamageState state = DamageState();
+
+	state.shown = visible && GetWidth() > 0 && GetHeight() > 0 && bitmap &&
+		(opacity_top_effect > 0 || opacity_bottom_effect > 0);
+
+	if (!state.shown) {
+		return state;
+	}
+
+	state.transformed = angle_effect != 0.0 || waver_effect_depth != 0;
+
+	Rect effect_rect = src_rect_effect;
+	Rect rect = effect_rect.GetSubRect(src_rect);
+	rect.Adjust(bitmap->GetWidth(), bitmap->GetHeight());
+
+	if (zoom_x_effect != 1.0 || zoom_y_effect != 1.0) {
+		// One pixel extra for the rounding of the stretched blit
+		state.rect = Rect(
+			x - static_cast<int>(std::floor(ox * zoom_x_effect)),
+			y - static_cast<int>(std::floor(oy * zoom_y_effect)),
+			static_cast<int>(std::ceil(rect.width * zoom_x_effect)) + 1,
+			static_cast<int>(std::ceil(rect.height * zoom_y_effect)) + 1);
+	} else {
+		state.rect = Rect(x - ox, y - oy, rect.width, rect.height);
+	}
+
+	state.z = z;
+	state.revision = bitmap->GetRevision();
+	state.src_rect = rect;
+	state.opacity_top = opacity_top_effect;
+	state.opacity_bottom = opacity_bottom_effect;
+	state.bush_depth = bush_effect;
+	state.tone = tone_effect;
+	state.flash = flash_effect;
+	state.flip_x = flipx_effect;
+	state.flip_y = flipy_effect;
+
+	return state;
+}
+
+bool Sprite::DamageState::operator==(const DamageState& other) const {
+	return shown == other.shown &&
+		transformed == other.transformed &&
+		rect == other.rect &&
+		z == other.z &&
+		revision == other.revision &&
+		src_rect == other.src_rect &&
+		opacity_top == other.opacity_top &&
+		opacity_bottom == other.opacity_bottom &&
+		bush_depth == other.bush_depth &&
+		tone == other.tone &&
+		flash == other.flash &&
+		flip_x == other.flip_x &&
+		flip_y == other.flip_y;
+}
+
 void Sprite::BlitScreen() {
 	if (!bitmap || (opacity_top_effect <= 0 && opacity_bottom_effect <= 0))
 		return;
 
 	Rect rect = src_rect_effect.GetSubRect(src_rect);
 
+	bool no_effects = tone_effect == Tone() && flash_effect.alpha == 0 && !flipx_effect && !flipy_effect;
+	bool transformed = zoom_x_effect != 1.0 || zoom_y_effect != 1.0 || angle_effect != 0.0 || waver_effect_depth != 0;
+	bool effects_changed = tone_effect != current_tone ||
+		flash_effect != current_flash ||
+		flipx_effect != current_flip_x ||
+		flipy_effect != current_flip_y;
+
+	if (!no_effects && !transformed && (effects_changed || bitmap_changed)) {
+		// Flashes and fades change the effects every frame. Apply them while
+		// compositing instead of rebuilding bitmap_effects. When they stay the
+		// same for another frame bitmap_effects is created by Refresh.
+		current_tone = tone_effect;
+		current_flash = flash_effect;
+		current_flip_x = flipx_effect;
+		current_flip_y = flipy_effect;
+
+		bitmap_effects.reset();
+		bitmap_effects_valid = false;
+
+		bitmap_changed = false;
+		needs_refresh = false;
+
+		rect.Adjust(bitmap->GetWidth(), bitmap->GetHeight());
+
+		BitmapRef dst = DisplayUi->GetDisplaySurface();
+		dst->EffectsBlit(x, y, ox, oy, *bitmap, rect,
+						 Opacity(opacity_top_effect, opacity_bottom_effect, bush_effect),
+						 tone_effect, flash_effect, flipx_effect, flipy_effect);
+		return;
+	}
+
 	BitmapRef draw_bitmap = Refresh(rect);
 
 	bitmap_changed = false;
@@ -129,8 +243,12 @@ BitmapRef Sprite::Refresh(Rect& rect) {
 		bitmap_effects_valid = false;
 	}
 
-	if (no_effects)
+	if (no_effects) {
+		// Release the copy once the effects are gone
+		bitmap_effects.reset();
+		bitmap_effects_valid = false;
 		return bitmap;
+	}
 
 	if (bitmap_effects && bitmap_effects_valid)
 		return bitmap_effects;
@@ -290,7 +408,7 @@ int Sprite::GetZ() const {
 	return z;
 }
 void Sprite::SetZ(int nz) {
-	if (z != nz) Graphics::UpdateZCallback();
+	if (z != nz) Graphics::UpdateZCallback(this);
 	z = nz;
 }
 
@@ -34,6 +34,8 @@ public:
 
 	void Draw() override;
 
+	bool GetDamage(Rect& damage) override;
+
 	virtual void Flash(int duration);
 	virtual void Flash(Color color, int duration);
 	void Update();
@@ -131,6 +133,30 @@ private:
 	bool current_flip_x;
 	bool current_flip_y;
 
+	/** Everything that decides which pixels Draw produces. */
+	struct DamageState {
+		bool shown;
+		bool transformed;
+		Rect rect;
+		int z;
+		uint32_t revision;
+		Rect src_rect;
+		int opacity_top;
+		int opacity_bottom;
+		int bush_depth;
+		Tone tone;
+		Color flash;
+		bool flip_x;
+		bool flip_y;
+
+		bool operator==(const DamageState& other) const;
+	};
+
+	/** State of the last Draw call. */
+	DamageState drawn_state;
+
+	DamageState GetDamageState() const;
+
 	void BlitScreen();
 	void BlitScreenIntern(Bitmap const& draw_bitmap,
 							Rect const& src_rect, int opacity_split) const;
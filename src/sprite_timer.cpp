@@ -43,6 +43,8 @@ void Sprite_Timer::Draw() {
 	bool timer_visible;
 	bool battle;
 
+	drawn = false;
+
 	Main_Data::game_party->GetTimer(which, &timer_visible, &battle);
 
 	if (!GetVisible() || !timer_visible) {
@@ -71,9 +73,27 @@ void Sprite_Timer::Draw() {
 		GetBitmap()->Blit(i * 8, 0, *system, digits[i], Opacity());
 	}
 
+	drawn = true;
 	Sprite::Draw();
 }
 
+bool Sprite_Timer::GetDamage(Rect& damage) {
+	bool timer_visible;
+	bool battle;
+
+	Main_Data::game_party->GetTimer(which, &timer_visible, &battle);
+
+	bool shown = GetVisible() && timer_visible && (!Game_Temp::battle_running || battle);
+
+	if (!shown && !drawn) {
+		damage = Rect();
+		return true;
+	}
+
+	// The digits are rendered in Draw, changes are not known in advance
+	return false;
+}
+
 void Sprite_Timer::Update() {
 	bool timer_visible;
 	bool battle;
@@ -43,9 +43,11 @@ public:
 protected:
 	void CreateSprite();
 	void Draw() override;
+	bool GetDamage(Rect& damage) override;
 
 	int which;
 	int counter;
+	bool drawn = false;
 
 	Rect digits[5];
 };
@@ -58,6 +58,14 @@
 
 #define SUPPORT_ZOOM
 
+/*
+ * Decode images on worker threads.
+ * Needs exceptions, errors on a worker end the job instead of exiting.
+ */
+#if !defined(EMSCRIPTEN) && !defined(GEKKO) && !defined(PSP) && !defined(_3DS) && !defined(PSP2) && !defined(OPENDINGUX) && !defined(GPH)
+#  define SUPPORT_THREADS
+#endif
+
 #ifdef USE_SDL
 #  define USE_SDL_MIXER
 
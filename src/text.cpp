@@ -27,85 +27,137 @@
 
 #include <cctype>
 #include <iterator>
+#include <list>
+#include <map>
+#include <tuple>
+
+namespace {
+	/** Amount of rendered text runs kept by the cache. */
+	const size_t text_cache_size = 256;
+
+	struct TextRun {
+		/** Font and system graphic, kept alive so the pointers stay unique. */
+		FontRef font;
+		BitmapRef system;
+		BitmapRef bitmap;
+	};
+
+	// font, font name, size, bold, italic, system graphic, color, text
+	typedef std::tuple<Font*, std::string, unsigned, bool, bool, Bitmap*, int, std::string> text_run_key;
+	typedef std::list<std::pair<text_run_key, TextRun> > text_run_list;
+
+	text_run_list text_runs;
+	std::map<text_run_key, text_run_list::iterator> text_run_cache;
+
+	BitmapRef RenderRun(Font& font, Bitmap const& system, int color, std::string const& text, Rect const& size) {
+		// Complete text will be on this surface, with place for the shadow
+		BitmapRef text_surface = Bitmap::Create(size.width + 1, size.height + 1, true);
+		text_surface->Clear();
+
+		// Where to draw the next glyph (x pos)
+		int next_glyph_pos = 0;
+
+		// The current char is an exfont
+		bool is_exfont = false;
+
+		// This loops always renders a single char, color blends it and then puts
+		// it onto the text_surface (including the drop shadow)
+		std::u32string u32text = Utils::DecodeUTF32(text);
+		for (auto c = u32text.begin(), end = u32text.end(); c != end; ++c) {
+			Rect next_glyph_rect(next_glyph_pos, 0, 0, 0);
+
+			char32_t const next_c = std::distance(c, end) > 1? *std::next(c) : 0;
+
+			// ExFont-Detection: Check for A-Z or a-z behind the $
+			if (*c == '$' && std::isalpha(next_c)) {
+				int exfont_value = -1;
+				// Calculate which exfont shall be rendered
+				if (islower(next_c)) {
+					exfont_value = 26 + next_c - 'a';
+				} else if (isupper(next_c)) {
+					exfont_value = next_c - 'A';
+				} else { assert(false); }
+				is_exfont = true;
+
+				Font::exfont->Render(*text_surface, next_glyph_rect.x, next_glyph_rect.y, system, color, exfont_value);
+			} else { // Not ExFont, draw normal text
+				font.Render(*text_surface, next_glyph_rect.x, next_glyph_rect.y, system, color, *c);
+			}
+
+			// If it's a full size glyph, add the size of a half-size glyph twice
+			if (is_exfont) {
+				is_exfont = false;
+				next_glyph_pos += 12;
+				// Skip the next character
+				++c;
+			} else {
+				next_glyph_pos += font.GetSize(std::u32string(1, *c)).width;
+			}
+		}
+
+		return text_surface;
+	}
+}
 
 void Text::Draw(Bitmap& dest, int x, int y, int color, std::string const& text, Text::Alignment align) {
 	if (text.length() == 0) return;
 
 	FontRef font = dest.GetFont();
-	Rect dst_rect = font->GetSize(text);
+	BitmapRef system = Cache::System();
+
+	text_run_key const key(font.get(), font->name, font->size, font->bold, font->italic, system.get(), color, text);
+
+	BitmapRef text_bmp;
+
+	std::map<text_run_key, text_run_list::iterator>::iterator const it = text_run_cache.find(key);
+	if (it != text_run_cache.end()) {
+		// Move to the front of the LRU list
+		text_runs.splice(text_runs.begin(), text_runs, it->second);
+		text_bmp = it->second->second.bitmap;
+	}
+
+	Rect const size = text_bmp ? text_bmp->GetRect() : font->GetSize(text);
+	Rect dst_rect = size;
+	if (!text_bmp) {
+		dst_rect.width += 1; dst_rect.height += 1; // Need place for shadow
+	}
 
 	switch (align) {
 	case Text::AlignCenter:
-		dst_rect.x = x - dst_rect.width / 2; break;
+		dst_rect.x = x - (dst_rect.width - 1) / 2; break;
 	case Text::AlignRight:
-		dst_rect.x = x - dst_rect.width; break;
+		dst_rect.x = x - (dst_rect.width - 1); break;
 	case Text::AlignLeft:
 		dst_rect.x = x; break;
 	default: assert(false);
 	}
 
 	dst_rect.y = y;
-	dst_rect.width += 1; dst_rect.height += 1; // Need place for shadow
 	if (dst_rect.IsOutOfBounds(dest.GetWidth(), dest.GetHeight())) return;
 
-	BitmapRef text_surface; // Complete text will be on this surface
-	text_surface = Bitmap::Create(dst_rect.width, dst_rect.height, true);
-	text_surface->SetTransparentColor(dest.GetTransparentColor());
-	text_surface->Clear();
+	if (!text_bmp) {
+		text_bmp = RenderRun(*font, *system, color, text, size);
 
-	BitmapRef system = Cache::System();
+		TextRun run;
+		run.font = font;
+		run.system = system;
+		run.bitmap = text_bmp;
 
-	// Where to draw the next glyph (x pos)
-	int next_glyph_pos = 0;
+		text_runs.push_front(std::make_pair(key, run));
+		text_run_cache[key] = text_runs.begin();
 
-	// The current char is an exfont
-	bool is_exfont = false;
-
-	// This loops always renders a single char, color blends it and then puts
-	// it onto the text_surface (including the drop shadow)
-	std::u32string u32text = Utils::DecodeUTF32(text);
-	for (auto c = u32text.begin(), end = u32text.end(); c != end; ++c) {
-		Rect next_glyph_rect(next_glyph_pos, 0, 0, 0);
-
-		char32_t const next_c = std::distance(c, end) > 1? *std::next(c) : 0;
-
-		// ExFont-Detection: Check for A-Z or a-z behind the $
-		if (*c == '$' && std::isalpha(next_c)) {
-			int exfont_value = -1;
-			// Calculate which exfont shall be rendered
-			if (islower(next_c)) {
-				exfont_value = 26 + next_c - 'a';
-			} else if (isupper(next_c)) {
-				exfont_value = next_c - 'A';
-			} else { assert(false); }
-			is_exfont = true;
-
-			Font::exfont->Render(*text_surface, next_glyph_rect.x, next_glyph_rect.y, *system, color, exfont_value);
-		} else { // Not ExFont, draw normal text
-			font->Render(*text_surface, next_glyph_rect.x, next_glyph_rect.y, *system, color, *c);
-		}
-
-		// If it's a full size glyph, add the size of a half-size glyph twice
-		if (is_exfont) {
-			is_exfont = false;
-			next_glyph_pos += 12;
-			// Skip the next character
-			++c;
-		} else {
-			next_glyph_pos += font->GetSize(std::u32string(1, *c)).width;
+		if (text_runs.size() > text_cache_size) {
+			text_run_cache.erase(text_runs.back().first);
+			text_runs.pop_back();
 		}
 	}
 
-	BitmapRef text_bmp = Bitmap::Create(*text_surface, text_surface->GetRect());
-
-	Rect src_rect(0, 0, dst_rect.width, dst_rect.height);
-	int iy = dst_rect.y;
-	if (dst_rect.height > text_bmp->GetHeight()) {
-		iy += ((dst_rect.height - text_bmp->GetHeight()) / 2);
-	}
-	int ix = dst_rect.x;
+	dest.Blit(dst_rect.x, dst_rect.y, *text_bmp, text_bmp->GetRect(), 255);
+}
 
-	dest.Blit(ix, iy, *text_bmp, src_rect, 255);
+void Text::ClearCache() {
+	text_run_cache.clear();
+	text_runs.clear();
 }
 
 void Text::Draw(Bitmap& dest, int x, int y, Color color, std::string const& text) {
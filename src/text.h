@@ -29,11 +29,21 @@ namespace Text {
 		AlignRight
 	};
 
+	/**
+	 * Draws text using a color of the system graphic on dest.
+	 * Rendered text runs are cached, drawing the same text again is a
+	 * single blit.
+	 */
 	void Draw(Bitmap& dest, int x, int y, int color, std::string const& text, Text::Alignment align = Text::AlignLeft);
 
 	/**
 	 * Draws text using the specified color on dest
 	 */
 	void Draw(Bitmap& dest, int x, int y, Color color, std::string const& text);
+
+	/**
+	 * Releases all cached text runs.
+	 */
+	void ClearCache();
 }
 #endif
@@ -0,0 +1,167 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headers
+#include "thread_pool.h"
+
+#ifdef SUPPORT_THREADS
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+	struct Job {
+		std::function<void()> work;
+		std::function<void()> done;
+	};
+
+	/** Worker threads, decoding is CPU bound so more do not help. */
+	constexpr unsigned max_workers = 4;
+
+	std::vector<std::thread> workers;
+
+	/** Guards queued, finished and quit. */
+	std::mutex mutex;
+	std::condition_variable job_available;
+	std::deque<Job> queued;
+	std::vector<std::function<void()>> finished;
+	bool quit = false;
+
+	thread_local bool is_worker = false;
+
+	void RunWorker() {
+		is_worker = true;
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		for (;;) {
+			job_available.wait(lock, [] { return quit || !queued.empty(); });
+			if (quit) {
+				return;
+			}
+
+			Job job = std::move(queued.front());
+			queued.pop_front();
+
+			lock.unlock();
+			try {
+				job.work();
+			} catch (ThreadPool::JobFailed const&) {
+				// Error was logged, done handles the missing result
+			}
+			lock.lock();
+
+			if (!quit) {
+				finished.push_back(std::move(job.done));
+			}
+		}
+	}
+
+	void StartWorkers() {
+		static bool registered = false;
+		if (!registered) {
+			// exit() from anywhere must not destroy joinable threads
+			std::atexit(ThreadPool::Quit);
+			registered = true;
+		}
+
+		quit = false;
+
+		// Leave one core to the main thread
+		unsigned count = std::thread::hardware_concurrency();
+		count = std::max(1u, std::min(max_workers, count > 1 ? count - 1 : 1u));
+
+		for (unsigned i = 0; i < count; ++i) {
+			workers.emplace_back(RunWorker);
+		}
+	}
+}
+
+bool ThreadPool::IsAvailable() {
+	return true;
+}
+
+bool ThreadPool::IsWorkerThread() {
+	return is_worker;
+}
+
+void ThreadPool::Submit(std::function<void()> work, std::function<void()> done) {
+	if (workers.empty()) {
+		StartWorkers();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.push_back(Job{std::move(work), std::move(done)});
+	}
+	job_available.notify_one();
+}
+
+void ThreadPool::Update() {
+	std::vector<std::function<void()>> done;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (finished.empty()) {
+			return;
+		}
+		done.swap(finished);
+	}
+
+	for (auto& func : done) {
+		func();
+	}
+}
+
+void ThreadPool::Quit() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		queued.clear();
+		finished.clear();
+	}
+	job_available.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+}
+#else
+bool ThreadPool::IsAvailable() {
+	return false;
+}
+
+bool ThreadPool::IsWorkerThread() {
+	return false;
+}
+
+void ThreadPool::Submit(std::function<void()> work, std::function<void()> done) {
+	work();
+	done();
+}
+
+void ThreadPool::Update() {
+}
+
+void ThreadPool::Quit() {
+}
+#endif
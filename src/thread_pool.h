@@ -0,0 +1,73 @@
+/*
+ * This file is part of EasyRPG Player.
+ *
+ * EasyRPG Player is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EasyRPG Player is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EasyRPG Player. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+// Headers
+#include <functional>
+#include "system.h"
+
+/**
+ * Runs jobs on worker threads.
+ * The work part of a job runs on a worker, the done part afterwards on
+ * the main thread in Update. Work functions must not touch the display,
+ * audio or game state.
+ */
+namespace ThreadPool {
+	/**
+	 * @return whether jobs run on worker threads.
+	 *         Otherwise Submit runs the work immediately.
+	 */
+	bool IsAvailable();
+
+	/**
+	 * @return whether the calling thread is a worker.
+	 */
+	bool IsWorkerThread();
+
+	/**
+	 * Thrown by Output::Error on a worker thread instead of exiting.
+	 * The job ends there, its done function still runs and has to cope
+	 * with the missing result. The main thread reports the error when it
+	 * loads the resource itself.
+	 */
+	struct JobFailed {};
+
+	/**
+	 * Queues a job. The workers are started on first use.
+	 *
+	 * @param work function called on a worker thread.
+	 * @param done function called on the main thread after work finished.
+	 */
+	void Submit(std::function<void()> work, std::function<void()> done);
+
+	/**
+	 * Calls the done functions of finished jobs.
+	 * Must be called from the main thread.
+	 */
+	void Update();
+
+	/**
+	 * Discards queued jobs and stops the workers.
+	 * Jobs in progress are finished, their done functions are not called.
+	 * Also runs on exit, the workers must not outlive the main thread.
+	 */
+	void Quit();
+}
+
+#endif
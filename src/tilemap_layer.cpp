@@ -16,6 +16,7 @@
  */
 
 // Headers
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 #include "tilemap_layer.h"
@@ -159,24 +160,249 @@ TilemapLayer::TilemapLayer(int ilayer) :
 	sublayers.push_back(std::make_shared<TilemapSubLayer>(this, -2+layer));
 }
 
-void TilemapLayer::DrawTile(Bitmap& screen, int x, int y, int row, int col, bool autotile) {
-	Bitmap::TileOpacity op = screen.GetTileOpacity(row, col);
+bool TilemapLayer::GetTileSource(const TileData& tile, Bitmap*& src, int& row, int& col) {
+	if (layer == 0) {
+		// If lower layer
+
+		if (tile.ID >= BLOCK_E && tile.ID < BLOCK_E + BLOCK_E_TILES) {
+			int id = substitutions[tile.ID - BLOCK_E];
+			// If Block E
+
+			// Get the tile coordinates from chipset
+			if (id < 96) {
+				// If from first column of the block
+				col = 12 + id % 6;
+				row = id / 6;
+			} else {
+				// If from second column of the block
+				col = 18 + (id - 96) % 6;
+				row = (id - 96) / 6;
+			}
+
+			src = chipset.get();
+		} else if (tile.ID >= BLOCK_C && tile.ID < BLOCK_D) {
+			// If Block C
+
+			// Get the tile coordinates from chipset
+			col = 3 + (tile.ID - BLOCK_C) / 50;
+			row = 4 + animation_step_c;
+
+			src = chipset.get();
+		} else if (tile.ID < BLOCK_C) {
+			// If Blocks A1, A2, B
+
+			// Get the tile from autotile cache
+			TileXY pos = GetCachedAutotileAB(tile.ID, animation_step_ab);
+			col = pos.x;
+			row = pos.y;
+
+			src = autotiles_ab_screen.get();
+		} else {
+			// If blocks D1-D12
+
+			// Get the tile from autotile cache
+			TileXY pos = GetCachedAutotileD(tile.ID);
+			col = pos.x;
+			row = pos.y;
+
+			src = autotiles_d_screen.get();
+		}
+	} else {
+		// If upper layer
+
+		// Check that block F is being drawn
+		if (tile.ID < BLOCK_F || tile.ID >= BLOCK_F + BLOCK_F_TILES) {
+			return false;
+		}
+
+		int id = substitutions[tile.ID - BLOCK_F];
+
+		// Get the tile coordinates from chipset
+		if (id < 48) {
+			// If from first column of the block
+			col = 18 + id % 6;
+			row = 8 + id / 6;
+		} else {
+			// If from second column of the block
+			col = 24 + (id - 48) % 6;
+			row = (id - 48) / 6;
+		}
+
+		src = chipset.get();
+	}
+
+	return src != nullptr;
+}
+
+void TilemapLayer::RenderChunk(Chunk& chunk, int z_order, int chunk_x, int chunk_y) {
+	int tile_x = chunk_x * CHUNK_TILES;
+	int tile_y = chunk_y * CHUNK_TILES;
+	int tiles_w = std::min(CHUNK_TILES, width - tile_x);
+	int tiles_h = std::min(CHUNK_TILES, height - tile_y);
+
+	// Reuse the old bitmap once the first tile is drawn
+	BitmapRef old_bitmap = chunk.bitmap;
+	chunk.bitmap.reset();
+
+	auto create_bitmap = [&]() {
+		if (old_bitmap) {
+			chunk.bitmap = old_bitmap;
+			chunk.bitmap->Clear();
+		} else {
+			chunk.bitmap = Bitmap::Create(tiles_w * TILE_SIZE, tiles_h * TILE_SIZE, true);
+		}
+	};
+
+	chunk.valid = true;
+	chunk.opaque = true;
+	chunk.cells_ab.clear();
+	chunk.cells_c.clear();
+	chunk.step_ab = animation_step_ab;
+	chunk.step_c = animation_step_c;
+
+	for (int y = 0; y < tiles_h; ++y) {
+		for (int x = 0; x < tiles_w; ++x) {
+			const TileData& tile = data_cache[tile_x + x][tile_y + y];
+
+			Bitmap* src;
+			int row, col;
 
-	if (!fast_blit && op == Bitmap::Transparent)
+			if (z_order != tile.z || !GetTileSource(tile, src, row, col)) {
+				chunk.opaque = false;
+				continue;
+			}
+
+			// Animated cells are redrawn alone when the animation advances
+			if (layer == 0 && tile.ID < BLOCK_C) {
+				chunk.cells_ab.push_back(x + y * CHUNK_TILES);
+			} else if (layer == 0 && tile.ID < BLOCK_D) {
+				chunk.cells_c.push_back(x + y * CHUNK_TILES);
+			}
+
+			Bitmap::TileOpacity op = src->GetTileOpacity(row, col);
+
+			if (!fast_blit && op == Bitmap::Transparent) {
+				chunk.opaque = false;
+				continue;
+			}
+
+			if (!chunk.bitmap) {
+				create_bitmap();
+			}
+
+			Rect rect(col * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+
+			if (fast_blit || op == Bitmap::Opaque) {
+				chunk.bitmap->BlitFast(x * TILE_SIZE, y * TILE_SIZE, *src, rect, 255);
+			} else {
+				chunk.bitmap->Blit(x * TILE_SIZE, y * TILE_SIZE, *src, rect, 255);
+				chunk.opaque = false;
+			}
+		}
+	}
+
+	if (!chunk.bitmap && (!chunk.cells_ab.empty() || !chunk.cells_c.empty())) {
+		// Animated tiles that are invisible in this step
+		create_bitmap();
+	}
+}
+
+void TilemapLayer::RenderAnimatedCells(Chunk& chunk, int chunk_x, int chunk_y) {
+	int tile_x = chunk_x * CHUNK_TILES;
+	int tile_y = chunk_y * CHUNK_TILES;
+
+	if (chunk.step_ab != animation_step_ab) {
+		for (short cell : chunk.cells_ab) {
+			int x = cell % CHUNK_TILES;
+			int y = cell / CHUNK_TILES;
+			RenderCell(chunk, x, y, data_cache[tile_x + x][tile_y + y]);
+		}
+		chunk.step_ab = animation_step_ab;
+	}
+
+	if (chunk.step_c != animation_step_c) {
+		for (short cell : chunk.cells_c) {
+			int x = cell % CHUNK_TILES;
+			int y = cell / CHUNK_TILES;
+			RenderCell(chunk, x, y, data_cache[tile_x + x][tile_y + y]);
+		}
+		chunk.step_c = animation_step_c;
+	}
+}
+
+void TilemapLayer::RenderCell(Chunk& chunk, int x, int y, const TileData& tile) {
+	Bitmap* src;
+	int row, col;
+
+	if (!GetTileSource(tile, src, row, col)) {
 		return;
-	Rect rect(col * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+	}
 
-	BitmapRef dst = DisplayUi->GetDisplaySurface();
+	Bitmap::TileOpacity op = src->GetTileOpacity(row, col);
+	Rect rect(col * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE);
 
 	if (fast_blit || op == Bitmap::Opaque) {
-		dst->BlitFast(x, y, screen, rect, 255);
+		chunk.bitmap->BlitFast(x * TILE_SIZE, y * TILE_SIZE, *src, rect, 255);
 	} else {
-		dst->Blit(x, y, screen, rect, 255);
+		chunk.bitmap->ClearRect(Rect(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE));
+		if (op != Bitmap::Transparent) {
+			chunk.bitmap->Blit(x * TILE_SIZE, y * TILE_SIZE, *src, rect, 255);
+		}
+		chunk.opaque = false;
+	}
+}
+
+void TilemapLayer::InvalidateChunks() {
+	chunks.clear();
+}
+
+void TilemapLayer::InvalidateChunk(int tile_x, int tile_y) {
+	int chunks_x = (width + CHUNK_TILES - 1) / CHUNK_TILES;
+	size_t index = tile_x / CHUNK_TILES + tile_y / CHUNK_TILES * chunks_x;
+
+	for (auto& it : chunks) {
+		if (index < it.second.size()) {
+			it.second[index].valid = false;
+		}
+	}
+}
+
+void TilemapLayer::InvalidateChangedChunks(const std::vector<std::vector<TileData> >& old_cache, const std::vector<uint8_t>& old_substitutions) {
+	if (old_cache.size() != data_cache.size() ||
+		(!old_cache.empty() && old_cache[0].size() != data_cache[0].size())) {
+		InvalidateChunks();
+		return;
+	}
+
+	// Index into substitutions of block E (lower layer) and F (upper layer) tiles
+	auto const substitution = [this](short id) {
+		if (layer == 0) {
+			return id >= BLOCK_E && id < BLOCK_E + BLOCK_E_TILES ? id - BLOCK_E : -1;
+		}
+		return id >= BLOCK_F && id < BLOCK_F + BLOCK_F_TILES ? id - BLOCK_F : -1;
+	};
+
+	for (size_t x = 0; x < data_cache.size(); ++x) {
+		for (size_t y = 0; y < data_cache[x].size(); ++y) {
+			const TileData& old_tile = old_cache[x][y];
+			const TileData& tile = data_cache[x][y];
+
+			bool changed = old_tile.ID != tile.ID || old_tile.z != tile.z;
+			if (!changed) {
+				int index = substitution(tile.ID);
+				changed = index >= 0 && ((size_t)index >= old_substitutions.size() ||
+					old_substitutions[index] != substitutions[index]);
+			}
+
+			if (changed) {
+				InvalidateChunk(x, y);
+			}
+		}
 	}
 }
 
 void TilemapLayer::Draw(int z_order) {
-	if (!visible) return;
+	if (!visible || width <= 0 || height <= 0) return;
 
 	// Get the number of tiles that can be displayed on window
 	int tiles_x = (int)ceil(DisplayUi->GetWidth() / (float)TILE_SIZE);
@@ -191,88 +417,84 @@ void TilemapLayer::Draw(int z_order) {
 		++tiles_y;
 	}
 
-	for (int x = 0; x < tiles_x; x++) {
-		for (int y = 0; y < tiles_y; y++) {
-
-			// Get the real maps tile coordinates
-			int map_x = (ox / TILE_SIZE + x + width) % width;
-			int map_y = (oy / TILE_SIZE + y + height) % height;
-
-			if (width <= map_x || height <= map_y) continue;
-
-			int map_draw_x = x * TILE_SIZE - ox % TILE_SIZE;
-			int map_draw_y = y * TILE_SIZE - oy % TILE_SIZE;
-
-			// Get the tile data
-			TileData &tile = data_cache[map_x][map_y];
-
-			// Draw the sublayer if its z is being draw now
-			if (z_order == tile.z) {
-				if (layer == 0) {
-					// If lower layer
-
-					if (tile.ID >= BLOCK_E && tile.ID < BLOCK_E + BLOCK_E_TILES) {
-						int id = substitutions[tile.ID - BLOCK_E];
-						// If Block E
-
-						int row, col;
-
-						// Get the tile coordinates from chipset
-						if (id < 96) {
-							// If from first column of the block
-							col = 12 + id % 6;
-							row = id / 6;
-						} else {
-							// If from second column of the block
-							col = 18 + (id - 96) % 6;
-							row = (id - 96) / 6;
-						}
-
-						DrawTile(*chipset, map_draw_x, map_draw_y, row, col, false);
-					} else if (tile.ID >= BLOCK_C && tile.ID < BLOCK_D) {
-						// If Block C
-
-						// Get the tile coordinates from chipset
-						int col = 3 + (tile.ID - BLOCK_C) / 50;
-						int row = 4 + animation_step_c;
-
-						// Draw the tile
-						DrawTile(*chipset, map_draw_x, map_draw_y, row, col, false);
-					} else if (tile.ID < BLOCK_C) {
-						// If Blocks A1, A2, B
-
-						// Draw the tile from autotile cache
-						TileXY pos = GetCachedAutotileAB(tile.ID, animation_step_ab);
-						DrawTile(*autotiles_ab_screen, map_draw_x, map_draw_y, pos.y, pos.x, true);
-					} else {
-						// If blocks D1-D12
-
-						// Draw the tile from autotile cache
-						TileXY pos = GetCachedAutotileD(tile.ID);
-						DrawTile(*autotiles_d_screen, map_draw_x, map_draw_y, pos.y, pos.x, true);
-					}
-				} else {
-					// If upper layer
-
-					// Check that block F is being drawn
-					if (tile.ID >= BLOCK_F && tile.ID < BLOCK_F + BLOCK_F_TILES) {
-						int id = substitutions[tile.ID - BLOCK_F];
-						int row, col;
-
-						// Get the tile coordinates from chipset
-						if (id < 48) {
-							// If from first column of the block
-							col = 18 + id % 6;
-							row = 8 + id / 6;
-						} else {
-							// If from second column of the block
-							col = 24 + (id - 48) % 6;
-							row = (id - 48) / 6;
-						}
-
-						// Draw the tile
-						DrawTile(*chipset, map_draw_x, map_draw_y, row, col, false);
-					}
+	int chunks_x = (width + CHUNK_TILES - 1) / CHUNK_TILES;
+	int chunks_y = (height + CHUNK_TILES - 1) / CHUNK_TILES;
+
+	std::vector<Chunk>& layer_chunks = chunks[z_order];
+	layer_chunks.resize(chunks_x * chunks_y);
+
+	++chunk_draws;
+
+	// Split the visible tiles into runs that don't leave a chunk.
+	// The map wraps around, so a run also ends at the map border.
+	struct Run {
+		int screen;
+		int map;
+		int length;
+	};
+	std::vector<Run> runs_x;
+	std::vector<Run> runs_y;
+
+	for (int x = 0; x < tiles_x;) {
+		int map_x = (ox / TILE_SIZE + x + width) % width;
+		int length = std::min(std::min(tiles_x - x, CHUNK_TILES - map_x % CHUNK_TILES), width - map_x);
+		runs_x.push_back({ x, map_x, length });
+		x += length;
+	}
+
+	for (int y = 0; y < tiles_y;) {
+		int map_y = (oy / TILE_SIZE + y + height) % height;
+		int length = std::min(std::min(tiles_y - y, CHUNK_TILES - map_y % CHUNK_TILES), height - map_y);
+		runs_y.push_back({ y, map_y, length });
+		y += length;
+	}
+
+	BitmapRef dst = DisplayUi->GetDisplaySurface();
+
+	for (const Run& run_y : runs_y) {
+		for (const Run& run_x : runs_x) {
+			int chunk_x = run_x.map / CHUNK_TILES;
+			int chunk_y = run_y.map / CHUNK_TILES;
+
+			Chunk& chunk = layer_chunks[chunk_x + chunk_y * chunks_x];
+
+			if (!chunk.valid) {
+				RenderChunk(chunk, z_order, chunk_x, chunk_y);
+			} else if (chunk.step_ab != animation_step_ab || chunk.step_c != animation_step_c) {
+				RenderAnimatedCells(chunk, chunk_x, chunk_y);
+			}
+
+			chunk.last_draw = chunk_draws;
+
+			if (!chunk.bitmap) {
+				// No visible tile in this chunk
+				continue;
+			}
+
+			Rect rect(
+				(run_x.map % CHUNK_TILES) * TILE_SIZE,
+				(run_y.map % CHUNK_TILES) * TILE_SIZE,
+				run_x.length * TILE_SIZE,
+				run_y.length * TILE_SIZE);
+
+			int draw_x = run_x.screen * TILE_SIZE - ox % TILE_SIZE;
+			int draw_y = run_y.screen * TILE_SIZE - oy % TILE_SIZE;
+
+			if (chunk.opaque) {
+				dst->BlitFast(draw_x, draw_y, *chunk.bitmap, rect, 255);
+			} else {
+				dst->Blit(draw_x, draw_y, *chunk.bitmap, rect, 255);
+			}
+		}
+	}
+
+	// Free the chunks that scrolled out of view a while ago
+	if (chunk_draws % CHUNK_EVICT_DRAWS == 0) {
+		for (auto& it : chunks) {
+			for (Chunk& chunk : it.second) {
+				if (chunk.bitmap && chunk_draws - chunk.last_draw >= CHUNK_EVICT_DRAWS) {
+					chunk.bitmap.reset();
+					chunk.valid = false;
 				}
 			}
 		}
@@ -530,6 +752,9 @@ BitmapRef TilemapLayer::GenerateAutotiles(int count, const std::map<uint32_t, Ti
 }
 
 void TilemapLayer::Update() {
+	char old_step_ab = animation_step_ab;
+	char old_step_c = animation_step_c;
+
 	animation_frame += 1;
 
 	// Step to the next animation frame
@@ -553,6 +778,10 @@ void TilemapLayer::Update() {
 		animation_step_ab = 0;
 		animation_frame = 0;
 	}
+
+	if (animation_step_ab != old_step_ab || animation_step_c != old_step_c) {
+		++revision;
+	}
 }
 
 BitmapRef const& TilemapLayer::GetChipset() const {
@@ -561,6 +790,8 @@ BitmapRef const& TilemapLayer::GetChipset() const {
 
 void TilemapLayer::SetChipset(BitmapRef const& nchipset) {
 	chipset = nchipset;
+	++revision;
+	InvalidateChunks();
 	if (autotiles_ab_next != 0 && autotiles_d_screen != 0 && layer == 0) {
 		autotiles_ab_screen = GenerateAutotiles(autotiles_ab_next, autotiles_ab_map);
 		autotiles_d_screen = GenerateAutotiles(autotiles_d_next, autotiles_d_map);
@@ -572,6 +803,9 @@ std::vector<short> TilemapLayer::GetMapData() const {
 }
 
 void TilemapLayer::SetMapData(const std::vector<short>& nmap_data) {
+	std::vector<std::vector<TileData> > old_cache;
+	old_cache.swap(data_cache);
+
 	// Create the tiles data cache
 	CreateTileCache(nmap_data);
 	memset(autotiles_ab, 0, sizeof(autotiles_ab));
@@ -603,6 +837,8 @@ void TilemapLayer::SetMapData(const std::vector<short>& nmap_data) {
 	}
 
 	map_data = nmap_data;
+	++revision;
+	InvalidateChangedChunks(old_cache, substitutions);
 }
 
 std::vector<unsigned char> TilemapLayer::GetPassable() const {
@@ -610,6 +846,10 @@ std::vector<unsigned char> TilemapLayer::GetPassable() const {
 }
 
 void TilemapLayer::SetPassable(const std::vector<unsigned char>& npassable) {
+	std::vector<std::vector<TileData> > old_cache;
+	old_cache.swap(data_cache);
+	std::vector<uint8_t> old_substitutions = substitutions;
+
 	passable = npassable;
 
 	if (substitutions.size() < passable.size())
@@ -621,6 +861,8 @@ void TilemapLayer::SetPassable(const std::vector<unsigned char>& npassable) {
 
 	// Recalculate z values of all tiles
 	CreateTileCache(map_data);
+	++revision;
+	InvalidateChangedChunks(old_cache, old_substitutions);
 }
 
 bool TilemapLayer::GetVisible() const {
@@ -628,6 +870,9 @@ bool TilemapLayer::GetVisible() const {
 }
 
 void TilemapLayer::SetVisible(bool nvisible) {
+	if (visible != nvisible) {
+		++revision;
+	}
 	visible = nvisible;
 }
 
@@ -636,6 +881,9 @@ int TilemapLayer::GetOx() const {
 }
 
 void TilemapLayer::SetOx(int nox) {
+	if (ox != nox) {
+		++revision;
+	}
 	ox = nox;
 }
 
@@ -644,6 +892,9 @@ int TilemapLayer::GetOy() const {
 }
 
 void TilemapLayer::SetOy(int noy) {
+	if (oy != noy) {
+		++revision;
+	}
 	oy = noy;
 }
 
@@ -652,6 +903,10 @@ int TilemapLayer::GetWidth() const {
 }
 
 void TilemapLayer::SetWidth(int nwidth) {
+	if (width != nwidth) {
+		++revision;
+		InvalidateChunks();
+	}
 	width = nwidth;
 }
 
@@ -660,6 +915,10 @@ int TilemapLayer::GetHeight() const {
 }
 
 void TilemapLayer::SetHeight(int nheight) {
+	if (height != nheight) {
+		++revision;
+		InvalidateChunks();
+	}
 	height = nheight;
 }
 
@@ -680,6 +939,7 @@ void TilemapLayer::SetAnimationType(int type) {
 }
 
 void TilemapLayer::Substitute(int old_id, int new_id) {
+	std::vector<uint8_t> old_substitutions = substitutions;
 	int subst_count = 0;
 
 	for (size_t i = 0; i < substitutions.size(); ++i) {
@@ -690,15 +950,28 @@ void TilemapLayer::Substitute(int old_id, int new_id) {
 	}
 
 	if (subst_count > 0) {
+		std::vector<std::vector<TileData> > old_cache;
+		old_cache.swap(data_cache);
+
 		// Recalculate z values of all tiles
 		CreateTileCache(map_data);
+		++revision;
+		InvalidateChangedChunks(old_cache, old_substitutions);
 	}
 }
 
 void TilemapLayer::SetFastBlit(bool fast) {
+	if (fast_blit != fast) {
+		++revision;
+		InvalidateChunks();
+	}
 	fast_blit = fast;
 }
 
+uint32_t TilemapLayer::GetRevision() const {
+	return revision;
+}
+
 TilemapSubLayer::TilemapSubLayer(TilemapLayer* tilemap, int z) :
 	type(TypeTilemap),
 	tilemap(tilemap),
@@ -712,6 +985,8 @@ TilemapSubLayer::~TilemapSubLayer() {
 }
 
 void TilemapSubLayer::Draw() {
+	drawn_revision = tilemap->GetRevision();
+
 	if (!tilemap->GetChipset()) {
 		return;
 	}
@@ -719,6 +994,16 @@ void TilemapSubLayer::Draw() {
 	tilemap->Draw(GetZ());
 }
 
+bool TilemapSubLayer::GetDamage(Rect& damage) {
+	damage = Rect();
+
+	if (tilemap->GetRevision() != drawn_revision) {
+		damage = DisplayUi->GetDisplaySurface()->GetRect();
+	}
+
+	return true;
+}
+
 int TilemapSubLayer::GetZ() const {
 	return z;
 }
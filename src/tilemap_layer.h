@@ -36,6 +36,8 @@ public:
 
 	void Draw() override;
 
+	bool GetDamage(Rect& damage) override;
+
 	int GetZ() const override;
 
 	DrawableType GetType() const override;
@@ -44,6 +46,9 @@ private:
 	DrawableType type;
 	TilemapLayer* tilemap;
 	int z;
+
+	/** Tilemap revision of the last Draw call. */
+	uint32_t drawn_revision = 0;
 };
 
 /**
@@ -53,7 +58,6 @@ class TilemapLayer {
 public:
 	TilemapLayer(int ilayer);
 
-	void DrawTile(Bitmap& screen, int x, int y, int row, int col, bool autotile);
 	void Draw(int z_order);
 
 	void Update();
@@ -88,6 +92,14 @@ public:
 	 */
 	void SetFastBlit(bool fast);
 
+	/**
+	 * Gets the revision of the layer.
+	 * Changes whenever the drawn tiles or their position change.
+	 *
+	 * @return revision number.
+	 */
+	uint32_t GetRevision() const;
+
 private:
 	BitmapRef chipset;
 	std::vector<short> map_data;
@@ -105,6 +117,7 @@ private:
 	int animation_type;
 	int layer;
 	bool fast_blit = false;
+	uint32_t revision = 1;
 
 	void CreateTileCache(const std::vector<short>& nmap_data);
 	void GenerateAutotileAB(short ID, short animID);
@@ -142,6 +155,44 @@ private:
 	};
 	std::vector<std::vector<TileData> > data_cache;
 	std::vector<std::shared_ptr<TilemapSubLayer> > sublayers;
+
+	/** Width and height of a chunk in tiles. */
+	static const int CHUNK_TILES = 16;
+
+	/** Chunks not drawn for this amount of Draw calls are freed. */
+	static const int CHUNK_EVICT_DRAWS = 120;
+
+	/**
+	 * Pre-rendered block of CHUNK_TILES x CHUNK_TILES tiles of one sublayer.
+	 * Drawing the map blits the visible parts of a few chunks instead of
+	 * every single tile.
+	 */
+	struct Chunk {
+		/** Rendered tiles, null when no tile is visible. */
+		BitmapRef bitmap;
+		bool valid = false;
+		/** All tiles are opaque, the chunk can be copied without blending. */
+		bool opaque = false;
+		/** Cells with animated tiles of blocks A and B or block C, as x + y * CHUNK_TILES. */
+		std::vector<short> cells_ab;
+		std::vector<short> cells_c;
+		/** Animation steps the animated cells were rendered with. */
+		char step_ab = 0;
+		char step_c = 0;
+		int last_draw = 0;
+	};
+
+	/** Chunks of each sublayer z, indexed by chunk_x + chunk_y * chunks per row. */
+	std::map<int, std::vector<Chunk> > chunks;
+	int chunk_draws = 0;
+
+	bool GetTileSource(const TileData& tile, Bitmap*& src, int& row, int& col);
+	void RenderChunk(Chunk& chunk, int z_order, int chunk_x, int chunk_y);
+	void RenderAnimatedCells(Chunk& chunk, int chunk_x, int chunk_y);
+	void RenderCell(Chunk& chunk, int x, int y, const TileData& tile);
+	void InvalidateChunks();
+	void InvalidateChunk(int tile_x, int tile_y);
+	void InvalidateChangedChunks(const std::vector<std::vector<TileData> >& old_cache, const std::vector<uint8_t>& old_substitutions);
 };
 
 #endif
@@ -47,7 +47,19 @@ DrawableType Weather::GetType() const {
 void Weather::Update() {
 }
 
+bool Weather::GetDamage(Rect& damage) {
+	if (!drawn && Main_Data::game_screen->GetWeatherType() == Game_Screen::Weather_None) {
+		damage = Rect();
+		return true;
+	}
+
+	// Particles move every frame
+	return false;
+}
+
 void Weather::Draw() {
+	drawn = false;
+
 	if (Main_Data::game_screen->GetWeatherType() != Game_Screen::Weather_None) {
 		if (!weather_surface) {
 			weather_surface = Bitmap::Create(SCREEN_TARGET_WIDTH, SCREEN_TARGET_HEIGHT);
@@ -79,6 +91,7 @@ void Weather::Draw() {
 	if (dirty && weather_surface) {
 		BitmapRef dst = DisplayUi->GetDisplaySurface();
 		dst->Blit(0, 0, *weather_surface, weather_surface->GetRect(), 255);
+		drawn = true;
 	}
 }
 
@@ -34,6 +34,8 @@ public:
 	void Draw() override;
 	void Update();
 
+	bool GetDamage(Rect& damage) override;
+
 	int GetZ() const override;
 	DrawableType GetType() const override;
 
@@ -52,6 +54,9 @@ private:
 	BitmapRef rain_bitmap;
 
 	bool dirty;
+
+	/** Whether the last Draw call blitted the weather surface. */
+	bool drawn = false;
 };
 
 #endif
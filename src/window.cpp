@@ -50,7 +50,8 @@ Window::Window():
 	pause_frame(0),
 	animation_frames(0),
 	animation_count(0.0),
-	animation_increment(0.0) {
+	animation_increment(0.0),
+	drawn_state(DamageState()) {
 
 	Graphics::RegisterDrawable(this);
 
@@ -93,6 +94,8 @@ void Window::SetCloseAnimation(int frames) {
 }
 
 void Window::Draw() {
+	drawn_state = GetDamageState();
+
 	if (!visible) return;
 	if (width <= 0 || height <= 0) return;
 	if (x < -width || x > DisplayUi->GetWidth() || y < -height || y > DisplayUi->GetHeight()) return;
@@ -187,6 +190,95 @@ void Window::Draw() {
 	}
 }
 
+bool Window::GetDamage(Rect& damage) {
+	DamageState state = GetDamageState();
+
+	damage = Rect();
+
+	if (state == drawn_state) {
+		return true;
+	}
+
+	// Blinking cursor, only repaint the cursor
+	DamageState blink = drawn_state;
+	blink.cursor_phase = state.cursor_phase;
+	if (state == blink) {
+		damage = state.cursor;
+		return true;
+	}
+
+	if (drawn_state.shown) {
+		damage = drawn_state.rect;
+		damage.Extend(drawn_state.cursor);
+	}
+	if (state.shown) {
+		damage.Extend(state.rect);
+		damage.Extend(state.cursor);
+	}
+
+	return true;
+}
+
+Window::DamageState Window::GetDamageState() const {
+	DamageState state = DamageState();
+
+	state.shown = visible && width > 0 && height > 0 &&
+		!(x < -width || x > DisplayUi->GetWidth() || y < -height || y > DisplayUi->GetHeight());
+
+	if (!state.shown) {
+		return state;
+	}
+
+	state.rect = Rect(x, y, width, height);
+	state.z = z;
+	state.windowskin_revision = windowskin ? windowskin->GetRevision() : 0;
+	state.contents_revision = contents ? contents->GetRevision() : 0;
+	state.stretch = stretch;
+	state.border_x = border_x;
+	state.border_y = border_y;
+	state.ox = ox;
+	state.oy = oy;
+	state.opacity = opacity;
+	state.back_opacity = back_opacity;
+	state.contents_opacity = contents_opacity;
+	state.animation = animation_frames > 0 ? (int)animation_count : -1;
+	state.cursor_shown = windowskin && width >= 16 && height > 16 &&
+		cursor_rect.width > 4 && cursor_rect.height > 4 && animation_frames == 0;
+	if (state.cursor_shown) {
+		state.cursor = Rect(x + cursor_rect.x + border_x, y + cursor_rect.y + border_y,
+			cursor_rect.width, cursor_rect.height);
+		state.cursor_phase = cursor_frame <= 10;
+	}
+	state.pause_shown = pause && pause_frame > 16 && animation_frames <= 0;
+	state.up_arrow = up_arrow;
+	state.down_arrow = down_arrow;
+
+	return state;
+}
+
+bool Window::DamageState::operator==(const DamageState& other) const {
+	return shown == other.shown &&
+		rect == other.rect &&
+		z == other.z &&
+		cursor == other.cursor &&
+		windowskin_revision == other.windowskin_revision &&
+		contents_revision == other.contents_revision &&
+		stretch == other.stretch &&
+		border_x == other.border_x &&
+		border_y == other.border_y &&
+		ox == other.ox &&
+		oy == other.oy &&
+		opacity == other.opacity &&
+		back_opacity == other.back_opacity &&
+		contents_opacity == other.contents_opacity &&
+		animation == other.animation &&
+		cursor_shown == other.cursor_shown &&
+		cursor_phase == other.cursor_phase &&
+		pause_shown == other.pause_shown &&
+		up_arrow == other.up_arrow &&
+		down_arrow == other.down_arrow;
+}
+
 void Window::RefreshBackground() {
 	background_needs_refresh = false;
 
@@ -459,7 +551,7 @@ int Window::GetZ() const {
 	return z;
 }
 void Window::SetZ(int nz) {
-	if (z != nz) Graphics::UpdateZCallback();
+	if (z != nz) Graphics::UpdateZCallback(this);
 	z = nz;
 }
 
@@ -33,6 +33,8 @@ public:
 
 	void Draw() override;
 
+	bool GetDamage(Rect& damage) override;
+
 	void Update();
 	BitmapRef const& GetWindowskin() const;
 	void SetWindowskin(BitmapRef const& nwindowskin);
@@ -124,6 +126,37 @@ private:
 	int animation_frames;
 	double animation_count;
 	double animation_increment;
+
+	/** Everything that decides which pixels Draw produces. */
+	struct DamageState {
+		bool shown;
+		Rect rect;
+		int z;
+		Rect cursor;
+		uint32_t windowskin_revision;
+		uint32_t contents_revision;
+		bool stretch;
+		int border_x;
+		int border_y;
+		int ox;
+		int oy;
+		int opacity;
+		int back_opacity;
+		int contents_opacity;
+		int animation;
+		bool cursor_shown;
+		bool cursor_phase;
+		bool pause_shown;
+		bool up_arrow;
+		bool down_arrow;
+
+		bool operator==(const DamageState& other) const;
+	};
+
+	/** State of the last Draw call. */
+	DamageState drawn_state;
+
+	DamageState GetDamageState() const;
 };
 
 #endif
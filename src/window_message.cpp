@@ -609,8 +609,7 @@ void Window_Message::InputChoice() {
 void Window_Message::InputNumber() {
 	if (Input::IsTriggered(Input::DECISION)) {
 		Game_System::SePlay(Game_System::GetSystemSE(Game_System::SFX_Decision));
-		Game_Variables[Game_Message::num_input_variable_id] = number_input_window->GetNumber();
-		Game_Map::SetNeedRefresh(Game_Map::Refresh_Map);
+		Game_Variables.Set(Game_Message::num_input_variable_id, number_input_window->GetNumber());
 		TerminateMessage();
 		number_input_window->SetNumber(0);
 	}
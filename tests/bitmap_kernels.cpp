@@ -0,0 +1,103 @@
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include "bitmap.h"
+#include "bitmap_kernels.h"
+
+namespace {
+	std::vector<uint32_t> RandomPixels(size_t count) {
+		std::vector<uint32_t> pixels(count);
+		for (size_t i = 0; i < count; ++i) {
+			pixels[i] = (uint32_t)(rand() & 0xFFFF) << 16 | (uint32_t)(rand() & 0xFFFF);
+			// Some fully transparent pixels
+			if (i % 7 == 0) {
+				pixels[i] &= 0x00FFFFFF;
+			}
+		}
+		return pixels;
+	}
+
+	BitmapKernels::ToneParams MakeParams(int gray, int red, int green, int blue, bool skip_transparent) {
+		BitmapKernels::ToneParams params;
+		params.r_shift = 16;
+		params.g_shift = 8;
+		params.b_shift = 0;
+		params.a_shift = 24;
+		params.gray = gray != 128;
+		params.sat = gray > 128 ? 1024 + (gray - 128) * 16 : gray * 8;
+		params.color = red != 128 || green != 128 || blue != 128;
+		params.red = red;
+		params.green = green;
+		params.blue = blue;
+		params.skip_transparent = skip_transparent;
+		return params;
+	}
+
+	void CompareKernels() {
+		BitmapKernels::ToneFunc const scalar = BitmapKernels::GetToneKernel(BitmapKernels::Kernel_Scalar);
+		std::vector<uint32_t> const input = RandomPixels(1027);
+
+		int const values[] = { 0, 1, 63, 127, 128, 129, 200, 254, 255 };
+		int const shifts[][4] = { { 16, 8, 0, 24 }, { 0, 8, 16, 24 }, { 24, 16, 8, 0 } };
+
+		for (int k = BitmapKernels::Kernel_Scalar + 1; k < BitmapKernels::Kernel_Count; ++k) {
+			BitmapKernels::ToneFunc const kernel = BitmapKernels::GetToneKernel(static_cast<BitmapKernels::Kernel>(k));
+			if (!kernel) {
+				continue;
+			}
+
+			for (int gray : values) {
+				for (int color : values) {
+					for (auto const& shift : shifts) {
+						BitmapKernels::ToneParams params = MakeParams(gray, color, 255 - color, (color + 64) & 0xFF, gray % 2 == 0);
+						params.r_shift = shift[0];
+						params.g_shift = shift[1];
+						params.b_shift = shift[2];
+						params.a_shift = shift[3];
+
+						std::vector<uint32_t> expected = input;
+						std::vector<uint32_t> result = input;
+
+						// Unaligned start and a width that leaves a remainder
+						scalar(&expected[1], expected.size() - 1, params);
+						kernel(&result[1], result.size() - 1, params);
+
+						assert(result == expected);
+					}
+				}
+			}
+		}
+	}
+
+	void ToneBlitSubRect() {
+		DynamicFormat const format(32,8,16,8,8,8,0,8,24,PF::Alpha);
+		Bitmap::SetFormat(format);
+
+		// Rows are longer than the bitmap
+		int const width = 37;
+		int const height = 20;
+		int const stride = width + 3;
+
+		std::vector<uint32_t> pixels = RandomPixels(stride * height);
+		std::vector<uint32_t> expected = pixels;
+
+		BitmapRef bitmap = Bitmap::Create(&pixels.front(), width, height, stride * 4, format);
+
+		Rect const rect(5, 3, 19, 11);
+		bitmap->ToneBlit(rect.x, rect.y, *bitmap, rect, Tone(200, 50, 128, 30), Opacity::opaque);
+
+		BitmapKernels::ToneParams const params = MakeParams(30, 200, 50, 128, false);
+		for (int y = rect.y; y < rect.y + rect.height; ++y) {
+			BitmapKernels::GetToneKernel(BitmapKernels::Kernel_Scalar)(&expected[y * stride + rect.x], rect.width, params);
+		}
+
+		assert(pixels == expected);
+	}
+}
+
+extern "C" int main(int, char**) {
+	CompareKernels();
+	ToneBlitSubRect();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <vector>
+#include "drawable.h"
+#include "drawable_list.h"
+
+namespace {
+	class TestDrawable : public Drawable {
+	public:
+		void Draw() override {}
+		int GetZ() const override { return z; }
+		DrawableType GetType() const override { return TypeDefault; }
+
+		void SetZ(int nz, DrawableList* list) {
+			if (z != nz && list) DrawableList::UpdateZ(this);
+			z = nz;
+		}
+
+		int z = 0;
+	};
+
+	const int sprite_count = 2000;
+	const int frame_count = 600;
+
+	// Walking characters: every fourth sprite changes Z each frame
+	void MoveSprites(std::vector<TestDrawable>& sprites, int frame, DrawableList* list) {
+		for (size_t i = frame % 4; i < sprites.size(); i += 4) {
+			sprites[i].SetZ(rand() % 480, list);
+		}
+	}
+
+	void CheckOrder(DrawableList const& list, size_t size) {
+		size_t count = 0;
+		int z = -1;
+		for (Drawable* drawable : list) {
+			assert(drawable->GetZ() >= z);
+			z = drawable->GetZ();
+			++count;
+		}
+		assert(count == size);
+		assert(list.GetSize() == size);
+	}
+
+	void Ordering() {
+		std::vector<TestDrawable> sprites(sprite_count);
+		DrawableList list;
+
+		for (TestDrawable& sprite : sprites) {
+			sprite.z = rand() % 480;
+			list.Append(&sprite);
+		}
+		list.Sort();
+		CheckOrder(list, sprites.size());
+
+		for (int frame = 0; frame < 10; ++frame) {
+			MoveSprites(sprites, frame, &list);
+			list.Sort();
+			CheckOrder(list, sprites.size());
+		}
+
+		// Same Z keeps the registration order
+		std::vector<TestDrawable> same(3);
+		DrawableList same_list;
+		for (TestDrawable& sprite : same) {
+			same_list.Append(&sprite);
+		}
+		same_list.Sort();
+		size_t index = 0;
+		for (Drawable* drawable : same_list) {
+			assert(drawable == &same[index++]);
+		}
+
+		// Removal and removal of unregistered drawables
+		for (size_t i = 0; i < sprites.size(); i += 2) {
+			DrawableList::Remove(&sprites[i]);
+			DrawableList::Remove(&sprites[i]);
+		}
+		CheckOrder(list, sprites.size() / 2);
+		list.Sort();
+		CheckOrder(list, sprites.size() / 2);
+	}
+
+	void TieOrder() {
+		// A Z change keeps the place among drawables that share the new Z
+		std::vector<TestDrawable> row(3);
+		DrawableList row_list;
+		row[2].z = 1;
+		for (TestDrawable& sprite : row) {
+			row_list.Append(&sprite);
+		}
+		row_list.Sort();
+		row[1].SetZ(1, &row_list);
+		row_list.Sort();
+		const TestDrawable* expected[] = { &row[0], &row[1], &row[2] };
+		size_t index = 0;
+		for (Drawable* drawable : row_list) {
+			assert(drawable == expected[index++]);
+		}
+
+		// Matches a stable sort of the whole list with many equal Z
+		std::vector<TestDrawable> sprites(200);
+		std::list<Drawable*> reference;
+		DrawableList list;
+		for (TestDrawable& sprite : sprites) {
+			sprite.z = rand() % 4;
+			reference.push_back(&sprite);
+			list.Append(&sprite);
+		}
+
+		for (int frame = 0; frame < 50; ++frame) {
+			for (size_t i = frame % 3; i < sprites.size(); i += 3) {
+				sprites[i].SetZ(rand() % 4, &list);
+			}
+			list.Sort();
+			reference.sort([](const Drawable* first, const Drawable* second) {
+				return first->GetZ() < second->GetZ();
+			});
+
+			std::list<Drawable*>::const_iterator it = reference.begin();
+			for (Drawable* drawable : list) {
+				assert(drawable == *it++);
+			}
+		}
+	}
+
+	void Benchmark() {
+		std::vector<TestDrawable> sprites(sprite_count);
+		for (TestDrawable& sprite : sprites) {
+			sprite.z = rand() % 480;
+		}
+
+		// Previous implementation: std::list sorted on every Z change
+		std::list<Drawable*> old_list;
+		for (TestDrawable& sprite : sprites) {
+			old_list.push_back(&sprite);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frame_count; ++frame) {
+			MoveSprites(sprites, frame, NULL);
+			old_list.sort([](const Drawable* first, const Drawable* second) {
+				return first->GetZ() < second->GetZ();
+			});
+		}
+		double old_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		DrawableList list;
+		for (TestDrawable& sprite : sprites) {
+			list.Append(&sprite);
+		}
+
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frame_count; ++frame) {
+			MoveSprites(sprites, frame, &list);
+			list.Sort();
+		}
+		double new_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		CheckOrder(list, sprites.size());
+
+		printf("%d sprites, %d frames: std::list sort %.2f ms, DrawableList %.2f ms\n",
+			sprite_count, frame_count, old_time, new_time);
+	}
+}
+
+extern "C" int main(int, char**) {
+	Ordering();
+	TieOrder();
+	Benchmark();
+
+	return EXIT_SUCCESS;
+}
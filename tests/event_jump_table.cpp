@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include "command_codes.h"
+#include "event_jump_table.h"
+
+namespace {
+	typedef std::vector<RPG::EventCommand> List;
+
+	const int codes[] = {
+		Cmd::ShowMessage, Cmd::ConditionalBranch, Cmd::ElseBranch, Cmd::EndBranch,
+		Cmd::Loop, Cmd::BreakLoop, Cmd::EndLoop, Cmd::Label, Cmd::JumpToLabel
+	};
+
+	// Random nesting, not necessarily well formed
+	List MakeList(int size) {
+		List list(size);
+		int indent = 0;
+		for (RPG::EventCommand& com : list) {
+			indent = std::max(0, indent + rand() % 3 - 1);
+			com.indent = indent;
+			com.code = codes[rand() % (sizeof(codes) / sizeof(codes[0]))];
+			com.parameters.push_back(rand() % 4);
+		}
+		return list;
+	}
+
+	// Linear searches of the interpreter
+	int ScanFind(const List& list, int index, int code, int code2, int min_indent, int max_indent) {
+		int idx;
+		for (idx = index; (size_t) idx < list.size(); idx++) {
+			if (list[idx].indent < min_indent)
+				return -1;
+			if (list[idx].indent > max_indent)
+				continue;
+			if (list[idx].code != code && list[idx].code != code2)
+				continue;
+			return idx;
+		}
+		return idx;
+	}
+
+	int ScanLoopStart(const List& list, int index) {
+		int indent = list[index].indent;
+		for (int idx = index; idx >= 0; idx--) {
+			if (list[idx].indent > indent)
+				continue;
+			if (list[idx].indent < indent)
+				return -1;
+			if (list[idx].code != Cmd::Loop)
+				continue;
+			return idx;
+		}
+		return list.size();
+	}
+
+	int ScanLabel(const List& list, int label_id) {
+		for (int idx = 0; (size_t) idx < list.size(); idx++) {
+			if (list[idx].code == Cmd::Label && list[idx].parameters[0] == label_id)
+				return idx;
+		}
+		return -1;
+	}
+}
+
+int main() {
+	for (int round = 0; round < 200; ++round) {
+		List list = MakeList(1 + rand() % 200);
+		EventJumpTable table(list);
+		int size = list.size();
+
+		for (int i = 0; i < size; ++i) {
+			int indent = list[i].indent;
+			assert(table.Find(i, Cmd::ElseBranch, Cmd::EndBranch, indent) ==
+				ScanFind(list, i, Cmd::ElseBranch, Cmd::EndBranch, indent, indent));
+			assert(table.Find(i, Cmd::EndBranch, Cmd::EndBranch, indent) ==
+				ScanFind(list, i, Cmd::EndBranch, Cmd::EndBranch, indent, indent));
+			assert(table.Find(i, Cmd::Label, Cmd::Label, indent + 1) ==
+				ScanFind(list, i, Cmd::Label, Cmd::Label, indent + 1, indent + 1));
+
+			if (list[i].code == Cmd::EndLoop) {
+				assert(table.GetLoopStart(i) == ScanLoopStart(list, i));
+			}
+			if (list[i].code == Cmd::BreakLoop) {
+				assert(table.GetLoopBreak(i) ==
+					ScanFind(list, i, Cmd::EndLoop, Cmd::EndLoop, 0, indent - 1));
+			}
+		}
+
+		for (int label_id = 0; label_id < 4; ++label_id) {
+			assert(table.GetLabel(label_id) == ScanLabel(list, label_id));
+		}
+	}
+
+	return EXIT_SUCCESS;
+}